@@ -0,0 +1,94 @@
+#ifndef DISK_AIO_H
+#define DISK_AIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "disk_io.h"
+
+// 默认队列深度（同时在途的读取请求数）
+#define DISK_AIO_DEFAULT_DEPTH 8
+// 最大队列深度
+#define DISK_AIO_MAX_DEPTH 256
+
+// 异步读取完成事件
+typedef struct {
+    uint32_t slot;            // 缓冲区槽位
+    uint64_t offset;          // 读取偏移
+    ssize_t result;           // 实际读取的字节数，失败为 -1
+    const uint8_t* data;      // 数据起始位置（直接 I/O 下可能位于槽位缓冲区内部）
+    void* user_data;          // 提交时附带的用户数据
+} disk_aio_event_t;
+
+// 异步读取引擎（不透明类型，每个实例只能由一个线程使用）
+typedef struct disk_aio disk_aio_t;
+
+/**
+ * 创建异步读取引擎
+ * 在 Linux 上优先使用 io_uring（注册缓冲区 + 固定缓冲区读取），
+ * 不可用时退化为基于 disk_read() 的同步实现，接口行为保持一致。
+ * @param handle 磁盘句柄
+ * @param queue_depth 队列深度（0 表示默认值），同时也是缓冲区槽位数
+ * @param buffer_size 每个槽位的缓冲区大小（字节）
+ * @return 引擎指针，失败返回 NULL
+ */
+disk_aio_t* disk_aio_create(disk_handle_t* handle, uint32_t queue_depth, size_t buffer_size);
+
+/**
+ * 销毁异步读取引擎（会先等待所有在途请求完成）
+ * @param aio 引擎指针
+ */
+void disk_aio_destroy(disk_aio_t* aio);
+
+/**
+ * 获取槽位对应的缓冲区
+ * 直接 I/O 模式下请求会扩展到扇区边界，读取结果应以完成事件中的 data 为准。
+ * @param aio 引擎指针
+ * @param slot 槽位编号
+ * @return 缓冲区指针，槽位无效返回 NULL
+ */
+uint8_t* disk_aio_buffer(disk_aio_t* aio, uint32_t slot);
+
+/**
+ * 获取队列深度（槽位数）
+ * @param aio 引擎指针
+ * @return 队列深度
+ */
+uint32_t disk_aio_depth(const disk_aio_t* aio);
+
+/**
+ * 提交一个读取请求到指定槽位
+ * 槽位由调用者管理：在该槽位的完成事件被取走之前不能再次提交。
+ * @param aio 引擎指针
+ * @param slot 槽位编号
+ * @param offset 偏移量（字节）
+ * @param size 读取大小（不超过槽位缓冲区大小）
+ * @param user_data 用户数据，原样返回到完成事件中
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_aio_submit(disk_aio_t* aio, uint32_t slot, uint64_t offset,
+                    size_t size, void* user_data);
+
+/**
+ * 等待一个读取请求完成（完成顺序不保证与提交顺序一致）
+ * @param aio 引擎指针
+ * @param event 完成事件（输出）
+ * @return 成功返回 0，没有在途请求或出错返回 -1
+ */
+int disk_aio_wait(disk_aio_t* aio, disk_aio_event_t* event);
+
+/**
+ * 获取在途请求数量
+ * @param aio 引擎指针
+ * @return 在途请求数量
+ */
+uint32_t disk_aio_inflight(const disk_aio_t* aio);
+
+/**
+ * 获取后端名称
+ * @param aio 引擎指针
+ * @return "io_uring" 或 "sync"
+ */
+const char* disk_aio_backend_name(const disk_aio_t* aio);
+
+#endif // DISK_AIO_H
@@ -0,0 +1,139 @@
+#ifndef DISK_BADMAP_H
+#define DISK_BADMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 读取出错后的初始跳跃距离
+#define DISK_BADMAP_MIN_SKIP (64 * 1024)          // 64KB
+// 跳跃距离上限
+#define DISK_BADMAP_MAX_SKIP (64 * 1024 * 1024)   // 64MB
+// 自动保存间隔（秒）
+#define DISK_BADMAP_SAVE_INTERVAL 10
+
+// 区间状态（与 ddrescue 映射文件的状态字符一致）
+typedef enum {
+    DISK_BAD_SKIPPED = '?',     // 出错后跳过，尚未重试
+    DISK_BAD_UNREADABLE = '-'   // 重试后仍无法读取的扇区
+} disk_bad_state_t;
+
+// 坏块区间
+typedef struct {
+    uint64_t offset;          // 起始偏移
+    uint64_t length;          // 长度
+    disk_bad_state_t state;   // 状态
+} disk_bad_range_t;
+
+// 坏块图统计信息
+typedef struct {
+    uint64_t ranges;          // 区间数量
+    uint64_t skipped_bytes;   // 跳过待重试的字节数
+    uint64_t unreadable_bytes; // 无法读取的字节数
+    uint64_t read_errors;     // 遇到的读取错误次数
+} disk_badmap_stats_t;
+
+// 坏块图（不透明类型，所有接口线程安全）
+typedef struct disk_badmap disk_badmap_t;
+
+/**
+ * 创建坏块图，文件已存在时加载其中的记录
+ * 文件为文本格式，每行一个区间：偏移 长度 状态（十六进制，状态字符见 disk_bad_state_t）。
+ * @param path 坏块图文件路径（NULL 表示只在内存中记录）
+ * @param device_size 设备大小（字节），超出的记录被截断
+ * @return 坏块图指针，失败返回 NULL
+ */
+disk_badmap_t* disk_badmap_create(const char* path, uint64_t device_size);
+
+/**
+ * 销毁坏块图（有文件路径且有未保存的修改时先保存）
+ * @param map 坏块图指针
+ */
+void disk_badmap_destroy(disk_badmap_t* map);
+
+/**
+ * 将坏块图写入文件（先写临时文件再替换，中途中断不会损坏原文件）
+ * @param map 坏块图指针
+ * @return 成功返回 0，失败或没有文件路径返回 -1
+ */
+int disk_badmap_save(disk_badmap_t* map);
+
+/**
+ * 将区间标记为指定状态（覆盖重叠部分的原有状态）
+ * @param map 坏块图指针
+ * @param offset 起始偏移
+ * @param length 长度
+ * @param state 状态
+ */
+void disk_badmap_mark(disk_badmap_t* map, uint64_t offset, uint64_t length,
+                      disk_bad_state_t state);
+
+/**
+ * 清除区间内的记录（区间已成功读取）
+ * @param map 坏块图指针
+ * @param offset 起始偏移
+ * @param length 长度
+ */
+void disk_badmap_clear(disk_badmap_t* map, uint64_t offset, uint64_t length);
+
+/**
+ * 查找与 [offset, end) 相交的第一个区间
+ * @param map 坏块图指针
+ * @param offset 起始偏移
+ * @param end 结束偏移
+ * @param range 找到的区间（输出）
+ * @return 找到返回 1，否则返回 0
+ */
+int disk_badmap_lookup(disk_badmap_t* map, uint64_t offset, uint64_t end,
+                       disk_bad_range_t* range);
+
+/**
+ * 收集 [start, end) 内指定状态的区间（截断到范围内）
+ * @param map 坏块图指针
+ * @param start 起始偏移
+ * @param end 结束偏移
+ * @param state 状态
+ * @param ranges 区间数组（输出，由调用者 free() 释放）
+ * @param count 区间数量（输出）
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_badmap_collect(disk_badmap_t* map, uint64_t start, uint64_t end,
+                        disk_bad_state_t state, disk_bad_range_t** ranges, size_t* count);
+
+/**
+ * 统计 [offset, offset + size) 内被记录（跳过或无法读取）的字节数
+ * @param map 坏块图指针
+ * @param offset 起始偏移
+ * @param size 长度
+ * @return 字节数
+ */
+uint64_t disk_badmap_count(disk_badmap_t* map, uint64_t offset, uint64_t size);
+
+/**
+ * 记录一次读取错误并返回本次应跳过的距离
+ * 连续出错时跳跃距离按指数增长（上限 DISK_BADMAP_MAX_SKIP），读取成功后恢复初始值。
+ * @param map 坏块图指针
+ * @return 跳跃距离（字节）
+ */
+uint64_t disk_badmap_next_skip(disk_badmap_t* map);
+
+/**
+ * 记录一次成功读取，跳跃距离恢复初始值
+ * @param map 坏块图指针
+ */
+void disk_badmap_reset_skip(disk_badmap_t* map);
+
+/**
+ * 获取坏块图统计信息
+ * @param map 坏块图指针
+ * @param stats 统计信息（输出）
+ */
+void disk_badmap_get_stats(disk_badmap_t* map, disk_badmap_stats_t* stats);
+
+/**
+ * 获取坏块图文件路径
+ * @param map 坏块图指针
+ * @return 文件路径，只在内存中记录时返回 NULL
+ */
+const char* disk_badmap_path(const disk_badmap_t* map);
+
+#endif // DISK_BADMAP_H
@@ -0,0 +1,82 @@
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 默认缓存块大小
+#define DISK_CACHE_BLOCK_SIZE (64 * 1024)      // 64KB
+// 默认缓存容量
+#define DISK_CACHE_DEFAULT_CAPACITY (64 * 1024 * 1024)  // 64MB
+// 默认分片数
+#define DISK_CACHE_DEFAULT_SHARDS 16
+
+// 缓存统计信息
+typedef struct {
+    uint64_t hits;            // 命中次数
+    uint64_t misses;          // 未命中次数
+    uint64_t insertions;      // 插入次数
+    uint64_t evictions;       // 淘汰次数
+} disk_cache_stats_t;
+
+// 分片 LRU 块缓存（不透明类型，所有接口线程安全）
+typedef struct disk_cache disk_cache_t;
+
+/**
+ * 创建块缓存
+ * @param block_size 缓存块大小（字节），缓存以 offset / block_size 作为键
+ * @param capacity 缓存总容量（字节）
+ * @param shards 分片数量（0 表示默认值），每个分片独立加锁
+ * @return 缓存指针，失败返回 NULL
+ */
+disk_cache_t* disk_cache_create(size_t block_size, size_t capacity, uint32_t shards);
+
+/**
+ * 销毁块缓存
+ * @param cache 缓存指针
+ */
+void disk_cache_destroy(disk_cache_t* cache);
+
+/**
+ * 获取缓存块大小
+ * @param cache 缓存指针
+ * @return 块大小（字节）
+ */
+size_t disk_cache_block_size(const disk_cache_t* cache);
+
+/**
+ * 查找缓存块，命中时复制其中一段数据
+ * @param cache 缓存指针
+ * @param block 块号
+ * @param skip 块内起始位置
+ * @param buffer 输出缓冲区
+ * @param size 最多复制的字节数
+ * @return 命中返回实际复制的字节数（块在设备末尾时可能不足），未命中返回 -1
+ */
+long disk_cache_lookup(disk_cache_t* cache, uint64_t block, size_t skip,
+                       void* buffer, size_t size);
+
+/**
+ * 插入（或刷新）缓存块
+ * @param cache 缓存指针
+ * @param block 块号
+ * @param data 块数据
+ * @param size 数据长度（不超过块大小，仅设备末尾的块允许不足）
+ */
+void disk_cache_insert(disk_cache_t* cache, uint64_t block, const void* data, size_t size);
+
+/**
+ * 使缓存块失效（块内数据在磁盘层被重新读取后调用）
+ * @param cache 缓存指针
+ * @param block 块号
+ */
+void disk_cache_invalidate(disk_cache_t* cache, uint64_t block);
+
+/**
+ * 获取缓存统计信息
+ * @param cache 缓存指针
+ * @param stats 统计信息（输出）
+ */
+void disk_cache_get_stats(disk_cache_t* cache, disk_cache_stats_t* stats);
+
+#endif // DISK_CACHE_H
@@ -3,23 +3,95 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <limits.h>
 #include <sys/types.h>
+#include "disk_cache.h"
+#include "disk_throttle.h"
+#include "disk_badmap.h"
+
+// 严格 C 标准模式下 <limits.h> 不定义 PATH_MAX
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+/*
+ * 并发约定
+ *
+ * disk_handle_t 在 disk_open() 返回后即可被多个线程共享：
+ * - 所有读取都是定位读取（pread 或映射区复制），句柄中不存在共享的文件游标，
+ *   disk_read()、disk_read_sectors()、disk_map_range()、disk_advise() 可并发调用；
+ * - 句柄字段（fd、分段表、size、扇区大小、映射基址等）在打开后只读；
+ * - disk_buffer_alloc()/disk_buffer_free() 及块缓存内部加锁，可并发调用；
+ * - disk_set_cache()/disk_set_throttle()/disk_set_rescue() 会替换句柄的对应组件，只能在共享句柄之前调用；
+ * - disk_close() 必须在所有线程停止使用句柄之后调用。
+ * 基于句柄创建的 disk_aio_t 不可跨线程共享，每个线程应使用自己的实例。
+ */
+
+// 打开标志
+#define DISK_OPEN_DEFAULT  0x00    // 默认：磁盘镜像文件使用内存映射
+#define DISK_OPEN_NO_MMAP  0x01    // 禁用内存映射，始终使用 read()
+#define DISK_OPEN_DIRECT   0x02    // 绕过页缓存（O_DIRECT），读取按物理扇区对齐
+#define DISK_OPEN_NO_CACHE 0x04    // 不创建块缓存
+
+// 访问模式建议（映射模式下转换为 madvise）
+typedef enum {
+    DISK_ADVICE_NORMAL = 0,   // 默认
+    DISK_ADVICE_SEQUENTIAL,   // 顺序访问
+    DISK_ADVICE_WILLNEED,     // 即将访问，提前预读
+    DISK_ADVICE_DONTNEED      // 不再访问，可释放映射页
+} disk_advice_t;
+
+// 磁盘区间
+typedef struct {
+    uint64_t offset;          // 起始偏移
+    uint64_t length;          // 长度
+} disk_extent_t;
+
+// 磁盘分段：普通设备只有一个分段，分卷镜像（.001/.002、.aa/.ab）每个文件一个分段
+typedef struct {
+    int fd;                   // 分段文件描述符
+    uint64_t offset;          // 分段在虚拟设备中的起始偏移
+    uint64_t size;            // 分段大小
+    char path[PATH_MAX];      // 分段路径（以直接 I/O 方式重新打开时使用）
+} disk_segment_t;
+
+// 对齐缓冲区池（不透明类型）
+typedef struct disk_buffer_pool disk_buffer_pool_t;
 
 // 磁盘句柄结构
 typedef struct {
-    int fd;                    // 文件描述符
-    uint64_t size;            // 磁盘大小（字节）
-    uint32_t sector_size;     // 扇区大小
-    char device_path[256];    // 设备路径
+    int fd;                    // 文件描述符（分卷镜像为第一个分段）
+    disk_segment_t* segments; // 分段表（按偏移升序，至少一个）
+    uint32_t segment_count;   // 分段数量
+    uint64_t size;            // 磁盘大小（字节，所有分段之和）
+    uint32_t sector_size;     // 扇区大小（逻辑扇区）
+    uint32_t physical_sector_size; // 物理扇区大小
+    uint32_t io_align;        // 直接 I/O 的对齐要求（0 表示无需对齐）
+    char device_path[PATH_MAX]; // 设备路径
+    uint8_t* map_base;        // 内存映射基址（未映射时为 NULL）
+    disk_buffer_pool_t* pool; // 对齐缓冲区池
+    disk_cache_t* cache;      // 小块读取的块缓存（可为 NULL）
+    disk_throttle_t* throttle; // 读取限速器（可为 NULL）
+    disk_badmap_t* badmap;    // 容错读取的坏块图（可为 NULL，表示读取出错时直接失败）
 } disk_handle_t;
 
 /**
  * 打开磁盘设备
+ * 若路径是分卷镜像的第一个分段（如 image.001 或 image.aa）且后续分段存在，
+ * 所有分段按顺序拼接为一个虚拟设备，跨分段的读取自动拆分到各分段。
  * @param device_path 设备路径（如 /dev/sda 或磁盘镜像文件）
  * @return 磁盘句柄指针，失败返回 NULL
  */
 disk_handle_t* disk_open(const char* device_path);
 
+/**
+ * 按指定标志打开磁盘设备
+ * @param device_path 设备路径（如 /dev/sda 或磁盘镜像文件）
+ * @param flags 打开标志（DISK_OPEN_*）
+ * @return 磁盘句柄指针，失败返回 NULL
+ */
+disk_handle_t* disk_open_ex(const char* device_path, uint32_t flags);
+
 /**
  * 关闭磁盘设备
  * @param handle 磁盘句柄
@@ -36,6 +108,134 @@ void disk_close(disk_handle_t* handle);
  */
 ssize_t disk_read(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size);
 
+/**
+ * 从缓冲区池分配对齐的缓冲区（满足句柄的直接 I/O 对齐要求）
+ * 传给 disk_read() 的缓冲区若已对齐，直接 I/O 模式下无需经过中转缓冲区。
+ * @param handle 磁盘句柄
+ * @param size 缓冲区大小（字节）
+ * @return 缓冲区指针，失败返回 NULL
+ */
+void* disk_buffer_alloc(disk_handle_t* handle, size_t size);
+
+/**
+ * 将缓冲区归还到缓冲区池
+ * @param handle 磁盘句柄
+ * @param buffer 由 disk_buffer_alloc() 分配的缓冲区
+ */
+void disk_buffer_free(disk_handle_t* handle, void* buffer);
+
+/**
+ * 设置块缓存容量（替换现有缓存）
+ * 不超过 256KB 的 disk_read() 请求经过缓存，按 64KB 对齐块读取和缓存；
+ * 映射模式下不使用缓存。
+ * @param handle 磁盘句柄
+ * @param capacity 缓存容量（字节），0 表示禁用
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_set_cache(disk_handle_t* handle, size_t capacity);
+
+/**
+ * 将已读取的数据放入块缓存（如扫描器通过异步引擎读取的数据块）
+ * 只有完整覆盖的缓存块会被插入。
+ * @param handle 磁盘句柄
+ * @param offset 数据在磁盘上的偏移
+ * @param data 数据
+ * @param size 数据长度
+ */
+void disk_populate_cache(disk_handle_t* handle, uint64_t offset, const void* data, size_t size);
+
+/**
+ * 获取块缓存统计信息
+ * @param handle 磁盘句柄
+ * @param stats 统计信息（输出）
+ * @return 成功返回 0，句柄没有缓存返回 -1
+ */
+int disk_get_cache_stats(disk_handle_t* handle, disk_cache_stats_t* stats);
+
+/**
+ * 设置读取限速（替换现有限速器）
+ * 每次实际的设备读取（pread、io_uring 请求、映射区访问）都先申请令牌，
+ * 读取延迟明显升高时自动降低速率，设备空闲后逐步恢复到配置值。
+ * @param handle 磁盘句柄
+ * @param bytes_per_sec 带宽上限（字节/秒，0 表示不限）
+ * @param iops 每秒请求数上限（0 表示不限）
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_set_throttle(disk_handle_t* handle, uint64_t bytes_per_sec, uint32_t iops);
+
+/**
+ * 获取限速统计信息
+ * @param handle 磁盘句柄
+ * @param stats 统计信息（输出）
+ * @return 成功返回 0，句柄未限速返回 -1
+ */
+int disk_get_throttle_stats(disk_handle_t* handle, disk_throttle_stats_t* stats);
+
+/**
+ * 启用容错读取（ddrescue 策略），替换现有的坏块图
+ * 读取出错时不再返回 -1：出错位置之后的一段被跳过并填零，连续出错时跳跃距离指数增长，
+ * 跳过的区间记录到坏块图，由 disk_retry_skipped() 稍后重试；已记录的区间不再读取。
+ * 映射模式的读取不经过此路径（磁盘镜像的读取错误表现为 SIGBUS），故障设备上的镜像应配合 DISK_OPEN_NO_MMAP。
+ * @param handle 磁盘句柄
+ * @param map_path 坏块图文件路径（NULL 表示只在内存中记录），文件已存在时加载其中的记录
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_set_rescue(disk_handle_t* handle, const char* map_path);
+
+/**
+ * 重试 [start, end) 内被跳过的区间
+ * 大区间按 1MB 读取，失败时二分缩小范围直到单个扇区，仍无法读取的扇区标记为坏区。
+ * @param handle 磁盘句柄
+ * @param start 起始偏移
+ * @param end 结束偏移
+ * @param recovered 重新读取成功的区间（输出，按偏移升序，由调用者 free() 释放）
+ * @param count 区间数量（输出）
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_retry_skipped(disk_handle_t* handle, uint64_t start, uint64_t end,
+                       disk_extent_t** recovered, size_t* count);
+
+/**
+ * 统计指定范围内无法读取（跳过或坏区，读取时填零）的字节数
+ * @param handle 磁盘句柄
+ * @param offset 偏移量（字节）
+ * @param size 范围大小（字节）
+ * @return 字节数，未启用容错读取时返回 0
+ */
+uint64_t disk_unreadable_bytes(disk_handle_t* handle, uint64_t offset, uint64_t size);
+
+/**
+ * 获取容错读取统计信息
+ * @param handle 磁盘句柄
+ * @param stats 统计信息（输出）
+ * @return 成功返回 0，未启用容错读取返回 -1
+ */
+int disk_get_rescue_stats(disk_handle_t* handle, disk_badmap_stats_t* stats);
+
+/**
+ * 获取指定范围内包含数据的区间（稀疏镜像中的空洞被排除）
+ * 对普通文件使用 SEEK_DATA/SEEK_HOLE 查询；块设备或不支持的文件系统返回覆盖整个范围的单个区间。
+ * @param handle 磁盘句柄
+ * @param start 起始偏移
+ * @param end 结束偏移（超出设备大小时截断）
+ * @param extents 区间数组（输出，按偏移升序，由调用者 free() 释放）
+ * @param count 区间数量（输出）
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_get_data_extents(disk_handle_t* handle, uint64_t start, uint64_t end,
+                          disk_extent_t** extents, size_t* count);
+
+/**
+ * 定位包含指定偏移的分段（供需要直接向文件描述符提交请求的模块使用）
+ * @param handle 磁盘句柄
+ * @param offset 设备偏移
+ * @param local_offset 分段内偏移（输出）
+ * @param remaining 从该偏移到分段末尾的字节数（输出，可为 NULL）
+ * @return 分段文件描述符，偏移越界返回 -1
+ */
+int disk_segment_at(const disk_handle_t* handle, uint64_t offset,
+                    uint64_t* local_offset, uint64_t* remaining);
+
 /**
  * 读取指定扇区
  * @param handle 磁盘句柄
@@ -53,5 +253,33 @@ ssize_t disk_read_sectors(disk_handle_t* handle, uint64_t sector, uint32_t count
  */
 uint64_t disk_get_size(disk_handle_t* handle);
 
+/**
+ * 检查句柄是否处于内存映射模式
+ * @param handle 磁盘句柄
+ * @return 映射模式返回 1，否则返回 0
+ */
+int disk_is_mapped(const disk_handle_t* handle);
+
+/**
+ * 获取指向映射数据的只读指针（零拷贝）
+ * @param handle 磁盘句柄
+ * @param offset 偏移量（字节）
+ * @param size 请求大小（字节）
+ * @param mapped_size 实际可用的字节数（输出，可为 NULL），超出设备末尾的部分被截断
+ * @return 数据指针，句柄未映射或偏移越界返回 NULL
+ */
+const uint8_t* disk_map_range(disk_handle_t* handle, uint64_t offset, size_t size,
+                              size_t* mapped_size);
+
+/**
+ * 对指定区域给出访问模式建议（非映射模式下转换为 posix_fadvise）
+ * @param handle 磁盘句柄
+ * @param offset 偏移量（字节）
+ * @param size 区域大小（字节）
+ * @param advice 访问模式建议
+ * @return 成功返回 0，失败返回 -1
+ */
+int disk_advise(disk_handle_t* handle, uint64_t offset, uint64_t size, disk_advice_t advice);
+
 #endif // DISK_IO_H
 
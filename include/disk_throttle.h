@@ -0,0 +1,71 @@
+#ifndef DISK_THROTTLE_H
+#define DISK_THROTTLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 令牌桶容量（按当前速率折算的突发时长）
+#define DISK_THROTTLE_BURST_MS 100
+// 自适应调整周期
+#define DISK_THROTTLE_WINDOW_MS 100
+// 平滑延迟超过基准延迟的倍数时视为设备繁忙
+#define DISK_THROTTLE_CONTENTION_FACTOR 3
+// 自适应系数下限
+#define DISK_THROTTLE_MIN_SCALE 0.05
+
+// 限速统计信息
+typedef struct {
+    uint64_t bytes_per_sec;   // 配置的带宽上限（0 表示不限）
+    uint32_t iops;            // 配置的 IOPS 上限（0 表示不限）
+    double scale;             // 当前自适应系数（0-1，实际上限 = 配置值 * 系数）
+    uint64_t bytes;           // 已放行的字节数
+    uint64_t ops;             // 已放行的请求数
+    uint64_t waits;           // 因令牌不足而等待的次数
+    uint64_t wait_ns;         // 累计等待时间（纳秒）
+    uint64_t backoffs;        // 因延迟升高而降速的次数
+    uint64_t latency_us;      // 平滑后的读取延迟（按 64KB 折算，微秒）
+    uint64_t baseline_us;     // 基准读取延迟（微秒）
+} disk_throttle_stats_t;
+
+// 读取限速器（不透明类型，所有接口线程安全）
+typedef struct disk_throttle disk_throttle_t;
+
+/**
+ * 创建读取限速器
+ * 带宽和 IOPS 各使用一个令牌桶；单个请求可以透支令牌，之后的请求等待令牌补足。
+ * 观察到的读取延迟明显高于基准时按乘性减小速率，恢复后按加性逐步回升（AIMD）。
+ * @param bytes_per_sec 带宽上限（字节/秒，0 表示不限）
+ * @param iops 每秒请求数上限（0 表示不限）
+ * @return 限速器指针，两项都为 0 或失败时返回 NULL
+ */
+disk_throttle_t* disk_throttle_create(uint64_t bytes_per_sec, uint32_t iops);
+
+/**
+ * 销毁读取限速器
+ * @param throttle 限速器指针
+ */
+void disk_throttle_destroy(disk_throttle_t* throttle);
+
+/**
+ * 为一次读取请求申请令牌（令牌不足时阻塞），throttle 为 NULL 时立即返回
+ * @param throttle 限速器指针
+ * @param bytes 请求大小（字节）
+ */
+void disk_throttle_acquire(disk_throttle_t* throttle, size_t bytes);
+
+/**
+ * 报告一次读取请求的完成延迟，用于自适应调整速率
+ * @param throttle 限速器指针
+ * @param bytes 请求大小（字节）
+ * @param latency_ns 从提交到完成的时间（纳秒）
+ */
+void disk_throttle_record(disk_throttle_t* throttle, size_t bytes, uint64_t latency_ns);
+
+/**
+ * 获取限速统计信息
+ * @param throttle 限速器指针
+ * @param stats 统计信息（输出）
+ */
+void disk_throttle_get_stats(disk_throttle_t* throttle, disk_throttle_stats_t* stats);
+
+#endif // DISK_THROTTLE_H
@@ -29,6 +29,9 @@ typedef struct {
     fs_type_t fs_type;        // 文件系统类型
 } file_entry_t;
 
+// 已删除文件的回调函数类型（返回非 0 时停止扫描）
+typedef int (*fs_entry_callback_t)(const file_entry_t* entry, void* user_data);
+
 // 文件系统信息
 typedef struct {
     fs_type_t type;           // 文件系统类型
@@ -57,15 +60,15 @@ fs_type_t fs_detect_type(disk_handle_t* handle);
 int fs_parse_info(disk_handle_t* handle, fs_info_t* info);
 
 /**
- * 扫描已删除的文件
+ * 扫描已删除的文件，每找到一个调用一次回调
  * @param handle 磁盘句柄
  * @param info 文件系统信息
- * @param entries 文件条目数组（输出）
- * @param max_entries 最大条目数
+ * @param callback 回调函数
+ * @param user_data 传给回调的用户数据
  * @return 实际找到的文件数量
  */
 int fs_scan_deleted_files(disk_handle_t* handle, const fs_info_t* info, 
-                         file_entry_t* entries, int max_entries);
+                         fs_entry_callback_t callback, void* user_data);
 
 /**
  * 获取文件系统类型名称
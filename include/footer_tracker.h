@@ -0,0 +1,104 @@
+#ifndef FOOTER_TRACKER_H
+#define FOOTER_TRACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "signature.h"
+
+// 文件尾标记的一次出现
+typedef struct {
+    uint64_t offset;          // 标记在磁盘上的偏移
+    uint64_t end;             // 按标记计算的文件结束偏移（含固定字节数和长度字段）
+    uint32_t pattern;         // 标记编号
+} footer_hit_t;
+
+// 等待文件尾标记的候选文件
+typedef struct {
+    uint64_t offset;          // 文件起始偏移
+    uint64_t from;            // 标记可能出现的磁盘偏移范围 [from, to]（与默认文件尾搜索相同）
+    uint64_t to;
+    uint64_t default_size;    // 范围内没有标记时的文件大小
+    uint32_t pattern;         // 标记编号
+    const file_type_info_t* info;
+} footer_candidate_t;
+
+// 文件尾跟踪器（不透明类型，创建后只读，可在多个线程中共用）：
+// 扫描器顺序读取数据时顺便找出所有文件尾标记，候选文件的大小由之后出现的标记确定，
+// 不必为每个候选文件单独向后读取
+typedef struct footer_tracker footer_tracker_t;
+
+/**
+ * 创建文件尾跟踪器：收集签名数据库中各类型的文件尾标记，编译为一个匹配器
+ * @param signatures 签名数组（决定类型编号范围）
+ * @param count 签名数量
+ * @return 跟踪器指针，没有任何类型有文件尾标记或失败时返回 NULL
+ */
+footer_tracker_t* footer_tracker_create(const file_signature_t* signatures, size_t count);
+
+/**
+ * 销毁文件尾跟踪器
+ * @param tracker 跟踪器指针
+ */
+void footer_tracker_destroy(footer_tracker_t* tracker);
+
+/**
+ * 获取识别标记需要的最大字节数（数据块之间至少重叠这么多字节减一）
+ * @param tracker 跟踪器指针
+ * @return 字节数
+ */
+size_t footer_tracker_max_need(const footer_tracker_t* tracker);
+
+/**
+ * 为候选文件建立文件尾等待项（签名使用默认的文件尾搜索且类型有文件尾标记时）
+ * @param tracker 跟踪器指针
+ * @param signature 匹配的签名
+ * @param type 分类后的文件类型
+ * @param offset 文件起始偏移
+ * @param candidate 等待项（输出）
+ * @return 可以跟踪返回 1，否则返回 0（改用签名的文件尾搜索）
+ */
+int footer_tracker_open(const footer_tracker_t* tracker, const file_signature_t* signature,
+                        file_type_t type, uint64_t offset, footer_candidate_t* candidate);
+
+/**
+ * 找出数据块中起始位置在 [0, size) 内的所有文件尾标记，按偏移顺序追加到 hits
+ * 标记之后的长度字段超出 available 时用 read 读取，读不全的标记丢弃。
+ * @param tracker 跟踪器指针
+ * @param data 数据块
+ * @param size 数据块大小
+ * @param available 可用的字节数（含下一数据块开头的重叠部分）
+ * @param offset 数据块在磁盘上的偏移
+ * @param read 读取函数（偏移为磁盘偏移）
+ * @param source 传给 read 的数据源
+ * @param hits 标记数组（按需扩大）
+ * @param count 标记数量
+ * @param capacity 数组容量
+ * @return 成功返回 0，失败返回 -1
+ */
+int footer_tracker_scan(const footer_tracker_t* tracker, const uint8_t* data, size_t size,
+                        size_t available, uint64_t offset, signature_read_fn read, void* source,
+                        footer_hit_t** hits, size_t* count, size_t* capacity);
+
+/**
+ * 在按偏移排列的标记中查找候选文件的第一个文件尾标记
+ * @param candidate 等待项
+ * @param hits 标记数组
+ * @param count 标记数量
+ * @param size 文件大小（输出）
+ * @return 找到返回 0，没有找到返回 -1
+ */
+int footer_tracker_match(const footer_candidate_t* candidate, const footer_hit_t* hits, size_t count,
+                         uint64_t* size);
+
+/**
+ * 从磁盘偏移 from 起直接读取查找文件尾标记（顺序扫描没有覆盖的范围），找不到时使用默认大小
+ * @param candidate 等待项
+ * @param source 候选文件（读取偏移相对文件起始）
+ * @param from 开始查找的磁盘偏移
+ * @param size 文件大小（输出）
+ * @return 找到标记返回 0，使用默认大小返回 -1
+ */
+int footer_tracker_search(const footer_candidate_t* candidate, const signature_candidate_t* source,
+                          uint64_t from, uint64_t* size);
+
+#endif // FOOTER_TRACKER_H
@@ -18,6 +18,7 @@ typedef struct {
     const char* output_dir;   // 输出目录
     uint8_t overwrite;        // 是否覆盖已存在文件
     uint8_t verify;           // 是否验证恢复的文件
+    uint32_t io_depth;        // 异步读取队列深度（0表示默认值）
 } recovery_options_t;
 
 /**
@@ -32,17 +33,15 @@ recovery_status_t recovery_recover_file(disk_handle_t* handle,
                                        const char* output_path);
 
 /**
- * 批量恢复文件
+ * 批量恢复文件（按编号顺序恢复结果存储中的所有结果）
  * @param handle 磁盘句柄
- * @param results 扫描结果数组
- * @param count 结果数量
+ * @param results 结果存储
  * @param options 恢复选项
  * @return 成功恢复的文件数量
  */
-int recovery_recover_batch(disk_handle_t* handle,
-                          const scan_result_t* results,
-                          int count,
-                          const recovery_options_t* options);
+uint64_t recovery_recover_batch(disk_handle_t* handle,
+                               result_sink_t* results,
+                               const recovery_options_t* options);
 
 /**
  * 获取恢复状态描述
@@ -0,0 +1,54 @@
+#ifndef REGION_CLASSIFIER_H
+#define REGION_CLASSIFIER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 分类单元大小（字节），扫描器按这个粒度对数据块分类
+#define REGION_CLASSIFIER_UNIT 4096
+// 高熵区域中仍然检查的文件起始位置的对齐（扇区大小）
+#define REGION_CLASSIFIER_SECTOR 512
+// 默认熵阈值（位/字节）：随机、加密和压缩数据的 4KB 单元通常在 7.93 以上
+#define REGION_CLASSIFIER_DEFAULT_MAX_ENTROPY 7.9
+
+// 区域类别
+typedef enum {
+    REGION_DATA = 0,          // 普通数据，完整检查
+    REGION_FILL,              // 零填充或周期不超过 16 字节的重复模式，不可能包含文件头
+    REGION_RANDOM             // 高熵数据（加密、压缩），只检查扇区对齐的位置
+} region_class_t;
+
+// 区域分类器（不透明类型，创建后只读，可在多个线程中共用）
+typedef struct region_classifier region_classifier_t;
+
+/**
+ * 创建区域分类器
+ * @param max_entropy 熵阈值（位/字节），达到阈值的单元为高熵区域；负数表示默认值，大于 8 表示不按熵分类
+ * @return 分类器指针，失败返回 NULL
+ */
+region_classifier_t* region_classifier_create(double max_entropy);
+
+/**
+ * 销毁区域分类器
+ * @param classifier 分类器指针
+ */
+void region_classifier_destroy(region_classifier_t* classifier);
+
+/**
+ * 对一个单元分类：先用向量比较检查是否为重复模式，再估算字节熵
+ * 不足一个单元的数据只检查重复模式，少于 64 字节时视为普通数据。
+ * @param classifier 分类器指针
+ * @param data 数据
+ * @param size 数据大小（不超过 REGION_CLASSIFIER_UNIT）
+ * @return 区域类别
+ */
+region_class_t region_classify(const region_classifier_t* classifier, const uint8_t* data, size_t size);
+
+/**
+ * 获取重复模式检查使用的指令集
+ * @param classifier 分类器指针
+ * @return "avx2"、"sse2" 或 "scalar"
+ */
+const char* region_classifier_isa(const region_classifier_t* classifier);
+
+#endif // REGION_CLASSIFIER_H
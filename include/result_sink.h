@@ -0,0 +1,79 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "signature.h"
+
+// 每个分块的结果数
+#define RESULT_SINK_CHUNK 4096
+
+// 扫描结果结构
+typedef struct {
+    uint64_t offset;          // 文件在磁盘上的偏移
+    uint64_t size;            // 文件大小（估算）
+    file_type_t type;         // 文件类型
+    uint8_t confidence;       // 置信度（0-100）
+} scan_result_t;
+
+// 扫描结果存储（不透明类型，不是线程安全的）：结果按追加顺序编号，
+// 内存中按固定大小的分块增长（扩容时不复制已有结果）；指定溢出文件时写满的分块
+// 以紧凑的定长记录追加到文件，内存中只保留正在追加的分块和最近读取的一个分块
+typedef struct result_sink result_sink_t;
+
+/**
+ * 创建结果存储
+ * 溢出文件的内容为文件头加每个结果一条 20 字节的记录（偏移、大小、类型、置信度），
+ * 已有的文件被截断，销毁存储后保留。
+ * @param spill_path 溢出文件路径（NULL 表示全部保存在内存中）
+ * @return 结果存储指针，失败返回 NULL
+ */
+result_sink_t* result_sink_create(const char* spill_path);
+
+/**
+ * 销毁结果存储（有溢出文件时先写入剩余的结果）
+ * @param sink 结果存储指针
+ */
+void result_sink_destroy(result_sink_t* sink);
+
+/**
+ * 追加一个结果
+ * @param sink 结果存储指针
+ * @param result 扫描结果
+ * @return 成功返回结果编号，失败返回 -1
+ */
+int64_t result_sink_append(result_sink_t* sink, const scan_result_t* result);
+
+/**
+ * 读取一个结果（结果已溢出到文件时读入所在的整个分块，顺序读取时每个分块只读一次）
+ * @param sink 结果存储指针
+ * @param index 结果编号
+ * @param result 扫描结果（输出）
+ * @return 成功返回 0，失败返回 -1
+ */
+int result_sink_get(result_sink_t* sink, uint64_t index, scan_result_t* result);
+
+/**
+ * 修改一个已追加的结果（结果已溢出到文件时原地改写对应的记录）
+ * @param sink 结果存储指针
+ * @param index 结果编号
+ * @param result 新的扫描结果
+ * @return 成功返回 0，失败返回 -1
+ */
+int result_sink_update(result_sink_t* sink, uint64_t index, const scan_result_t* result);
+
+/**
+ * 获取结果数量
+ * @param sink 结果存储指针
+ * @return 结果数量
+ */
+uint64_t result_sink_count(const result_sink_t* sink);
+
+/**
+ * 把内存中尚未写入的结果追加到溢出文件（之后仍可继续追加）
+ * @param sink 结果存储指针
+ * @return 成功或没有溢出文件返回 0，失败返回 -1
+ */
+int result_sink_flush(result_sink_t* sink);
+
+#endif // RESULT_SINK_H
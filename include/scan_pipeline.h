@@ -0,0 +1,94 @@
+#ifndef SCAN_PIPELINE_H
+#define SCAN_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "disk_io.h"
+
+// 默认预读内存预算
+#define SCAN_PIPELINE_DEFAULT_BUDGET (32 * 1024 * 1024)  // 32MB
+// 最少缓冲区数量（双缓冲）
+#define SCAN_PIPELINE_MIN_BUFFERS 2
+
+// 流水线输出的数据块
+typedef struct {
+    uint64_t offset;          // 数据块在磁盘上的偏移
+    const uint8_t* data;      // 数据（在 scan_pipeline_release() 之前有效）
+    size_t size;              // 有效字节数
+    size_t overlap;           // data[size, size + overlap) 是下一数据块开头的重叠部分
+    uint64_t sequence;        // 顺序号（从 0 开始）
+    uint32_t slot;            // 内部缓冲区槽位
+} scan_pipeline_block_t;
+
+// 流水线统计信息
+typedef struct {
+    uint64_t blocks;          // 已产出的数据块数
+    uint64_t bytes;           // 已产出的字节数
+    uint64_t consumer_waits;  // 消费者等待数据的次数（I/O 跟不上）
+    uint64_t producer_waits;  // 读取线程等待空闲缓冲区的次数（背压）
+} scan_pipeline_stats_t;
+
+// 预读流水线（不透明类型）
+typedef struct scan_pipeline scan_pipeline_t;
+
+/**
+ * 创建预读流水线并启动读取线程
+ * 读取线程在 N 个轮转缓冲区中保持领先于扫描线程；缓冲区全部被占用时读取线程阻塞（背压）。
+ * 非映射句柄通过 disk_aio 保持多个读取请求在途，映射句柄则在读取线程中预取页面。
+ * @param handle 磁盘句柄
+ * @param extents 按偏移升序排列的待读取区间（数据块不跨越区间边界）
+ * @param extent_count 区间数量
+ * @param block_size 数据块大小
+ * @param overlap 每个数据块之后多读取的字节数（跨越数据块边界的魔数因此完整可见，不超过区间末尾）
+ * @param io_depth 在途读取请求数上限（0 表示默认值）
+ * @param memory_budget 缓冲区内存预算（字节，0 表示默认值），决定缓冲区数量 N
+ * @return 流水线指针，失败返回 NULL
+ */
+scan_pipeline_t* scan_pipeline_create(disk_handle_t* handle, const disk_extent_t* extents,
+                                      size_t extent_count, uint32_t block_size, size_t overlap,
+                                      uint32_t io_depth, size_t memory_budget);
+
+/**
+ * 按偏移顺序获取下一个数据块（数据未就绪时阻塞），可由多个线程调用；
+ * 多个数据块可以同时被持有，归还顺序不限
+ * @param pipeline 流水线指针
+ * @param block 数据块（输出）
+ * @return 获取成功返回 1，已到末尾返回 0，读取失败返回 -1
+ */
+int scan_pipeline_next(scan_pipeline_t* pipeline, scan_pipeline_block_t* block);
+
+/**
+ * 归还数据块的缓冲区，使读取线程可以继续预读
+ * @param pipeline 流水线指针
+ * @param block 由 scan_pipeline_next() 获取的数据块
+ */
+void scan_pipeline_release(scan_pipeline_t* pipeline, const scan_pipeline_block_t* block);
+
+/**
+ * 停止读取线程并销毁流水线（允许在未读完时提前调用）
+ * @param pipeline 流水线指针
+ */
+void scan_pipeline_destroy(scan_pipeline_t* pipeline);
+
+/**
+ * 获取流水线统计信息
+ * @param pipeline 流水线指针
+ * @param stats 统计信息（输出）
+ */
+void scan_pipeline_get_stats(scan_pipeline_t* pipeline, scan_pipeline_stats_t* stats);
+
+/**
+ * 获取流水线的 I/O 后端描述
+ * @param pipeline 流水线指针
+ * @return "mmap"、"io_uring" 或 "sync"
+ */
+const char* scan_pipeline_backend(const scan_pipeline_t* pipeline);
+
+/**
+ * 获取缓冲区数量
+ * @param pipeline 流水线指针
+ * @return 缓冲区数量
+ */
+uint32_t scan_pipeline_buffers(const scan_pipeline_t* pipeline);
+
+#endif // SCAN_PIPELINE_H
@@ -4,14 +4,12 @@
 #include <stdint.h>
 #include "disk_io.h"
 #include "signature.h"
+#include "result_sink.h"
 
-// 扫描结果结构
-typedef struct {
-    uint64_t offset;          // 文件在磁盘上的偏移
-    uint64_t size;            // 文件大小（估算）
-    file_type_t type;         // 文件类型
-    uint8_t confidence;       // 置信度（0-100）
-} scan_result_t;
+// 深度扫描工作线程数上限
+#define SCANNER_MAX_THREADS 256
+// 对齐扫描按识别出的文件系统的簇大小对齐（无法识别时按设备的逻辑扇区大小）
+#define SCANNER_ALIGN_AUTO UINT32_MAX
 
 // 扫描回调函数类型
 typedef void (*scan_callback_t)(const scan_result_t* result, void* user_data);
@@ -22,6 +20,20 @@ typedef struct {
     uint64_t end_offset;      // 结束偏移（0表示扫描到末尾）
     uint32_t block_size;      // 扫描块大小
     uint8_t deep_scan;        // 是否深度扫描
+    uint32_t io_depth;        // 异步读取队列深度（0表示默认值）
+    size_t memory_budget;     // 预读缓冲区内存预算（字节，0表示默认值）
+    uint32_t text_min_length; // 文本区间最短长度（0表示默认值）
+    double text_min_entropy;  // 文本区间最低熵（位/字节，负数表示默认值）
+    const file_type_t* include_types; // 只扫描这些类型（NULL 表示全部类型）
+    size_t include_count;
+    const file_type_t* exclude_types; // 不扫描这些类型
+    size_t exclude_count;
+    uint8_t skip_barren;      // 跳过重复模式区域，高熵区域只检查扇区对齐的位置
+    double barren_entropy;    // 高熵区域的熵阈值（位/字节，负数表示默认值）
+    uint32_t threads;         // 深度扫描工作线程数（0 表示 CPU 核数）
+    uint32_t alignment;       // 只检查对齐的文件起始位置（字节，0 表示每个字节，SCANNER_ALIGN_AUTO 表示簇大小）
+    uint64_t alignment_base;  // 对齐的基准偏移（自动对齐时为文件系统数据区起点）
+    uint64_t max_results;     // 结果数上限，达到后停止扫描（0 表示不限）
     scan_callback_t callback; // 进度回调
     void* user_data;          // 用户数据
 } scan_options_t;
@@ -32,34 +44,40 @@ typedef struct {
  */
 int scanner_init(void);
 
+/**
+ * 填充默认扫描选项（整盘深度扫描）
+ * @param options 扫描选项（输出）
+ */
+void scanner_default_options(scan_options_t* options);
+
 /**
  * 扫描磁盘查找可恢复的文件
+ * 数据块由多个工作线程并行匹配，结果按偏移顺序合并并追加到结果存储；回调在合并时按顺序调用，
+ * 不会并发执行。由文件尾标记确定大小的结果先以默认大小占位，扫描读到文件尾（或搜索范围结束）
+ * 后改写并调用回调，因此回调的偏移可能落后于之前的回调。第一遍扫描的结果按偏移排列，
+ * 容错读取重试遍重新读到的区间中的结果追加在之后。
  * @param handle 磁盘句柄
  * @param options 扫描选项
- * @param results 扫描结果数组（输出）
- * @param max_results 最大结果数
- * @return 实际找到的文件数量，失败返回 -1
+ * @param results 结果存储（追加）
+ * @return 本次找到的文件数量，失败返回 -1
  */
-int scanner_scan(disk_handle_t* handle, const scan_options_t* options,
-                scan_result_t* results, int max_results);
+int64_t scanner_scan(disk_handle_t* handle, const scan_options_t* options, result_sink_t* results);
 
 /**
  * 快速扫描（基于文件系统）
  * @param handle 磁盘句柄
- * @param results 扫描结果数组（输出）
- * @param max_results 最大结果数
- * @return 实际找到的文件数量，失败返回 -1
+ * @param results 结果存储（追加）
+ * @return 本次找到的文件数量，失败返回 -1
  */
-int scanner_quick_scan(disk_handle_t* handle, scan_result_t* results, int max_results);
+int64_t scanner_quick_scan(disk_handle_t* handle, result_sink_t* results);
 
 /**
  * 深度扫描（基于文件签名）
  * @param handle 磁盘句柄
- * @param results 扫描结果数组（输出）
- * @param max_results 最大结果数
- * @return 实际找到的文件数量，失败返回 -1
+ * @param results 结果存储（追加）
+ * @return 本次找到的文件数量，失败返回 -1
  */
-int scanner_deep_scan(disk_handle_t* handle, scan_result_t* results, int max_results);
+int64_t scanner_deep_scan(disk_handle_t* handle, result_sink_t* results);
 
 /**
  * 清理扫描器
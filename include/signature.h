@@ -33,6 +33,85 @@ typedef enum {
     FILE_TYPE_MAX
 } file_type_t;
 
+// 签名定义文件中新增的类型从 FILE_TYPE_MAX 开始依次编号
+
+// 没有文件尾标记或找不到时使用的默认文件大小
+#define SIGNATURE_DEFAULT_FILE_SIZE (1024 * 1024)  // 1MB
+
+// 纯文本检测的检查长度
+#define SIGNATURE_TEXT_CHECK_LEN 1024
+
+// 文件类型信息（大小规则）
+// 从文件起始 search_start 字节处开始，在 max_search 字节范围内搜索文件尾标记；
+// 找到时文件结束于标记之后 footer_extra 字节处（有长度字段时再加上该字段的值），
+// 否则使用 default_size
+typedef struct {
+    file_type_t type;        // 文件类型
+    const char* name;        // 类型名（签名定义文件中引用）
+    const uint8_t* footer;   // 文件尾标记（NULL 表示没有）
+    size_t footer_len;       // 文件尾标记长度
+    size_t footer_extra;     // 标记之后的固定字节数
+    int32_t length_field;    // 相对标记的 16 位小端附加长度字段位置（-1 表示没有）
+    uint64_t search_start;   // 开始搜索的位置（相对文件起始）
+    uint64_t max_search;     // 最大搜索范围
+    uint64_t default_size;   // 默认文件大小
+} file_type_info_t;
+
+// 候选文件的文件头长度
+#define SIGNATURE_HEADER_LEN 512
+
+/**
+ * 读取候选文件的数据
+ * @param source 数据源
+ * @param offset 偏移（相对文件起始）
+ * @param buffer 输出缓冲区
+ * @param size 读取大小
+ * @return 读取的字节数（到达设备末尾时可能较少），失败返回 -1
+ */
+typedef int64_t (*signature_read_fn)(void* source, uint64_t offset, void* buffer, size_t size);
+
+// 交给各类型处理函数的候选文件
+typedef struct {
+    const uint8_t* header;    // 从文件起始处读取的数据
+    size_t header_len;        // header 长度（SIGNATURE_HEADER_LEN，到达设备末尾时更短）
+    signature_read_fn read;   // 读取文件的其余数据
+    void* source;             // 传给 read 的数据源
+} signature_candidate_t;
+
+/**
+ * 验证函数：检查魔数之外的文件头结构
+ * @param candidate 候选文件
+ * @return 有效返回 1，无效返回 0（同一位置改用下一个匹配的签名）
+ */
+typedef int (*signature_validate_fn)(const signature_candidate_t* candidate);
+
+/**
+ * 长度解析函数：由文件结构计算文件长度
+ * @param candidate 候选文件
+ * @param length 文件长度（输出）
+ * @return 成功返回 0，无法确定返回 -1（改为搜索文件尾）
+ */
+typedef int (*signature_length_fn)(const signature_candidate_t* candidate, uint64_t* length);
+
+/**
+ * 文件尾搜索函数
+ * @param candidate 候选文件
+ * @param info 文件类型信息（大小规则）
+ * @param length 文件长度（输出）
+ * @return 找到返回 0，没有找到返回 -1（使用默认大小）
+ */
+typedef int (*signature_footer_fn)(const signature_candidate_t* candidate,
+                                   const file_type_info_t* info, uint64_t* length);
+
+/**
+ * 分类函数：魔数相同的一组类型（如 ZIP/DOCX/XLSX/PPTX）按文件内部结构确定具体类型，
+ * 只对验证通过的候选文件调用，读取量有上限
+ * @param candidate 候选文件
+ * @param type 签名的文件类型
+ * @return 具体的文件类型，无法确定时返回能确定的最通用类型
+ */
+typedef file_type_t (*signature_classify_fn)(const signature_candidate_t* candidate, file_type_t type);
+
 // 文件签名结构
 typedef struct {
     file_type_t type;        // 文件类型
@@ -41,13 +120,35 @@ typedef struct {
     size_t magic_len;        // 魔数长度
     size_t offset;           // 魔数在文件中的偏移
     const char* description; // 描述
+    signature_validate_fn validate;      // 验证函数（NULL 表示只比较魔数）
+    signature_length_fn resolve_length;  // 长度解析函数（NULL 表示没有）
+    signature_footer_fn find_footer;     // 文件尾搜索函数（NULL 表示 signature_find_footer）
+    signature_classify_fn classify;      // 分类函数（NULL 表示使用签名的类型）
 } file_signature_t;
 
+// 多模式签名匹配器（不透明类型，接口见 signature_matcher.h）
+typedef struct signature_matcher signature_matcher_t;
+
 /**
  * 初始化文件签名数据库
  */
 void signature_init(void);
 
+/**
+ * 从签名定义文件或编译缓存加载签名数据库，替换内置数据库
+ * 同时指定两者时，缓存与定义文件一致则直接映射缓存，否则编译定义文件并重写缓存；
+ * 只指定缓存时直接映射缓存。
+ * @param path 签名定义文件路径（可为 NULL）
+ * @param cache_path 编译缓存路径（可为 NULL）
+ * @return 成功返回 0，失败返回 -1（保留原有数据库）
+ */
+int signature_load(const char* path, const char* cache_path);
+
+/**
+ * 释放加载的签名数据库，恢复内置数据库
+ */
+void signature_cleanup(void);
+
 /**
  * 识别数据的文件类型
  * @param data 数据缓冲区
@@ -56,6 +157,148 @@ void signature_init(void);
  */
 file_type_t signature_identify(const uint8_t* data, size_t size);
 
+/**
+ * 计算数据开头连续的文本字节数（可打印字符、常见空白字符和非 ASCII 字节）
+ * @param data 数据缓冲区
+ * @param size 最多检查的字节数
+ * @return 第一个非文本字节的位置，全部为文本时返回 size
+ */
+size_t signature_text_length(const uint8_t* data, size_t size);
+
+/**
+ * 获取由签名数据库编译的多模式匹配器（首次调用时编译）
+ * @return 匹配器指针，编译失败返回 NULL
+ */
+const signature_matcher_t* signature_get_matcher(void);
+
+/**
+ * 确定候选文件的类型：验证函数通过后由分类函数确定具体类型
+ * @param signature 匹配的签名
+ * @param candidate 候选文件
+ * @param type 文件类型（输出）
+ * @return 成功返回 0，验证函数判定无效返回 -1
+ */
+int signature_classify(const file_signature_t* signature, const signature_candidate_t* candidate,
+                       file_type_t* type);
+
+/**
+ * 由文件结构确定候选文件的大小（签名的长度解析函数）
+ * @param signature 匹配的签名
+ * @param candidate 候选文件
+ * @param size 文件大小（输出）
+ * @return 成功返回 0，没有长度解析函数或无法确定返回 -1
+ */
+int signature_structure_size(const file_signature_t* signature, const signature_candidate_t* candidate,
+                             uint64_t* size);
+
+/**
+ * 由文件尾标记确定候选文件的大小：调用文件尾搜索函数，找不到时使用类型的默认大小
+ * @param signature 匹配的签名
+ * @param candidate 候选文件
+ * @param type 分类后的文件类型（决定大小规则）
+ * @param size 文件大小（输出）
+ * @return 成功返回 0，参数无效返回 -1
+ */
+int signature_footer_size(const file_signature_t* signature, const signature_candidate_t* candidate,
+                          file_type_t type, uint64_t* size);
+
+/**
+ * 确定候选文件的大小：依次使用长度解析函数、文件尾搜索函数，都无法确定时使用类型的默认大小
+ * @param signature 匹配的签名
+ * @param candidate 候选文件
+ * @param type 分类后的文件类型（决定大小规则）
+ * @param size 文件大小（输出）
+ * @return 成功返回 0，参数无效返回 -1
+ */
+int signature_resolve_size(const file_signature_t* signature, const signature_candidate_t* candidate,
+                           file_type_t type, uint64_t* size);
+
+/**
+ * 确定候选文件的类型和大小：依次调用 signature_classify() 和 signature_resolve_size()
+ * @param signature 匹配的签名
+ * @param candidate 候选文件
+ * @param type 文件类型（输出）
+ * @param size 文件大小（输出）
+ * @return 成功返回 0，验证函数判定无效返回 -1
+ */
+int signature_carve(const file_signature_t* signature, const signature_candidate_t* candidate,
+                    file_type_t* type, uint64_t* size);
+
+/**
+ * 识别文件尾标记需要的字节数（标记和长度字段）
+ * @param info 文件类型信息
+ * @return 字节数，类型没有文件尾标记时返回 0
+ */
+size_t signature_footer_need(const file_type_info_t* info);
+
+/**
+ * 默认文件尾搜索的范围：标记起始位置（相对文件起始）在 [from, to] 内
+ * @param info 文件类型信息
+ * @param from 最近的标记位置（输出）
+ * @param to 最远的标记位置（输出）
+ * @return 成功返回 0，类型没有文件尾标记或搜索范围为空返回 -1
+ */
+int signature_footer_window(const file_type_info_t* info, uint64_t* from, uint64_t* to);
+
+/**
+ * 由文件尾标记的位置计算文件长度（标记之后的固定字节数和长度字段）
+ * @param info 文件类型信息
+ * @param position 标记位置（相对文件起始）
+ * @param footer 标记数据（至少 signature_footer_need() 字节）
+ * @return 文件长度
+ */
+uint64_t signature_footer_end(const file_type_info_t* info, uint64_t position, const uint8_t* footer);
+
+/**
+ * 在 [from, to] 内查找第一个文件尾标记（标记和长度字段必须完整可读）
+ * @param candidate 候选文件
+ * @param info 文件类型信息
+ * @param from 最近的标记位置（相对文件起始）
+ * @param to 最远的标记位置
+ * @param length 文件长度（输出）
+ * @return 找到返回 0，没有找到返回 -1
+ */
+int signature_find_footer_range(const signature_candidate_t* candidate, const file_type_info_t* info,
+                                uint64_t from, uint64_t to, uint64_t* length);
+
+/**
+ * 默认的文件尾搜索：按类型的大小规则分段读取并查找文件尾标记
+ * @param candidate 候选文件
+ * @param info 文件类型信息
+ * @param length 文件长度（输出）
+ * @return 找到返回 0，没有找到返回 -1
+ */
+int signature_find_footer(const signature_candidate_t* candidate, const file_type_info_t* info,
+                          uint64_t* length);
+
+/**
+ * 替换某个类型所有签名的处理函数（扫描开始前调用）
+ * 加载的签名数据库中与内置类型同名的类型沿用内置的处理函数，可以用此接口覆盖。
+ * @param type 文件类型
+ * @param validate 验证函数（NULL 表示不验证）
+ * @param resolve_length 长度解析函数（NULL 表示没有）
+ * @param find_footer 文件尾搜索函数（NULL 表示默认搜索）
+ * @param classify 分类函数（NULL 表示不分类）
+ * @return 更新的签名数量
+ */
+size_t signature_set_handlers(file_type_t type, signature_validate_fn validate,
+                              signature_length_fn resolve_length, signature_footer_fn find_footer,
+                              signature_classify_fn classify);
+
+/**
+ * 获取文件类型信息
+ * @param type 文件类型
+ * @return 类型信息，未知类型返回 NULL
+ */
+const file_type_info_t* signature_get_type_info(file_type_t type);
+
+/**
+ * 按类型名查找文件类型
+ * @param name 类型名
+ * @return 文件类型，未找到返回 FILE_TYPE_UNKNOWN
+ */
+file_type_t signature_find_type(const char* name);
+
 /**
  * 获取文件类型的扩展名
  * @param type 文件类型
@@ -0,0 +1,80 @@
+#ifndef SIGNATURE_DB_H
+#define SIGNATURE_DB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "signature.h"
+
+// 编译缓存格式版本（格式或编译规则变化时递增，旧缓存自动重建）
+#define SIGNATURE_DB_CACHE_VERSION 2
+// 魔数和文件尾标记的最大长度
+#define SIGNATURE_DB_MAX_PATTERN 256
+// 魔数偏移上限
+#define SIGNATURE_DB_MAX_OFFSET 65536
+
+// 签名数据库（不透明类型，加载后只读）
+typedef struct signature_db signature_db_t;
+
+/**
+ * 加载签名数据库
+ * 定义文件为文本格式，# 开头为注释，每行一条记录：
+ *   type <名称> [footer=<标记>] [extra=<字节>] [length16=<位置>] [start=<字节>] [max=<大小>] [default=<大小>]
+ *   sig <类型名> <扩展名> <魔数> [offset=<字节>] ["描述"]
+ * 魔数和标记为十六进制（如 FFD8FF）或带引号的字符串（支持 \xHH 转义），大小可带 K/M/G 后缀。
+ * 类型名与内置类型相同时使用内置的类型编号，其他类型从 FILE_TYPE_MAX 开始编号。
+ * 编译缓存为二进制格式（签名、类型、字符串池和自动机状态转移表），加载时直接映射。
+ * 同时指定两者时，缓存记录的定义文件大小和修改时间一致才使用缓存，否则重新编译并写入缓存。
+ * @param path 定义文件路径（可为 NULL，此时必须指定缓存）
+ * @param cache_path 编译缓存路径（可为 NULL）
+ * @param builtin 内置类型信息（用于类型名到编号的映射）
+ * @param builtin_count 内置类型数量
+ * @return 数据库指针，失败返回 NULL
+ */
+signature_db_t* signature_db_open(const char* path, const char* cache_path,
+                                  const file_type_info_t* builtin, size_t builtin_count);
+
+/**
+ * 将数据库写入编译缓存（先写临时文件再替换）
+ * @param db 数据库指针
+ * @param cache_path 缓存路径
+ * @return 成功返回 0，失败返回 -1
+ */
+int signature_db_write_cache(const signature_db_t* db, const char* cache_path);
+
+/**
+ * 销毁数据库
+ * @param db 数据库指针
+ */
+void signature_db_destroy(signature_db_t* db);
+
+/**
+ * 获取签名数组（定义文件中没有处理函数，调用者可以设置签名的处理函数指针）
+ * @param db 数据库指针
+ * @param count 输出签名数量
+ * @return 签名数组
+ */
+file_signature_t* signature_db_signatures(signature_db_t* db, size_t* count);
+
+/**
+ * 获取类型信息数组
+ * @param db 数据库指针
+ * @param count 输出类型数量
+ * @return 类型信息数组
+ */
+const file_type_info_t* signature_db_types(const signature_db_t* db, size_t* count);
+
+/**
+ * 获取编译好的多模式匹配器
+ * @param db 数据库指针
+ * @return 匹配器指针
+ */
+const signature_matcher_t* signature_db_matcher(const signature_db_t* db);
+
+/**
+ * 数据库是否映射自编译缓存
+ * @param db 数据库指针
+ * @return 映射自缓存返回 1，否则返回 0
+ */
+int signature_db_from_cache(const signature_db_t* db);
+
+#endif // SIGNATURE_DB_H
@@ -0,0 +1,78 @@
+#ifndef SIGNATURE_FORMATS_H
+#define SIGNATURE_FORMATS_H
+
+#include <stdint.h>
+#include "signature.h"
+
+// 结构遍历的最大步数（块、盒子或数据块的数量），防止损坏的数据导致长时间读取
+#define SIGNATURE_FORMATS_MAX_STEPS 65536
+// 分类函数对每个候选文件最多读取的字节数（文件头之外）
+#define SIGNATURE_FORMATS_CLASSIFY_BUDGET (64 * 1024)
+// 分类函数最多检查的 ZIP 条目数或目录扇区数
+#define SIGNATURE_FORMATS_CLASSIFY_ENTRIES 64
+
+/**
+ * BMP 长度解析：文件头中的 bfSize
+ * @param candidate 候选文件
+ * @param length 文件长度（输出）
+ * @return 成功返回 0，文件头不一致返回 -1
+ */
+int signature_bmp_length(const signature_candidate_t* candidate, uint64_t* length);
+
+/**
+ * RIFF（AVI、WAV 等）长度解析：RIFF 块大小 + 8 字节块头（奇数长度补齐）
+ * @param candidate 候选文件
+ * @param length 文件长度（输出）
+ * @return 成功返回 0，文件头不一致返回 -1
+ */
+int signature_riff_length(const signature_candidate_t* candidate, uint64_t* length);
+
+/**
+ * ISO-BMFF（MP4、MOV）长度解析：逐个跳过顶层盒子，直到遇到不是已知顶层盒子的数据
+ * @param candidate 候选文件
+ * @param length 文件长度（输出）
+ * @return 成功返回 0，第一个盒子无效返回 -1
+ */
+int signature_isobmff_length(const signature_candidate_t* candidate, uint64_t* length);
+
+/**
+ * PNG 长度解析：按数据块长度逐块跳到 IEND
+ * @param candidate 候选文件
+ * @param length 文件长度（输出）
+ * @return 成功返回 0，数据块结构无效或没有到达 IEND 返回 -1
+ */
+int signature_png_length(const signature_candidate_t* candidate, uint64_t* length);
+
+/**
+ * GIF 长度解析：按扩展块、图像块和数据子块的长度跳到结尾标记 0x3B
+ * @param candidate 候选文件
+ * @param length 文件长度（输出）
+ * @return 成功返回 0，块结构无效返回 -1
+ */
+int signature_gif_length(const signature_candidate_t* candidate, uint64_t* length);
+
+/**
+ * ZIP 分类：按本地文件头中的文件名区分 DOCX（word/）、XLSX（xl/）、PPTX（ppt/）和普通 ZIP
+ * @param candidate 候选文件
+ * @param type 签名的文件类型
+ * @return 具体的文件类型，没有 OOXML 部件时返回 FILE_TYPE_ZIP
+ */
+file_type_t signature_zip_classify(const signature_candidate_t* candidate, file_type_t type);
+
+/**
+ * OLE 复合文档分类：按目录中的数据流名称区分 DOC（WordDocument）、XLS（Workbook/Book）和 PPT（PowerPoint Document）
+ * @param candidate 候选文件
+ * @param type 签名的文件类型
+ * @return 具体的文件类型，无法确定时返回 type
+ */
+file_type_t signature_ole_classify(const signature_candidate_t* candidate, file_type_t type);
+
+/**
+ * PE 分类：按 COFF 头的 IMAGE_FILE_DLL 标志区分 DLL 和 EXE
+ * @param candidate 候选文件
+ * @param type 签名的文件类型
+ * @return 具体的文件类型，没有 PE 头时返回 type
+ */
+file_type_t signature_pe_classify(const signature_candidate_t* candidate, file_type_t type);
+
+#endif // SIGNATURE_FORMATS_H
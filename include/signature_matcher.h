@@ -0,0 +1,95 @@
+#ifndef SIGNATURE_MATCHER_H
+#define SIGNATURE_MATCHER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "signature.h"
+
+// 一次签名匹配
+typedef struct {
+    size_t position;          // 文件起始位置（魔数位置减去签名偏移）
+    uint32_t signature;       // 签名在签名数组中的下标
+    file_type_t type;         // 文件类型
+} signature_match_t;
+
+/**
+ * 匹配回调
+ * @param match 匹配结果
+ * @param user_data 用户数据
+ * @return 返回 0 继续匹配，非 0 停止
+ */
+typedef int (*signature_match_fn)(const signature_match_t* match, void* user_data);
+
+/**
+ * 将签名数组编译为 Aho-Corasick 自动机（创建后只读，可由多个线程共享）
+ * 所有魔数合并为一个状态转移表，扫描时每个字节只做一次查表，耗时与签名数量无关；
+ * 自动机处于根状态时由向量化预过滤器跳过不可能开始魔数的字节。
+ * @param signatures 签名数组
+ * @param count 签名数量
+ * @return 匹配器指针，失败返回 NULL
+ */
+signature_matcher_t* signature_matcher_create(const file_signature_t* signatures, size_t count);
+
+/**
+ * 从编译映像创建匹配器（映像通常映射自签名数据库缓存，不复制状态转移表）
+ * 映像在匹配器销毁前必须保持有效；签名数组须与写出映像时相同。
+ * @param image 映像数据（按 64 字节对齐）
+ * @param size 映像大小
+ * @param signatures 签名数组
+ * @param count 签名数量
+ * @return 匹配器指针，映像无效返回 NULL
+ */
+signature_matcher_t* signature_matcher_from_image(const void* image, size_t size,
+                                                  const file_signature_t* signatures, size_t count);
+
+/**
+ * 获取编译映像的大小
+ * @param matcher 匹配器指针
+ * @return 映像大小（字节）
+ */
+size_t signature_matcher_image_size(const signature_matcher_t* matcher);
+
+/**
+ * 写出编译映像（状态转移表和输出列表）
+ * @param matcher 匹配器指针
+ * @param fp 输出文件（当前位置应按 64 字节对齐）
+ * @return 成功返回 0，失败返回 -1
+ */
+int signature_matcher_write_image(const signature_matcher_t* matcher, FILE* fp);
+
+/**
+ * 销毁匹配器
+ * @param matcher 匹配器指针
+ */
+void signature_matcher_destroy(signature_matcher_t* matcher);
+
+/**
+ * 单遍扫描缓冲区，报告所有签名匹配
+ * 匹配按文件起始位置升序报告，同一位置按签名数组中的顺序报告；
+ * 魔数完整位于缓冲区内且起始位置不小于 0 的匹配才会报告。
+ * @param matcher 匹配器指针
+ * @param data 数据缓冲区
+ * @param size 数据大小
+ * @param callback 匹配回调
+ * @param user_data 传给回调的用户数据
+ * @return 报告的匹配数，失败返回 -1
+ */
+int64_t signature_matcher_scan(const signature_matcher_t* matcher, const uint8_t* data, size_t size,
+                               signature_match_fn callback, void* user_data);
+
+/**
+ * 获取签名的最大跨度（偏移 + 魔数长度）
+ * @param matcher 匹配器指针
+ * @return 最大跨度（字节）
+ */
+size_t signature_matcher_max_span(const signature_matcher_t* matcher);
+
+/**
+ * 获取候选位置预过滤器使用的指令集
+ * @param matcher 匹配器指针
+ * @return "avx2"、"sse2"、"scalar" 或 "none"（未启用预过滤）
+ */
+const char* signature_matcher_isa(const signature_matcher_t* matcher);
+
+#endif // SIGNATURE_MATCHER_H
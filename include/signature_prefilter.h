@@ -0,0 +1,58 @@
+#ifndef SIGNATURE_PREFILTER_H
+#define SIGNATURE_PREFILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "signature.h"
+
+// SSE2 路径支持的不同首字节数量上限，超过时使用标量路径
+#define SIGNATURE_PREFILTER_MAX_BYTES 32
+
+// 候选位置预过滤器（不透明类型，创建后只读，可由多个线程共享）
+typedef struct signature_prefilter signature_prefilter_t;
+
+/**
+ * 指定之后创建的预过滤器使用的实现（用于测试和排查问题，默认按 CPU 自动选择）
+ * 指定 sse2 而首字节超过 SIGNATURE_PREFILTER_MAX_BYTES 个时使用标量实现；
+ * 指定 off 时不创建预过滤器，匹配器逐字节运行自动机。
+ * @param isa "auto"、"avx2"、"sse2"、"scalar" 或 "off"
+ * @return 成功返回 0，名称无效或 CPU 不支持返回 -1
+ */
+int signature_prefilter_select(const char* isa);
+
+/**
+ * 根据签名的魔数创建预过滤器
+ * 候选位置 = 首字节属于魔数首字节集合，且与下一字节组成某个魔数的前两个字节。
+ * 首字节集合用 AVX2（半字节查表）或 SSE2（逐个比较）按块筛选，运行时检测 CPU，
+ * 命中后再查前两字节位图。
+ * @param signatures 签名数组
+ * @param count 签名数量
+ * @return 预过滤器指针，失败或已指定 off 时返回 NULL
+ */
+signature_prefilter_t* signature_prefilter_create(const file_signature_t* signatures, size_t count);
+
+/**
+ * 销毁预过滤器
+ * @param filter 预过滤器指针
+ */
+void signature_prefilter_destroy(signature_prefilter_t* filter);
+
+/**
+ * 查找从 start 开始的第一个候选位置（魔数可能从该位置开始）
+ * @param filter 预过滤器指针
+ * @param data 数据缓冲区
+ * @param size 数据大小
+ * @param start 起始位置
+ * @return 候选位置，没有候选时返回 size
+ */
+size_t signature_prefilter_find(const signature_prefilter_t* filter, const uint8_t* data,
+                                size_t size, size_t start);
+
+/**
+ * 获取预过滤器使用的指令集
+ * @param filter 预过滤器指针
+ * @return "avx2"、"sse2" 或 "scalar"
+ */
+const char* signature_prefilter_isa(const signature_prefilter_t* filter);
+
+#endif // SIGNATURE_PREFILTER_H
@@ -0,0 +1,99 @@
+#ifndef TEXT_DETECTOR_H
+#define TEXT_DETECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 默认最短文本长度
+#define TEXT_DETECTOR_DEFAULT_MIN_LENGTH 1024
+// 默认最低熵（位/字节），过滤空格、重复字符等填充内容
+#define TEXT_DETECTOR_DEFAULT_MIN_ENTROPY 3.0
+
+// 文本区间
+typedef struct {
+    uint64_t offset;          // 起始偏移
+    uint64_t length;          // 长度（字节）
+    double entropy;           // 字节熵（位/字节）
+} text_run_t;
+
+// 文本检测统计信息
+typedef struct {
+    uint64_t bytes;           // 已检测的字节数
+    uint64_t runs;            // 满足阈值的文本区间数
+    uint64_t text_bytes;      // 满足阈值的文本区间总长度
+    uint64_t low_entropy_runs; // 长度足够但熵过低而丢弃的区间数
+} text_detector_stats_t;
+
+/**
+ * 文本区间回调
+ * @param run 文本区间
+ * @param user_data 用户数据
+ * @return 返回 0 继续，非 0 停止
+ */
+typedef int (*text_run_fn)(const text_run_t* run, void* user_data);
+
+// 流式文本检测器（不透明类型，非线程安全）
+typedef struct text_detector text_detector_t;
+
+/**
+ * 创建流式文本检测器
+ * 文本字符为可打印 ASCII、制表符、换行符和合法的 UTF-8 多字节序列。
+ * 检测器在多次输入之间保持状态，跨越数据块边界的文本区间按一个区间报告。
+ * @param min_length 最短文本长度（0 表示默认值）
+ * @param min_entropy 最低熵（位/字节，负数表示默认值）
+ * @return 检测器指针，失败返回 NULL
+ */
+text_detector_t* text_detector_create(size_t min_length, double min_entropy);
+
+/**
+ * 销毁文本检测器
+ * @param detector 检测器指针
+ */
+void text_detector_destroy(text_detector_t* detector);
+
+/**
+ * 输入一段数据，报告在这段数据中结束的、满足阈值的最长文本区间
+ * 与上次输入不连续时，先结束上次未完成的区间。
+ * @param detector 检测器指针
+ * @param data 数据
+ * @param size 数据大小
+ * @param offset 数据在磁盘上的偏移
+ * @param callback 文本区间回调
+ * @param user_data 传给回调的用户数据
+ * @return 成功返回 0，回调要求停止返回 1
+ */
+int text_detector_feed(text_detector_t* detector, const uint8_t* data, size_t size,
+                       uint64_t offset, text_run_fn callback, void* user_data);
+
+/**
+ * 查询尚未结束的文本区间
+ * @param detector 检测器指针
+ * @param run 目前为止的区间（输出，可为 NULL；没有未结束的区间时长度为 0）
+ * @return 区间目前已满足长度和熵的阈值返回 1，否则返回 0
+ */
+int text_detector_pending(const text_detector_t* detector, text_run_t* run);
+
+/**
+ * 结束输入，报告未完成的文本区间
+ * @param detector 检测器指针
+ * @param callback 文本区间回调
+ * @param user_data 传给回调的用户数据
+ * @return 成功返回 0，回调要求停止返回 1
+ */
+int text_detector_finish(text_detector_t* detector, text_run_fn callback, void* user_data);
+
+/**
+ * 获取文本检测统计信息
+ * @param detector 检测器指针
+ * @param stats 统计信息（输出）
+ */
+void text_detector_get_stats(const text_detector_t* detector, text_detector_stats_t* stats);
+
+/**
+ * 获取检测器使用的指令集
+ * @param detector 检测器指针
+ * @return "avx2"、"sse2" 或 "scalar"
+ */
+const char* text_detector_isa(const text_detector_t* detector);
+
+#endif // TEXT_DETECTOR_H
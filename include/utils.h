@@ -55,6 +55,12 @@ int utils_calculate_progress(uint64_t current, uint64_t total);
  */
 void utils_show_progress(int progress, const char* message);
 
+/**
+ * 获取单调时钟时间（用于计时和速率计算）
+ * @return 纳秒
+ */
+uint64_t utils_monotonic_ns(void);
+
 /**
  * 十六进制转储
  * @param data 数据
@@ -0,0 +1,88 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 任务函数（arg 和 index 由提交者指定）
+typedef void (*work_fn)(void* arg, size_t index);
+
+// 任务
+typedef struct {
+    work_fn fn;
+    void* arg;
+    size_t index;
+} work_item_t;
+
+// 调度统计信息
+typedef struct {
+    uint64_t pushed;          // 提交的任务数
+    uint64_t stolen;          // 被其他工作线程窃取的任务数
+} work_queue_stats_t;
+
+// 工作窃取队列（不透明类型）：每个工作线程一个双端队列，
+// 线程从自己队列的尾部取任务（后进先出），空闲时从其他线程队列的头部窃取（先进先出）
+typedef struct work_queue work_queue_t;
+
+/**
+ * 创建工作窃取队列
+ * @param workers 工作线程数（每个线程一个双端队列，线程编号 0 .. workers-1）
+ * @return 队列指针，失败返回 NULL
+ */
+work_queue_t* work_queue_create(uint32_t workers);
+
+/**
+ * 销毁工作窃取队列（未执行的任务直接丢弃）
+ * @param queue 队列指针
+ */
+void work_queue_destroy(work_queue_t* queue);
+
+/**
+ * 把任务放入工作线程自己队列的尾部，并唤醒等待中的线程
+ * @param queue 队列指针
+ * @param worker 提交任务的工作线程编号
+ * @param fn 任务函数
+ * @param arg 任务参数
+ * @param index 任务下标
+ * @return 成功返回 0，失败返回 -1
+ */
+int work_queue_push(work_queue_t* queue, uint32_t worker, work_fn fn, void* arg, size_t index);
+
+/**
+ * 取出一个任务：先取自己队列尾部最新提交的任务，自己的队列为空时从其他线程的队列头部窃取
+ * @param queue 队列指针
+ * @param worker 工作线程编号
+ * @param item 任务（输出）
+ * @return 取到任务返回 1，所有队列都为空返回 0
+ */
+int work_queue_pop(work_queue_t* queue, uint32_t worker, work_item_t* item);
+
+/**
+ * 获取当前的唤醒计数，配合 work_queue_wait() 避免丢失唤醒：
+ * 先读取计数，再检查任务和其他条件，都不满足时以这个计数等待
+ * @param queue 队列指针
+ * @return 唤醒计数
+ */
+uint64_t work_queue_epoch(work_queue_t* queue);
+
+/**
+ * 等待新任务或 work_queue_notify()（唤醒计数已不等于 epoch 时立即返回）
+ * @param queue 队列指针
+ * @param epoch 检查前由 work_queue_epoch() 读取的计数
+ */
+void work_queue_wait(work_queue_t* queue, uint64_t epoch);
+
+/**
+ * 唤醒所有等待中的线程（任务之外的条件发生变化时调用）
+ * @param queue 队列指针
+ */
+void work_queue_notify(work_queue_t* queue);
+
+/**
+ * 获取调度统计信息
+ * @param queue 队列指针
+ * @param stats 统计信息（输出）
+ */
+void work_queue_get_stats(work_queue_t* queue, work_queue_stats_t* stats);
+
+#endif // WORK_QUEUE_H
@@ -3,14 +3,20 @@
 #include <string.h>
 #include <getopt.h>
 #include "disk_io.h"
+#include "disk_aio.h"
+#include "scan_pipeline.h"
 #include "signature.h"
+#include "signature_prefilter.h"
 #include "file_system.h"
 #include "scanner.h"
+#include "text_detector.h"
+#include "region_classifier.h"
 #include "recovery.h"
+#include "result_sink.h"
 #include "utils.h"
 
 #define VERSION "1.0.0"
-#define MAX_SCAN_RESULTS 10000
+#define MAX_TYPE_LIST 64
 
 // 扫描模式
 typedef enum {
@@ -21,13 +27,37 @@ typedef enum {
 
 // 程序配置
 typedef struct {
-    char device_path[512];
+    char device_path[PATH_MAX];
     char output_dir[512];
     scan_mode_t scan_mode;
     int auto_recover;
     int verify;
     int show_info;
     int list_only;
+    uint32_t io_depth;
+    uint32_t open_flags;
+    long cache_mb;
+    size_t read_ahead;
+    double max_rate_mb;
+    uint32_t max_iops;
+    int rescue;
+    char bad_map[512];
+    uint32_t text_min;
+    double text_entropy;
+    char signatures[512];
+    char signature_cache[512];
+    char types[512];
+    char exclude_types[512];
+    file_type_t include_list[MAX_TYPE_LIST];
+    size_t include_count;
+    file_type_t exclude_list[MAX_TYPE_LIST];
+    size_t exclude_count;
+    int skip_barren;
+    double barren_entropy;
+    uint32_t threads;
+    uint32_t alignment;
+    uint64_t max_results;
+    char spill[512];
 } config_t;
 
 void print_banner(void) {
@@ -50,6 +80,49 @@ void print_usage(const char* program) {
     printf("  -l, --list              仅列出可恢复的文件，不执行恢复\n");
     printf("  -r, --recover           自动恢复所有找到的文件\n");
     printf("  -V, --verify            验证恢复的文件完整性\n");
+    printf("      --io-depth <N>      异步读取队列深度 (1-%d)\n", DISK_AIO_MAX_DEPTH);
+    printf("                          默认: %d\n", DISK_AIO_DEFAULT_DEPTH);
+    printf("      --no-mmap           禁用磁盘镜像的内存映射（零拷贝）模式\n");
+    printf("      --direct            直接 I/O（O_DIRECT），绕过页缓存\n");
+    printf("      --cache-size <MB>   小块读取的块缓存容量，0 表示禁用\n");
+    printf("                          默认: %d\n", DISK_CACHE_DEFAULT_CAPACITY / (1024 * 1024));
+    printf("      --read-ahead <MB>   深度扫描预读缓冲区的内存预算\n");
+    printf("                          默认: %d\n", SCAN_PIPELINE_DEFAULT_BUDGET / (1024 * 1024));
+    printf("      --max-rate <MB/s>   读取带宽上限（在线设备上扫描时避免影响业务）\n");
+    printf("      --max-iops <N>      每秒读取请求数上限\n");
+    printf("                          限速时读取延迟升高会自动降速，默认不限速\n");
+    printf("      --rescue            容错读取：读取出错时跳过并填零，扫描结束前重试跳过的区域\n");
+    printf("                          （默认读取出错即失败）。镜像文件默认内存映射，映射区的读取\n");
+    printf("                          不经过容错路径，故障设备上的镜像请同时使用 --no-mmap\n");
+    printf("      --bad-map <文件>    坏块图文件：记录跳过和无法读取的区域，\n");
+    printf("                          再次运行时直接跳过已知坏区并重试跳过的区域（隐含 --rescue）\n");
+    printf("      --text-min <字节>   文本文件的最短长度\n");
+    printf("                          默认: %d\n", TEXT_DETECTOR_DEFAULT_MIN_LENGTH);
+    printf("      --text-entropy <位> 文本文件的最低字节熵（0-8），过滤空格等填充内容\n");
+    printf("                          默认: %.1f\n", TEXT_DETECTOR_DEFAULT_MIN_ENTROPY);
+    printf("      --signatures <文件> 从签名定义文件加载签名数据库（替换内置数据库）\n");
+    printf("      --signature-cache <文件>\n");
+    printf("                          签名数据库的编译缓存：与定义文件一致时直接映射，\n");
+    printf("                          否则重新编译并写入；单独指定时直接加载缓存\n");
+    printf("      --types <类型,...>  深度扫描只查找这些类型（如 jpeg,pdf,docx）\n");
+    printf("      --exclude-types <类型,...>\n");
+    printf("                          深度扫描不查找这些类型（如 exe,dll,bmp）\n");
+    printf("                          类型名与签名定义文件中的 type 相同，txt 表示纯文本\n");
+    printf("      --skip-barren       跳过零填充和重复模式区域，高熵（加密、压缩）区域\n");
+    printf("                          只检查扇区对齐的文件起始位置\n");
+    printf("      --barren-entropy <位>\n");
+    printf("                          高熵区域的熵阈值（0-8，大于 8 表示只跳过重复模式）\n");
+    printf("                          默认: %.1f\n", REGION_CLASSIFIER_DEFAULT_MAX_ENTROPY);
+    printf("      --threads <N>       深度扫描的工作线程数 (1-%d)\n", SCANNER_MAX_THREADS);
+    printf("                          默认: CPU 核数\n");
+    printf("      --align <字节|auto> 深度扫描只检查对齐的文件起始位置（文件通常从簇边界开始），\n");
+    printf("                          auto 表示文件系统的簇大小（无法识别时为扇区大小）\n");
+    printf("      --max-results <N>   找到这么多文件后停止深度扫描 (默认: 不限)\n");
+    printf("      --spill <文件>      扫描结果写入这个文件，内存中只保留少量结果\n");
+    printf("                          (默认: 全部保存在内存中)\n");
+    printf("      --prefilter <实现>  深度扫描候选位置预过滤器: auto, avx2, sse2, scalar,\n");
+    printf("                          off（不预过滤，逐字节匹配）；用于测试和排查问题\n");
+    printf("                          默认: auto（按 CPU 选择）\n");
     printf("\n");
     printf("示例:\n");
     printf("  %s -i /dev/sdb1                    # 显示设备信息\n", program);
@@ -73,8 +146,16 @@ void show_device_info(disk_handle_t* handle) {
     
     char size_buf[32];
     printf("  路径: %s\n", handle->device_path);
+    if (handle->segment_count > 1) {
+        printf("  分卷镜像: %u 个分段（%s ... %s）\n", handle->segment_count,
+               handle->segments[0].path, handle->segments[handle->segment_count - 1].path);
+    }
     printf("  大小: %s\n", utils_format_size(handle->size, size_buf, sizeof(size_buf)));
-    printf("  扇区大小: %u bytes\n", handle->sector_size);
+    printf("  扇区大小: %u bytes (逻辑) / %u bytes (物理)\n",
+           handle->sector_size, handle->physical_sector_size);
+    if (handle->io_align) {
+        printf("  直接 I/O: 已启用（按 %u bytes 对齐）\n", handle->io_align);
+    }
     
     // 检测文件系统
     fs_info_t fs_info;
@@ -92,26 +173,73 @@ void show_device_info(disk_handle_t* handle) {
     printf("═══════════════════════════════════════════════════════\n\n");
 }
 
-void list_scan_results(const scan_result_t* results, int count) {
+int64_t run_deep_scan(disk_handle_t* handle, const config_t* config, result_sink_t* results) {
+    printf("Performing deep scan (signature-based)...\n");
+
+    scan_options_t options;
+    scanner_default_options(&options);
+    options.io_depth = config->io_depth;
+    options.memory_budget = config->read_ahead;
+    options.text_min_length = config->text_min;
+    options.text_min_entropy = config->text_entropy;
+    if (config->types[0]) {
+        options.include_types = config->include_list;
+        options.include_count = config->include_count;
+    }
+    options.exclude_types = config->exclude_list;
+    options.exclude_count = config->exclude_count;
+    options.skip_barren = (uint8_t)config->skip_barren;
+    options.barren_entropy = config->barren_entropy;
+    options.threads = config->threads;
+    options.alignment = config->alignment;
+    options.max_results = config->max_results;
+
+    return scanner_scan(handle, &options, results);
+}
+
+// 解析逗号分隔的类型名列表，类型名未知时返回 -1
+int parse_type_list(const char* text, file_type_t* types, size_t max_types, size_t* count) {
+    char buffer[512];
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    *count = 0;
+    for (char* name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+        file_type_t type = signature_find_type(name);
+        if (type == FILE_TYPE_UNKNOWN) {
+            fprintf(stderr, "错误: 未知的文件类型 '%s'\n", name);
+            return -1;
+        }
+        if (*count == max_types) {
+            fprintf(stderr, "错误: 类型列表过长（最多 %zu 个）\n", max_types);
+            return -1;
+        }
+        types[(*count)++] = type;
+    }
+    return 0;
+}
+
+void list_scan_results(result_sink_t* results) {
+    uint64_t count = result_sink_count(results);
     if (count == 0) {
         printf("没有找到可恢复的文件。\n");
         return;
     }
     
     printf("\n═══════════════════════════════════════════════════════\n");
-    printf("找到 %d 个可恢复的文件:\n", count);
+    printf("找到 %llu 个可恢复的文件:\n", (unsigned long long)count);
     printf("═══════════════════════════════════════════════════════\n");
     printf("%-6s %-12s %-15s %-30s\n", "序号", "偏移", "大小", "类型");
     printf("───────────────────────────────────────────────────────\n");
     
     char size_buf[32];
-    for (int i = 0; i < count; i++) {
-        const scan_result_t* result = &results[i];
-        printf("%-6d 0x%-10llx %-15s %-30s\n",
-               i + 1,
-               (unsigned long long)result->offset,
-               utils_format_size(result->size, size_buf, sizeof(size_buf)),
-               signature_get_description(result->type));
+    scan_result_t result;
+    for (uint64_t i = 0; i < count && result_sink_get(results, i, &result) == 0; i++) {
+        printf("%-6llu 0x%-10llx %-15s %-30s\n",
+               (unsigned long long)(i + 1),
+               (unsigned long long)result.offset,
+               utils_format_size(result.size, size_buf, sizeof(size_buf)),
+               signature_get_description(result.type));
     }
     
     printf("═══════════════════════════════════════════════════════\n\n");
@@ -125,7 +253,17 @@ int main(int argc, char* argv[]) {
         .auto_recover = 0,
         .verify = 0,
         .show_info = 0,
-        .list_only = 0
+        .list_only = 0,
+        .io_depth = DISK_AIO_DEFAULT_DEPTH,
+        .open_flags = DISK_OPEN_DEFAULT,
+        .cache_mb = -1,
+        .read_ahead = SCAN_PIPELINE_DEFAULT_BUDGET,
+        .max_rate_mb = 0,
+        .max_iops = 0,
+        .bad_map = "",
+        .text_min = TEXT_DETECTOR_DEFAULT_MIN_LENGTH,
+        .text_entropy = TEXT_DETECTOR_DEFAULT_MIN_ENTROPY,
+        .barren_entropy = REGION_CLASSIFIER_DEFAULT_MAX_ENTROPY
     };
 
     // 解析命令行参数
@@ -138,6 +276,28 @@ int main(int argc, char* argv[]) {
         {"list",    no_argument,       0, 'l'},
         {"recover", no_argument,       0, 'r'},
         {"verify",  no_argument,       0, 'V'},
+        {"io-depth", required_argument, 0, 'D'},
+        {"no-mmap", no_argument,       0, 'M'},
+        {"direct",  no_argument,       0, 'O'},
+        {"cache-size", required_argument, 0, 'C'},
+        {"read-ahead", required_argument, 0, 'A'},
+        {"max-rate", required_argument, 0, 'R'},
+        {"max-iops", required_argument, 0, 'I'},
+        {"rescue",  no_argument,       0, 'Q'},
+        {"bad-map", required_argument, 0, 'B'},
+        {"text-min", required_argument, 0, 'T'},
+        {"text-entropy", required_argument, 0, 'E'},
+        {"signatures", required_argument, 0, 'S'},
+        {"signature-cache", required_argument, 0, 'G'},
+        {"types",   required_argument, 0, 'Y'},
+        {"exclude-types", required_argument, 0, 'X'},
+        {"skip-barren", no_argument,   0, 'Z'},
+        {"barren-entropy", required_argument, 0, 'N'},
+        {"threads", required_argument, 0, 'P'},
+        {"align",   required_argument, 0, 'L'},
+        {"max-results", required_argument, 0, 'K'},
+        {"spill",   required_argument, 0, 'U'},
+        {"prefilter", required_argument, 0, 'F'},
         {0, 0, 0, 0}
     };
 
@@ -178,6 +338,138 @@ int main(int argc, char* argv[]) {
             case 'V':
                 config.verify = 1;
                 break;
+            case 'D': {
+                int depth = atoi(optarg);
+                if (depth < 1 || depth > DISK_AIO_MAX_DEPTH) {
+                    fprintf(stderr, "错误: 无效的队列深度 '%s'\n", optarg);
+                    return 1;
+                }
+                config.io_depth = (uint32_t)depth;
+                break;
+            }
+            case 'M':
+                config.open_flags |= DISK_OPEN_NO_MMAP;
+                break;
+            case 'O':
+                config.open_flags |= DISK_OPEN_DIRECT;
+                break;
+            case 'A': {
+                long mb = atol(optarg);
+                if (mb < 1) {
+                    fprintf(stderr, "错误: 无效的预读预算 '%s'\n", optarg);
+                    return 1;
+                }
+                config.read_ahead = (size_t)mb * 1024 * 1024;
+                break;
+            }
+            case 'C':
+                config.cache_mb = atol(optarg);
+                if (config.cache_mb < 0) {
+                    fprintf(stderr, "错误: 无效的缓存大小 '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'R':
+                config.max_rate_mb = atof(optarg);
+                if (config.max_rate_mb <= 0) {
+                    fprintf(stderr, "错误: 无效的带宽上限 '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'I': {
+                long iops = atol(optarg);
+                if (iops < 1) {
+                    fprintf(stderr, "错误: 无效的 IOPS 上限 '%s'\n", optarg);
+                    return 1;
+                }
+                config.max_iops = (uint32_t)iops;
+                break;
+            }
+            case 'Q':
+                config.rescue = 1;
+                break;
+            case 'B':
+                strncpy(config.bad_map, optarg, sizeof(config.bad_map) - 1);
+                config.rescue = 1;
+                break;
+            case 'T': {
+                long length = atol(optarg);
+                if (length < 1) {
+                    fprintf(stderr, "错误: 无效的文本最短长度 '%s'\n", optarg);
+                    return 1;
+                }
+                config.text_min = (uint32_t)length;
+                break;
+            }
+            case 'E':
+                config.text_entropy = atof(optarg);
+                if (config.text_entropy < 0 || config.text_entropy > 8) {
+                    fprintf(stderr, "错误: 无效的文本最低熵 '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'S':
+                strncpy(config.signatures, optarg, sizeof(config.signatures) - 1);
+                break;
+            case 'G':
+                strncpy(config.signature_cache, optarg, sizeof(config.signature_cache) - 1);
+                break;
+            case 'Y':
+                strncpy(config.types, optarg, sizeof(config.types) - 1);
+                break;
+            case 'X':
+                strncpy(config.exclude_types, optarg, sizeof(config.exclude_types) - 1);
+                break;
+            case 'Z':
+                config.skip_barren = 1;
+                break;
+            case 'N':
+                config.barren_entropy = atof(optarg);
+                if (config.barren_entropy <= 0) {
+                    fprintf(stderr, "错误: 无效的熵阈值 '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'P': {
+                long threads = atol(optarg);
+                if (threads < 1 || threads > SCANNER_MAX_THREADS) {
+                    fprintf(stderr, "错误: 无效的线程数 '%s'\n", optarg);
+                    return 1;
+                }
+                config.threads = (uint32_t)threads;
+                break;
+            }
+            case 'L': {
+                if (strcmp(optarg, "auto") == 0) {
+                    config.alignment = SCANNER_ALIGN_AUTO;
+                    break;
+                }
+                long alignment = atol(optarg);
+                if (alignment < 1 || alignment > 1024L * 1024 * 1024) {
+                    fprintf(stderr, "错误: 无效的对齐值 '%s'\n", optarg);
+                    return 1;
+                }
+                config.alignment = (uint32_t)alignment;
+                break;
+            }
+            case 'K': {
+                long long max_results = atoll(optarg);
+                if (max_results < 1) {
+                    fprintf(stderr, "错误: 无效的结果数上限 '%s'\n", optarg);
+                    return 1;
+                }
+                config.max_results = (uint64_t)max_results;
+                break;
+            }
+            case 'U':
+                strncpy(config.spill, optarg, sizeof(config.spill) - 1);
+                break;
+            case 'F':
+                if (signature_prefilter_select(optarg) < 0) {
+                    fprintf(stderr, "错误: 无效或 CPU 不支持的预过滤器 '%s'\n", optarg);
+                    return 1;
+                }
+                break;
             default:
                 print_usage(argv[0]);
                 return 1;
@@ -196,6 +488,22 @@ int main(int argc, char* argv[]) {
     // 显示横幅
     print_banner();
 
+    // 加载签名数据库（未指定时使用内置数据库）
+    if ((config.signatures[0] || config.signature_cache[0]) &&
+        signature_load(config.signatures[0] ? config.signatures : NULL,
+                       config.signature_cache[0] ? config.signature_cache : NULL) < 0) {
+        fprintf(stderr, "错误: 无法加载签名数据库\n");
+        return 1;
+    }
+
+    // 类型名按当前签名数据库解析（定义文件可以新增类型）
+    if (parse_type_list(config.types, config.include_list, MAX_TYPE_LIST, &config.include_count) < 0 ||
+        parse_type_list(config.exclude_types, config.exclude_list, MAX_TYPE_LIST,
+                        &config.exclude_count) < 0) {
+        signature_cleanup();
+        return 1;
+    }
+
     // 初始化扫描器
     if (scanner_init() < 0) {
         fprintf(stderr, "错误: 扫描器初始化失败\n");
@@ -204,12 +512,31 @@ int main(int argc, char* argv[]) {
 
     // 打开设备
     printf("正在打开设备: %s\n\n", config.device_path);
-    disk_handle_t* handle = disk_open(config.device_path);
+    disk_handle_t* handle = disk_open_ex(config.device_path, config.open_flags);
     if (!handle) {
         fprintf(stderr, "错误: 无法打开设备\n");
         return 1;
     }
 
+    if (config.cache_mb >= 0 &&
+        disk_set_cache(handle, (size_t)config.cache_mb * 1024 * 1024) < 0) {
+        fprintf(stderr, "警告: 块缓存创建失败，继续使用无缓存读取\n");
+    }
+
+    if ((config.max_rate_mb > 0 || config.max_iops > 0) &&
+        disk_set_throttle(handle, (uint64_t)(config.max_rate_mb * 1024 * 1024),
+                          config.max_iops) < 0) {
+        fprintf(stderr, "警告: 限速器创建失败，继续不限速读取\n");
+    }
+
+    // 容错读取（--rescue 或 --bad-map）：读取错误不会中断扫描，跳过的区域在扫描结束前重试
+    if (config.rescue && disk_set_rescue(handle, config.bad_map[0] ? config.bad_map : NULL) < 0) {
+        fprintf(stderr, "错误: 无法加载坏块图 '%s'\n", config.bad_map);
+        disk_close(handle);
+        scanner_cleanup();
+        return 1;
+    }
+
     // 显示设备信息
     if (config.show_info) {
         show_device_info(handle);
@@ -220,48 +547,52 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // 分配扫描结果数组
-    scan_result_t* results = (scan_result_t*)malloc(MAX_SCAN_RESULTS * sizeof(scan_result_t));
+    // 创建结果存储
+    result_sink_t* results = result_sink_create(config.spill[0] ? config.spill : NULL);
     if (!results) {
-        fprintf(stderr, "错误: 内存分配失败\n");
+        fprintf(stderr, "错误: 无法创建结果存储\n");
         disk_close(handle);
+        scanner_cleanup();
+        signature_cleanup();
         return 1;
     }
 
     // 执行扫描
-    int found_count = 0;
+    int64_t found_count = 0;
     printf("\n开始扫描...\n");
     
     switch (config.scan_mode) {
         case SCAN_MODE_QUICK:
             printf("扫描模式: 快速扫描（基于文件系统）\n\n");
-            found_count = scanner_quick_scan(handle, results, MAX_SCAN_RESULTS);
+            found_count = scanner_quick_scan(handle, results);
             break;
             
         case SCAN_MODE_DEEP:
             printf("扫描模式: 深度扫描（基于文件签名）\n\n");
-            found_count = scanner_deep_scan(handle, results, MAX_SCAN_RESULTS);
+            found_count = run_deep_scan(handle, &config, results);
             break;
             
         case SCAN_MODE_AUTO:
             printf("扫描模式: 自动模式（先快速后深度）\n\n");
-            found_count = scanner_quick_scan(handle, results, MAX_SCAN_RESULTS);
+            found_count = scanner_quick_scan(handle, results);
             if (found_count == 0) {
                 printf("\n快速扫描未找到文件，切换到深度扫描...\n\n");
-                found_count = scanner_deep_scan(handle, results, MAX_SCAN_RESULTS);
+                found_count = run_deep_scan(handle, &config, results);
             }
             break;
     }
 
     if (found_count < 0) {
         fprintf(stderr, "错误: 扫描失败\n");
-        free(results);
+        result_sink_destroy(results);
         disk_close(handle);
+        scanner_cleanup();
+        signature_cleanup();
         return 1;
     }
 
     // 列出扫描结果
-    list_scan_results(results, found_count);
+    list_scan_results(results);
 
     // 执行恢复
     if (config.auto_recover && found_count > 0) {
@@ -270,12 +601,13 @@ int main(int argc, char* argv[]) {
         recovery_options_t recovery_opts = {
             .output_dir = config.output_dir,
             .overwrite = 0,
-            .verify = config.verify
+            .verify = config.verify,
+            .io_depth = config.io_depth
         };
         
-        int recovered = recovery_recover_batch(handle, results, found_count, &recovery_opts);
+        uint64_t recovered = recovery_recover_batch(handle, results, &recovery_opts);
         
-        printf("\n恢复完成: %d/%d 文件成功恢复\n", recovered, found_count);
+        printf("\n恢复完成: %llu/%lld 文件成功恢复\n", (unsigned long long)recovered, (long long)found_count);
     } else if (config.list_only && found_count > 0) {
         printf("提示: 使用 -r 选项可以恢复这些文件\n");
     } else if (found_count == 0) {
@@ -284,9 +616,10 @@ int main(int argc, char* argv[]) {
     }
 
     // 清理
-    free(results);
+    result_sink_destroy(results);
     disk_close(handle);
     scanner_cleanup();
+    signature_cleanup();
 
     return 0;
 }
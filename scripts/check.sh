@@ -0,0 +1,422 @@
+#!/bin/bash
+
+# DiskAS 回归检查
+# 用法: scripts/check.sh <DiskAS 可执行文件>
+# 生成合成磁盘镜像，检查扫描输出（结果列表和错误输出）是否符合预期
+
+BIN="$1"
+if [ -z "$BIN" ] || [ ! -x "$BIN" ]; then
+    echo "用法: $0 <DiskAS 可执行文件>" >&2
+    exit 2
+fi
+BIN="$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")"
+SOURCE_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 2
+
+FAILED=0
+PASSED=0
+
+pass() {
+    PASSED=$((PASSED + 1))
+    echo "  ok    $1"
+}
+
+fail() {
+    FAILED=$((FAILED + 1))
+    echo "  FAIL  $1"
+    if [ -n "$2" ] && [ -s "$2" ]; then
+        sed 's/^/        /' "$2" | head -20
+    fi
+}
+
+# 创建全零镜像: image <文件> <字节数>
+image() {
+    head -c "$2" /dev/zero > "$1"
+}
+
+# 在偏移处写入数据（printf 格式）: put <文件> <偏移> <数据>
+put() {
+    printf "$3" | dd of="$1" bs=1 seek="$2" conv=notrunc status=none
+}
+
+# 深度扫描，结果列表写入 <名称>.out，完整输出写入 <名称>.log，错误输出写入 <名称>.err:
+# scan <名称> <镜像> [选项...]
+scan() {
+    local name="$1" img="$2"
+    shift 2
+    "$BIN" -m deep -l "$@" "$img" 2> "$name.err" | tr '\r' '\n' | tee "$name.log" |
+        grep -E '^[0-9]+ +0x' > "$name.out"
+}
+
+echo "DiskAS 回归检查: $BIN"
+
+# 1. 设备末尾截断的候选文件：长度字段指向镜像之外时不读取设备之外的数据，也不输出错误
+image tail.img 1048576
+put tail.img 4096 'MZ'
+put tail.img 4156 '\x00\xff\xff\x7f'                          # e_lfanew 指向镜像之外
+put tail.img 1048376 '\xff\xff\xff\xf0ftypisom'                # ISO-BMFF 盒子超出镜像
+put tail.img 1048448 '\x89PNG\r\n\x1a\n\x7f\xff\xff\xf0IHDR'   # PNG 数据块长度超出镜像
+put tail.img 1048520 'GIF89a\x10\x00\x10\x00\x80'              # GIF 在逻辑屏幕描述之后截断
+put tail.img 1048560 'PK\x03\x04\x14\x00\x00\x00'              # ZIP 本地文件头截断
+scan tail tail.img
+if [ -s tail.err ]; then
+    fail "截断的候选文件不输出错误" tail.err
+else
+    pass "截断的候选文件不输出错误"
+fi
+
+# 比较两次扫描的结果列表: same <说明> <名称1> <名称2>
+same() {
+    if diff "$2.out" "$3.out" > "$3.diff"; then
+        pass "$1"
+    else
+        fail "$1" "$3.diff"
+    fi
+}
+
+# 检查结果数量: count <说明> <名称> <数量>
+count() {
+    local n
+    n=$(wc -l < "$2.out")
+    if [ "$n" -eq "$3" ]; then
+        pass "$1"
+    else
+        echo "找到 $n 个结果，预期 $3 个" > "$2.count"
+        fail "$1" "$2.count"
+    fi
+}
+
+GIF='GIF89a\x01\x00\x01\x00\x00\x00\x00;'
+
+# 2. 分卷镜像：.001/.002 和 .aa/.ab 分段拼接后与单个镜像的结果相同（含跨分段的文件）
+image split.img 2097152
+put split.img 65536 "$GIF"
+put split.img 1048570 "$GIF"                                  # 跨越第一个分段的末尾
+put split.img 1572864 "$GIF"
+scan split split.img
+count "分卷镜像的参照结果" split 3
+head -c 1048576 split.img > split.001
+tail -c +1048577 split.img > split.002
+cp split.001 split.aa
+cp split.002 split.ab
+scan split_num split.001
+same "分卷镜像 .001/.002 拼接" split split_num
+scan split_alpha split.aa
+same "分卷镜像 .aa/.ab 拼接" split split_alpha
+
+# 3. 稀疏镜像：空洞之间的数据区与非稀疏的同一镜像结果相同
+truncate -s 67108864 sparse.img
+put sparse.img 4096 "$GIF"
+put sparse.img 20971520 "$GIF"
+put sparse.img 67104768 "$GIF"
+cp --sparse=never sparse.img dense.img
+scan dense dense.img
+count "非稀疏镜像的参照结果" dense 3
+scan sparse sparse.img
+same "稀疏镜像" dense sparse
+scan sparse_nommap sparse.img --no-mmap
+same "稀疏镜像（不使用内存映射）" dense sparse_nommap
+
+# 4. 坏块图：已知坏区被跳过，待重试的区域重新读取后从坏块图中清除；再次运行结果相同
+image bad.img 2097152
+put bad.img 65536 "$GIF"
+put bad.img 524288 "$GIF"
+put bad.img 1048576 "$GIF"
+printf '0x000000080000 0x000000010000 ?\n0x000000100000 0x000000010000 -\n' > bad.map
+scan bad bad.img --no-mmap --bad-map bad.map
+count "坏块图跳过已知坏区" bad 2
+if grep -v '^#' bad.map | grep -q '^0x000000100000 0x000000010000 -$' &&
+   [ "$(grep -vc '^#' bad.map)" -eq 1 ]; then
+    pass "坏块图保存：重试成功的区域被清除，坏区保留"
+else
+    fail "坏块图保存：重试成功的区域被清除，坏区保留" bad.map
+fi
+scan bad_again bad.img --no-mmap --bad-map bad.map
+same "坏块图重新加载" bad bad_again
+
+# 5. 结果溢出文件：结果超过内存中的分块后与全部保存在内存中时相同，
+#    扫描结束时才确定大小的 JPEG 在溢出文件中原地改写
+printf "$GIF" > block
+truncate -s 512 block
+for i in $(seq 13); do
+    cat block block > block2
+    mv block2 block
+done
+mv block many.img                                             # 8192 个 GIF，每 512 字节一个
+put many.img 0 '\xff\xd8\xff\xe0'                             # 覆盖第一个 GIF
+put many.img 4194302 '\xff\xd9'
+scan many many.img
+# JPEG 所在的第一个 1MB 数据块中位于 JPEG 内部的 2047 个 GIF 不单独报告
+count "大量结果的参照结果" many 6145
+if grep -q '^1 .*4\.00 MB *JPEG' many.out; then
+    pass "扫描结束时确定 JPEG 的大小"
+else
+    fail "扫描结束时确定 JPEG 的大小" many.out
+fi
+scan spill many.img --spill spill.bin
+same "结果溢出到文件" many spill
+if [ "$(head -c 8 spill.bin)" = "DASRESLT" ] &&
+   [ "$(stat -c %s spill.bin)" -eq $((16 + 20 * 6145)) ]; then
+    pass "溢出文件的文件头和记录数"
+else
+    fail "溢出文件的文件头和记录数"
+fi
+
+# 6. 工作线程数不影响结果和顺序
+for n in 1 2 4; do
+    scan "threads$n" many.img --threads "$n"
+done
+same "--threads 1 与默认线程数" many threads1
+same "--threads 2 与默认线程数" many threads2
+same "--threads 4 与默认线程数" many threads4
+
+# 7. 结果数量上限：只保留按偏移排列的前 N 个结果
+scan limited many.img --max-results 100 --threads 4
+head -100 many.out > many_head.out
+same "--max-results 100" many_head limited
+
+# 8. 签名定义文件：新类型和内置类型的描述与恢复文件的扩展名
+image sig.img 65536
+put sig.img 4096 "$GIF"
+put sig.img 8192 'NEWT'
+cat > new.sig << 'EOF'
+sig gif  gif "GIF89a" "GIF Image (89a)"
+sig newt nt  "NEWT" "New Type"
+EOF
+scan sig sig.img --signatures new.sig
+if grep -q '^1 .*GIF Image (89a)' sig.out && grep -q '^2 .*New Type' sig.out; then
+    pass "定义文件中新类型和内置类型的描述"
+else
+    fail "定义文件中新类型和内置类型的描述" sig.out
+fi
+"$BIN" -m deep -r -o sig_recovered --signatures new.sig sig.img > /dev/null 2>&1
+if [ -f sig_recovered/recovered_0001.gif ] && [ -f sig_recovered/recovered_0002.nt ]; then
+    pass "定义文件中类型的恢复文件扩展名"
+else
+    ls sig_recovered > sig_recovered.list 2>&1
+    fail "定义文件中类型的恢复文件扩展名" sig_recovered.list
+fi
+
+# 9. 定义文件中没有 type 行的内置类型沿用内置的大小规则（JPEG 由文件尾确定大小）
+image jpeg.img 4194304
+put jpeg.img 0 '\xff\xd8\xff\xe0'
+put jpeg.img 4194302 '\xff\xd9'
+cat > jpeg.sig << 'EOF'
+sig jpeg jpg FFD8FF "JPEG Image"
+EOF
+scan jpeg jpeg.img --signatures jpeg.sig
+if grep -q '^1 .*4\.00 MB *JPEG Image' jpeg.out; then
+    pass "未声明的内置类型沿用内置的大小规则"
+else
+    fail "未声明的内置类型沿用内置的大小规则" jpeg.out
+fi
+
+# 可重复的伪随机数据（没有 openssl 时使用 /dev/urandom，REPEATABLE 为空）: random <文件> <字节数>
+REPEATABLE=
+random() {
+    if command -v openssl > /dev/null 2>&1; then
+        REPEATABLE=1
+        head -c "$2" /dev/zero | openssl enc -aes-128-ctr -nosalt -K 00112233445566778899aabbccddeeff \
+            -iv 00000000000000000000000000000000 2> /dev/null > "$1"
+    else
+        head -c "$2" /dev/urandom > "$1"
+    fi
+}
+
+# 伪随机数据中放入每个内置签名的魔数：去掉数据中的两字节魔数以免误报的文件覆盖后面的魔数，
+# 每个魔数单独占一个 1MB 数据块（起始位置跨越不同的向量边界），另有跨越数据块边界和位于镜像末尾的魔数
+random noise.img 25165824
+LC_ALL=C sed -e 's/BM/Bm/g' -e 's/MZ/Mz/g' -e 's/\xff\xfb/\xff\xfa/g' noise.img > mixed.img
+i=0
+for magic in '\xff\xd8\xff' '\x89PNG\r\n\x1a\n' 'GIF89a' 'GIF87a' 'BM' '%%PDF-' \
+             '\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1' 'PK\x03\x04' 'PK\x05\x06' 'Rar!\x1a\x07\x00' \
+             'Rar!\x1a\x07\x01\x00' '7z\xbc\xaf\x27\x1c' '\xff\xfb' 'ID3' '\x00\x00\x00\x20ftyp' \
+             'RIFF' '\x00\x00\x00\x20moov' '<!DOCTYPE html' '<html' '<?xml' 'MZ'; do
+    put mixed.img $((i * 1048576 + i * 3 % 32)) "$magic"
+    i=$((i + 1))
+done
+put mixed.img $((23 * 1048576 - 2)) 'GIF89a'
+put mixed.img 25165821 '\xff\xd8\xff'
+
+# 10. 预过滤器的各个实现（含不预过滤）与默认实现的结果相同
+scan prefilter_auto mixed.img
+if [ -n "$REPEATABLE" ]; then
+    count "伪随机数据中的魔数" prefilter_auto 23
+fi
+for isa in avx2 sse2 scalar off; do
+    scan "prefilter_$isa" mixed.img --prefilter "$isa"
+    if grep -q '预过滤器' "prefilter_$isa.err"; then
+        echo "  skip  --prefilter $isa（CPU 不支持）"
+    else
+        same "--prefilter $isa 与默认实现" prefilter_auto "prefilter_$isa"
+    fi
+done
+
+# 11. 匹配器的各个来源与内置数据库的结果相同：定义文件编译的自动机、写入和映射编译缓存
+scan matcher_file mixed.img --signatures "$SOURCE_DIR/signatures/default.sig"
+same "定义文件编译的匹配器与内置数据库" prefilter_auto matcher_file
+scan matcher_compile mixed.img --signatures "$SOURCE_DIR/signatures/default.sig" --signature-cache sig.cache
+same "编译并写入缓存的匹配器与内置数据库" prefilter_auto matcher_compile
+scan matcher_mapped mixed.img --signature-cache sig.cache
+if grep -q 'mapped from cache' matcher_mapped.log; then
+    same "映射编译缓存的匹配器与内置数据库" prefilter_auto matcher_mapped
+else
+    fail "映射编译缓存的匹配器与内置数据库" matcher_mapped.err
+fi
+
+# 小端整数的 printf 转义: le16 <值>, le32 <值>
+le16() {
+    printf '\\x%02x\\x%02x' $(($1 & 255)) $(($1 >> 8 & 255))
+}
+
+le32() {
+    printf '\\x%02x\\x%02x\\x%02x\\x%02x' $(($1 & 255)) $(($1 >> 8 & 255)) $(($1 >> 16 & 255)) $(($1 >> 24 & 255))
+}
+
+# 写入不压缩的 ZIP 本地文件头和数据区，ZIP_NEXT 为下一个文件头的偏移: zip_entry <文件> <偏移> <文件名> <数据长度>
+zip_entry() {
+    local n=${#3}
+    put "$1" "$2" "PK\x03\x04\x14\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00$(le32 "$4")$(le32 "$4")$(le16 "$n")\x00\x00$3"
+    ZIP_NEXT=$(($2 + 30 + n + $4))
+}
+
+# 结果列表中的偏移和类型: types <名称>
+types() {
+    sed -E 's/^[0-9]+ +(0x[0-9a-f]+) +[0-9.]+ [KMG]?B +(.*[^ ]) *$/\1 \2/' "$1.out"
+}
+
+# 12. ZIP、复合文档和 PE 按内容分类（OOXML 的类型由第一个以外的条目决定）
+image classify.img 4194304
+zip_entry classify.img 0 'a.txt' 4
+put classify.img $ZIP_NEXT 'PK\x05\x06'
+zip_entry classify.img 65536 '[Content_Types].xml' 16
+zip_entry classify.img $ZIP_NEXT 'word/document.xml' 8
+put classify.img $ZIP_NEXT 'PK\x05\x06'
+zip_entry classify.img 131072 '[Content_Types].xml' 16
+zip_entry classify.img $ZIP_NEXT 'xl/workbook.xml' 8
+put classify.img $ZIP_NEXT 'PK\x05\x06'
+zip_entry classify.img 196608 'ppt/presentation.xml' 8
+put classify.img $ZIP_NEXT 'PK\x05\x06'
+# 复合文档：512 字节扇区，扇区 0 为 FAT，扇区 1 为目录（根目录项和 Workbook 数据流）
+put classify.img 1048576 '\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1'
+put classify.img $((1048576 + 0x1e)) '\x09\x00'
+put classify.img $((1048576 + 0x30)) '\x01\x00\x00\x00'
+put classify.img $((1048576 + 0x4c)) '\x00\x00\x00\x00'
+put classify.img $((1048576 + 512)) '\xfd\xff\xff\xff\xfe\xff\xff\xff'
+put classify.img $((1048576 + 1024)) 'R\x00o\x00o\x00t\x00'
+put classify.img $((1048576 + 1024 + 0x40)) '\x0a\x00\x05'
+put classify.img $((1048576 + 1152)) 'W\x00o\x00r\x00k\x00b\x00o\x00o\x00k\x00'
+put classify.img $((1048576 + 1152 + 0x40)) '\x12\x00\x02'
+# PE：e_lfanew 指向 PE 签名，COFF 头的 Characteristics 决定 DLL 和 EXE
+put classify.img 2097152 'MZ'
+put classify.img $((2097152 + 0x3c)) '\x80\x00\x00\x00'
+put classify.img $((2097152 + 0x80)) 'PE\x00\x00\x4c\x01'
+put classify.img $((2097152 + 0x80 + 22)) '\x02\x21'
+put classify.img 3145728 'MZ'
+put classify.img $((3145728 + 0x3c)) '\x80\x00\x00\x00'
+put classify.img $((3145728 + 0x80)) 'PE\x00\x00\x4c\x01'
+put classify.img $((3145728 + 0x80 + 22)) '\x02\x01'
+scan classify classify.img
+types classify > classify.types
+cat > classify.expected << 'EOF'
+0x0 ZIP Archive
+0x10000 MS Word Document (DOCX)
+0x20000 MS Excel Spreadsheet (XLSX)
+0x30000 MS PowerPoint Presentation (PPTX)
+0x100000 MS Excel Spreadsheet
+0x200000 Windows DLL
+0x300000 Windows Executable
+EOF
+if diff classify.expected classify.types > classify.diff; then
+    pass "ZIP、OOXML、复合文档和 PE 的分类"
+else
+    fail "ZIP、OOXML、复合文档和 PE 的分类" classify.diff
+fi
+
+# 在偏移处写入重复的文本: fill <文件> <偏移> <字节数> <文本>
+fill() {
+    yes "$4" | tr -d '\n' | head -c "$3" | dd of="$1" bs=65536 seek="$2" oflag=seek_bytes conv=notrunc status=none
+}
+
+# 13. 流式文本检测：跨越数据块边界的文本、在边界处拆开的 UTF-8 字符、按字节熵排除的填充
+image text.img 3145728
+fill text.img $((1048576 - 1500)) 3000 'The quick brown fox jumps over the lazy dog 0123456789. '
+fill text.img $((2097151 - 1200)) 1200 'x'
+fill text.img 2097151 3000 '中文文本恢复测试。'                  # 第一个字符跨越 2MB 边界
+fill text.img 2621440 4000 ' '
+fill text.img 2800000 6000 'ab'                                # 字节熵 1 位
+scan text text.img
+cat > text.expected << 'EOF'
+0xffa24 Text File
+0x1ffb4f Text File
+EOF
+types text > text.types
+if diff text.expected text.types > text.diff && grep -q '^1 .*2\.93 KB' text.out &&
+   grep -q '^2 .*4\.10 KB' text.out; then
+    pass "跨越数据块边界的文本和 UTF-8 字符"
+else
+    types text >> text.diff
+    fail "跨越数据块边界的文本和 UTF-8 字符" text.diff
+fi
+scan text_entropy text.img --text-entropy 0.5
+if grep -q '^3 .*0x2ab980 .*5\.86 KB *Text File' text_entropy.out && [ "$(wc -l < text_entropy.out)" -eq 3 ]; then
+    pass "--text-entropy 决定是否排除低熵填充"
+else
+    fail "--text-entropy 决定是否排除低熵填充" text_entropy.out
+fi
+
+# 14. 类型过滤在分类之后进行：魔数相同的类型按分类结果保留或排除
+scan types_docx classify.img --types docx
+echo '0x10000 MS Word Document (DOCX)' > types_docx.expected
+types types_docx > types_docx.types
+if diff types_docx.expected types_docx.types > types_docx.diff; then
+    pass "--types docx 排除同为 ZIP 魔数的其他类型"
+else
+    fail "--types docx 排除同为 ZIP 魔数的其他类型" types_docx.diff
+fi
+scan types_exclude classify.img --exclude-types zip,dll
+grep -v -e 'ZIP Archive' -e 'DLL' classify.expected > types_exclude.expected
+types types_exclude > types_exclude.types
+if diff types_exclude.expected types_exclude.types > types_exclude.diff; then
+    pass "--exclude-types zip,dll 保留同为 ZIP 魔数的 OOXML 类型"
+else
+    fail "--exclude-types zip,dll 保留同为 ZIP 魔数的 OOXML 类型" types_exclude.diff
+fi
+
+# 15. 对齐扫描：只保留从对齐位置开始的文件
+image align.img 1048576
+put align.img 4096 "$GIF"
+put align.img 4200 "$GIF"                                       # 不对齐
+put align.img 8704 "$GIF"                                       # 512 字节对齐
+scan align_all align.img
+scan align align.img --align 512
+printf '0x1000 GIF Image (89a)\n0x2200 GIF Image (89a)\n' > align.expected
+types align > align.types
+if diff align.expected align.types > align.diff && grep -q ' 0x1068 ' align_all.out; then
+    pass "--align 512 丢弃不对齐的文件头"
+else
+    fail "--align 512 丢弃不对齐的文件头" align.diff
+fi
+
+# 16. 跳过低价值区域：零填充区域中的文件头仍然找到，高熵区域只检查扇区对齐的位置
+image barren.img 1048576
+put barren.img 4100 "$GIF"
+LC_ALL=C sed -e 's/BM/Bm/g' -e 's/MZ/Mz/g' -e 's/\xff\xfb/\xff\xfa/g' noise.img | head -c 1048576 >> barren.img
+put barren.img $((1048576 + 4096)) "$GIF"
+put barren.img $((1048576 + 8195)) "$GIF"                       # 高熵区域中不对齐
+scan barren_all barren.img
+scan barren barren.img --skip-barren
+if grep -q ' 0x102003 ' barren_all.out && grep -q ' 0x1004 ' barren.out &&
+   grep -q ' 0x101000 ' barren.out && ! grep -q ' 0x102003 ' barren.out; then
+    pass "--skip-barren 保留对齐的文件头，丢弃高熵区域中不对齐的文件头"
+else
+    cat barren_all.out barren.out > barren.diff
+    fail "--skip-barren 保留对齐的文件头，丢弃高熵区域中不对齐的文件头" barren.diff
+fi
+
+echo ""
+echo "通过 $PASSED 项，失败 $FAILED 项"
+[ "$FAILED" -eq 0 ]
@@ -0,0 +1,477 @@
+#define _GNU_SOURCE
+#include "disk_aio.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+// 检测 io_uring 支持（可通过 -DDISKAS_NO_IO_URING 关闭）
+#if defined(__linux__) && !defined(DISKAS_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define DISK_AIO_HAVE_URING 1
+#endif
+#endif
+#endif
+
+#define DISK_AIO_BUFFER_ALIGN 4096
+
+// 槽位状态
+typedef struct {
+    uint64_t offset;          // 实际读取偏移（直接 I/O 下已对齐）
+    size_t size;              // 实际读取大小（直接 I/O 下已对齐）
+    uint64_t req_offset;      // 调用者请求的偏移
+    size_t req_size;          // 调用者请求的大小
+    size_t skew;              // 请求偏移相对实际偏移的距离
+    void* user_data;          // 用户数据
+    uint64_t submitted_ns;    // 提交时间（用于限速器的延迟反馈）
+    int pending;              // 是否在途
+} aio_slot_t;
+
+#ifdef DISK_AIO_HAVE_URING
+// io_uring 环形队列（直接使用系统调用，不依赖 liburing）
+typedef struct {
+    int fd;
+    void* sq_ptr;
+    size_t sq_map_size;
+    void* cq_ptr;
+    size_t cq_map_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_map_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+} uring_t;
+#endif
+
+struct disk_aio {
+    disk_handle_t* handle;    // 磁盘句柄
+    uint32_t depth;           // 队列深度
+    size_t buffer_size;       // 槽位缓冲区大小（调用者可见）
+    size_t align;             // 直接 I/O 对齐（0 表示无需对齐）
+    uint8_t** buffers;        // 槽位缓冲区
+    aio_slot_t* slots;        // 槽位状态
+    uint32_t inflight;        // 在途请求数
+    uint32_t* fifo;           // 同步执行的请求队列（同步模式，或涉及已知坏区的请求）
+    uint32_t fifo_head;       // 队首位置
+    uint32_t fifo_count;      // 队列长度
+#ifdef DISK_AIO_HAVE_URING
+    int use_uring;            // 是否使用 io_uring
+    int fixed_buffers;        // 缓冲区是否已注册
+    struct iovec* iovecs;     // 缓冲区向量
+    uring_t ring;             // io_uring 队列
+#endif
+};
+
+#ifdef DISK_AIO_HAVE_URING
+static int uring_setup(uring_t* ring, uint32_t entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_size > ring->sq_map_size) {
+            ring->sq_map_size = ring->cq_map_size;
+        }
+        ring->cq_map_size = ring->sq_map_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        close(ring->fd);
+        return -1;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            munmap(ring->sq_ptr, ring->sq_map_size);
+            close(ring->fd);
+            return -1;
+        }
+    }
+
+    ring->sqes_map_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_map_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_map_size);
+        }
+        munmap(ring->sq_ptr, ring->sq_map_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    uint8_t* sq = (uint8_t*)ring->sq_ptr;
+    uint8_t* cq = (uint8_t*)ring->cq_ptr;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+static void uring_teardown(uring_t* ring) {
+    munmap(ring->sqes, ring->sqes_map_size);
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_map_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_map_size);
+    close(ring->fd);
+}
+
+static int uring_enter(uring_t* ring, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    for (;;) {
+        long ret = syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete,
+                           flags, NULL, 0);
+        if (ret >= 0) {
+            return (int)ret;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static int uring_submit_read(disk_aio_t* aio, uint32_t slot, uint64_t offset, size_t size) {
+    uring_t* ring = &aio->ring;
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+
+    // 分卷镜像：请求提交到所在分段，超出分段的部分由短读取补齐逻辑完成
+    uint64_t local;
+    uint64_t remaining;
+    int fd = disk_segment_at(aio->handle, offset, &local, &remaining);
+    if (fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (size > remaining) {
+        size = (size_t)remaining;
+    }
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = fd;
+    sqe->off = local;
+    sqe->user_data = slot;
+    if (aio->fixed_buffers) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)aio->buffers[slot];
+        sqe->len = (uint32_t)size;
+        sqe->buf_index = (uint16_t)slot;
+    } else {
+        aio->iovecs[slot].iov_len = size;
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = (uint64_t)(uintptr_t)&aio->iovecs[slot];
+        sqe->len = 1;
+    }
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    return uring_enter(ring, 1, 0, 0) == 1 ? 0 : -1;
+}
+
+// blocked 输出是否需要等待：完成事件已在队列中时无法得知其实际完成时间
+static int uring_reap(disk_aio_t* aio, uint32_t* slot, ssize_t* result, int* blocked) {
+    uring_t* ring = &aio->ring;
+
+    *blocked = 0;
+    for (;;) {
+        unsigned head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+            *slot = (uint32_t)cqe->user_data;
+            *result = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+
+        *blocked = 1;
+        if (uring_enter(ring, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+            return -1;
+        }
+    }
+}
+#endif
+
+disk_aio_t* disk_aio_create(disk_handle_t* handle, uint32_t queue_depth, size_t buffer_size) {
+    if (!handle || buffer_size == 0) {
+        return NULL;
+    }
+
+    if (queue_depth == 0) {
+        queue_depth = DISK_AIO_DEFAULT_DEPTH;
+    }
+    if (queue_depth > DISK_AIO_MAX_DEPTH) {
+        queue_depth = DISK_AIO_MAX_DEPTH;
+    }
+
+    disk_aio_t* aio = (disk_aio_t*)calloc(1, sizeof(disk_aio_t));
+    if (!aio) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    aio->handle = handle;
+    aio->depth = queue_depth;
+    aio->buffer_size = buffer_size;
+    aio->align = handle->io_align;
+
+    // 直接 I/O 下请求两端都可能扩展到扇区边界，预留额外空间
+    size_t alloc_align = DISK_AIO_BUFFER_ALIGN;
+    size_t alloc_size = buffer_size;
+    if (aio->align) {
+        if (aio->align > alloc_align) {
+            alloc_align = aio->align;
+        }
+        alloc_size = (buffer_size + 2 * aio->align - 1) / aio->align * aio->align;
+    }
+    aio->buffers = (uint8_t**)calloc(queue_depth, sizeof(uint8_t*));
+    aio->slots = (aio_slot_t*)calloc(queue_depth, sizeof(aio_slot_t));
+    aio->fifo = (uint32_t*)calloc(queue_depth, sizeof(uint32_t));
+    if (!aio->buffers || !aio->slots || !aio->fifo) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        disk_aio_destroy(aio);
+        return NULL;
+    }
+
+    // 分配页对齐的缓冲区，便于注册到内核
+    for (uint32_t i = 0; i < queue_depth; i++) {
+        void* buffer = NULL;
+        if (posix_memalign(&buffer, alloc_align, alloc_size) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            disk_aio_destroy(aio);
+            return NULL;
+        }
+        aio->buffers[i] = (uint8_t*)buffer;
+    }
+
+#ifdef DISK_AIO_HAVE_URING
+    aio->iovecs = (struct iovec*)calloc(queue_depth, sizeof(struct iovec));
+    if (aio->iovecs && uring_setup(&aio->ring, queue_depth) == 0) {
+        aio->use_uring = 1;
+        for (uint32_t i = 0; i < queue_depth; i++) {
+            aio->iovecs[i].iov_base = aio->buffers[i];
+            aio->iovecs[i].iov_len = alloc_size;
+        }
+
+        // 注册缓冲区失败（如 RLIMIT_MEMLOCK 不足）时退化为普通 readv
+        if (syscall(__NR_io_uring_register, aio->ring.fd, IORING_REGISTER_BUFFERS,
+                    aio->iovecs, queue_depth) == 0) {
+            aio->fixed_buffers = 1;
+        }
+    }
+#endif
+
+    return aio;
+}
+
+void disk_aio_destroy(disk_aio_t* aio) {
+    if (!aio) {
+        return;
+    }
+
+    // 等待所有在途请求完成，避免内核写入已释放的缓冲区
+    disk_aio_event_t event;
+    while (aio->inflight > 0 && disk_aio_wait(aio, &event) == 0) {
+    }
+
+#ifdef DISK_AIO_HAVE_URING
+    if (aio->use_uring) {
+        uring_teardown(&aio->ring);
+    }
+    free(aio->iovecs);
+#endif
+
+    if (aio->buffers) {
+        for (uint32_t i = 0; i < aio->depth; i++) {
+            free(aio->buffers[i]);
+        }
+    }
+
+    free(aio->buffers);
+    free(aio->slots);
+    free(aio->fifo);
+    free(aio);
+}
+
+uint8_t* disk_aio_buffer(disk_aio_t* aio, uint32_t slot) {
+    if (!aio || slot >= aio->depth) {
+        return NULL;
+    }
+    return aio->buffers[slot];
+}
+
+uint32_t disk_aio_depth(const disk_aio_t* aio) {
+    return aio ? aio->depth : 0;
+}
+
+uint32_t disk_aio_inflight(const disk_aio_t* aio) {
+    return aio ? aio->inflight : 0;
+}
+
+const char* disk_aio_backend_name(const disk_aio_t* aio) {
+#ifdef DISK_AIO_HAVE_URING
+    if (aio && aio->use_uring) {
+        return "io_uring";
+    }
+#else
+    (void)aio;
+#endif
+    return "sync";
+}
+
+int disk_aio_submit(disk_aio_t* aio, uint32_t slot, uint64_t offset,
+                    size_t size, void* user_data) {
+    if (!aio || slot >= aio->depth || aio->slots[slot].pending) {
+        return -1;
+    }
+
+    uint64_t disk_size = disk_get_size(aio->handle);
+    if (offset >= disk_size || size == 0 || size > aio->buffer_size) {
+        return -1;
+    }
+
+    // 调整读取大小，防止超出设备边界
+    if (offset + size > disk_size) {
+        size = disk_size - offset;
+    }
+
+    aio_slot_t* s = &aio->slots[slot];
+    s->req_offset = offset;
+    s->req_size = size;
+    s->user_data = user_data;
+    s->skew = 0;
+
+    // 直接 I/O：偏移向下、长度向上对齐到扇区边界
+    if (aio->align) {
+        s->skew = (size_t)(offset % aio->align);
+        offset -= s->skew;
+        size = (s->skew + size + aio->align - 1) / aio->align * aio->align;
+    }
+
+    s->offset = offset;
+    s->size = size;
+
+#ifdef DISK_AIO_HAVE_URING
+    // 涉及已知坏区的请求交给 disk_read() 的容错路径，避免内核反复重试坏扇区
+    disk_bad_range_t bad;
+    if (aio->use_uring && !disk_badmap_lookup(aio->handle->badmap, offset, offset + size, &bad)) {
+        // 同步后端经 disk_read() 读取，已在磁盘层计入限速
+        disk_throttle_acquire(aio->handle->throttle, size);
+        s->submitted_ns = utils_monotonic_ns();
+        if (uring_submit_read(aio, slot, offset, size) < 0) {
+            fprintf(stderr, "Error: io_uring submit failed: %s\n", strerror(errno));
+            return -1;
+        }
+        s->pending = 1;
+        aio->inflight++;
+        return 0;
+    }
+#endif
+
+    // 同步执行：先入队，在 disk_aio_wait() 中按提交顺序执行
+    aio->fifo[(aio->fifo_head + aio->fifo_count) % aio->depth] = slot;
+    aio->fifo_count++;
+    s->pending = 1;
+    aio->inflight++;
+    return 0;
+}
+
+int disk_aio_wait(disk_aio_t* aio, disk_aio_event_t* event) {
+    if (!aio || !event || aio->inflight == 0) {
+        return -1;
+    }
+
+    uint32_t slot;
+    ssize_t result;
+
+#ifdef DISK_AIO_HAVE_URING
+    if (aio->use_uring && aio->fifo_count == 0) {
+        int blocked;
+        if (uring_reap(aio, &slot, &result, &blocked) < 0 || slot >= aio->depth) {
+            fprintf(stderr, "Error: io_uring wait failed: %s\n", strerror(errno));
+            return -1;
+        }
+        if (result < 0 && aio->handle->badmap) {
+            // 容错模式：经 disk_read() 重新读取，出错区间被跳过并记录
+            result = disk_read(aio->handle, aio->slots[slot].offset,
+                               aio->buffers[slot], aio->slots[slot].size);
+        } else if (result < 0) {
+            fprintf(stderr, "Error: Read failed: %s\n", strerror((int)-result));
+            result = -1;
+        } else if (blocked && aio->handle->throttle) {
+            // 只有等待到的完成事件才能准确反映读取延迟
+            disk_throttle_record(aio->handle->throttle, (size_t)result,
+                                 utils_monotonic_ns() - aio->slots[slot].submitted_ns);
+        }
+    } else
+#endif
+    {
+        slot = aio->fifo[aio->fifo_head];
+        aio->fifo_head = (aio->fifo_head + 1) % aio->depth;
+        aio->fifo_count--;
+        result = disk_read(aio->handle, aio->slots[slot].offset,
+                           aio->buffers[slot], aio->slots[slot].size);
+    }
+
+    aio_slot_t* s = &aio->slots[slot];
+
+    // 短读取时同步补齐剩余部分
+    if (result >= 0 && (size_t)result < s->size &&
+        s->offset + (uint64_t)result < disk_get_size(aio->handle)) {
+        ssize_t rest = disk_read(aio->handle, s->offset + result,
+                                 aio->buffers[slot] + result, s->size - result);
+        if (rest > 0) {
+            result += rest;
+        }
+    }
+
+    // 换算回调用者请求的范围
+    if (result >= 0) {
+        result = ((size_t)result > s->skew) ? result - (ssize_t)s->skew : 0;
+        if ((size_t)result > s->req_size) {
+            result = (ssize_t)s->req_size;
+        }
+    }
+
+    s->pending = 0;
+    aio->inflight--;
+
+    event->slot = slot;
+    event->offset = s->req_offset;
+    event->result = result;
+    event->data = aio->buffers[slot] + s->skew;
+    event->user_data = s->user_data;
+    return 0;
+}
@@ -0,0 +1,411 @@
+#define _GNU_SOURCE
+#include "disk_badmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+struct disk_badmap {
+    pthread_mutex_t lock;
+    char* path;                  // 文件路径（可为 NULL）
+    uint64_t device_size;        // 设备大小
+    disk_bad_range_t* ranges;    // 按偏移升序、互不重叠的区间
+    size_t count;
+    size_t capacity;
+    uint64_t skip;               // 当前跳跃距离
+    uint64_t read_errors;        // 读取错误次数
+    int dirty;                   // 有未保存的修改
+    time_t last_save;            // 上次保存时间
+};
+
+static int reserve(disk_badmap_t* map, size_t needed) {
+    if (needed <= map->capacity) {
+        return 0;
+    }
+
+    size_t capacity = map->capacity ? map->capacity * 2 : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    disk_bad_range_t* grown = (disk_bad_range_t*)realloc(map->ranges,
+                                                          capacity * sizeof(disk_bad_range_t));
+    if (!grown) {
+        return -1;
+    }
+    map->ranges = grown;
+    map->capacity = capacity;
+    return 0;
+}
+
+// 将 [offset, offset + length) 设为指定状态，state 为 0 表示清除
+// 与新区间重叠的原有区间被截断，相邻的同状态区间合并
+static int set_range(disk_badmap_t* map, uint64_t offset, uint64_t length, int state) {
+    uint64_t end = offset + length;
+    if (end > map->device_size) {
+        end = map->device_size;
+    }
+    if (offset >= end) {
+        return 0;
+    }
+
+    // 最坏情况：一个原有区间被拆成两段，再插入一个新区间
+    if (reserve(map, map->count + 2) < 0) {
+        return -1;
+    }
+
+    disk_bad_range_t* out = (disk_bad_range_t*)malloc((map->count + 2) * sizeof(disk_bad_range_t));
+    if (!out) {
+        return -1;
+    }
+
+    size_t n = 0;
+    int inserted = (state == 0);
+    for (size_t i = 0; i < map->count; i++) {
+        disk_bad_range_t r = map->ranges[i];
+        uint64_t r_end = r.offset + r.length;
+
+        if (!inserted && r.offset >= offset) {
+            out[n++] = (disk_bad_range_t){ offset, end - offset, (disk_bad_state_t)state };
+            inserted = 1;
+        }
+
+        if (r_end <= offset || r.offset >= end) {
+            out[n++] = r;
+            continue;
+        }
+        if (r.offset < offset) {
+            out[n++] = (disk_bad_range_t){ r.offset, offset - r.offset, r.state };
+        }
+        if (!inserted) {
+            out[n++] = (disk_bad_range_t){ offset, end - offset, (disk_bad_state_t)state };
+            inserted = 1;
+        }
+        if (r_end > end) {
+            out[n++] = (disk_bad_range_t){ end, r_end - end, r.state };
+        }
+    }
+    if (!inserted) {
+        out[n++] = (disk_bad_range_t){ offset, end - offset, (disk_bad_state_t)state };
+    }
+
+    // 合并相邻的同状态区间
+    map->count = 0;
+    for (size_t i = 0; i < n; i++) {
+        disk_bad_range_t* last = map->count ? &map->ranges[map->count - 1] : NULL;
+        if (last && last->state == out[i].state && last->offset + last->length == out[i].offset) {
+            last->length += out[i].length;
+        } else {
+            map->ranges[map->count++] = out[i];
+        }
+    }
+
+    free(out);
+    map->dirty = 1;
+    return 0;
+}
+
+static int write_map(disk_badmap_t* map) {
+    size_t len = strlen(map->path);
+    char* tmp_path = (char*)malloc(len + 5);
+    if (!tmp_path) {
+        return -1;
+    }
+    snprintf(tmp_path, len + 5, "%s.tmp", map->path);
+
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot write bad-block map '%s': %s\n", tmp_path, strerror(errno));
+        free(tmp_path);
+        return -1;
+    }
+
+    fprintf(fp, "# DiskAS bad-block map: offset size status (?=skipped, -=unreadable)\n");
+    fprintf(fp, "# device size 0x%llx\n", (unsigned long long)map->device_size);
+    for (size_t i = 0; i < map->count; i++) {
+        fprintf(fp, "0x%012llx 0x%012llx %c\n",
+                (unsigned long long)map->ranges[i].offset,
+                (unsigned long long)map->ranges[i].length,
+                (char)map->ranges[i].state);
+    }
+
+    int ok = (fflush(fp) == 0);
+    ok = (fclose(fp) == 0) && ok;
+    if (ok && rename(tmp_path, map->path) < 0) {
+        fprintf(stderr, "Error: Cannot replace bad-block map '%s': %s\n", map->path, strerror(errno));
+        ok = 0;
+    }
+    if (!ok) {
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    if (!ok) {
+        return -1;
+    }
+
+    map->dirty = 0;
+    map->last_save = time(NULL);
+    return 0;
+}
+
+static void load_map(disk_badmap_t* map, FILE* fp) {
+    char line[256];
+    int line_no = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        unsigned long long offset;
+        unsigned long long length;
+        char status;
+        if (sscanf(line, "%llx %llx %c", &offset, &length, &status) != 3 ||
+            (status != DISK_BAD_SKIPPED && status != DISK_BAD_UNREADABLE)) {
+            fprintf(stderr, "Warning: Ignoring malformed bad-block map line %d\n", line_no);
+            continue;
+        }
+        set_range(map, offset, length, status);
+    }
+}
+
+// 有未保存的修改且距上次保存超过间隔时保存（调用者持有锁）
+static void autosave(disk_badmap_t* map) {
+    if (map->path && map->dirty && time(NULL) - map->last_save >= DISK_BADMAP_SAVE_INTERVAL) {
+        write_map(map);
+    }
+}
+
+disk_badmap_t* disk_badmap_create(const char* path, uint64_t device_size) {
+    disk_badmap_t* map = (disk_badmap_t*)calloc(1, sizeof(disk_badmap_t));
+    if (!map) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    pthread_mutex_init(&map->lock, NULL);
+    map->device_size = device_size;
+    map->skip = DISK_BADMAP_MIN_SKIP;
+    map->last_save = time(NULL);
+
+    if (path) {
+        map->path = strdup(path);
+        if (!map->path) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            disk_badmap_destroy(map);
+            return NULL;
+        }
+
+        FILE* fp = fopen(path, "r");
+        if (fp) {
+            load_map(map, fp);
+            fclose(fp);
+            map->dirty = 0;
+            printf("Loaded bad-block map: %s (%zu ranges)\n", path, map->count);
+        } else if (errno != ENOENT) {
+            fprintf(stderr, "Error: Cannot read bad-block map '%s': %s\n", path, strerror(errno));
+            disk_badmap_destroy(map);
+            return NULL;
+        }
+    }
+
+    return map;
+}
+
+void disk_badmap_destroy(disk_badmap_t* map) {
+    if (!map) {
+        return;
+    }
+
+    if (map->path && map->dirty) {
+        write_map(map);
+    }
+
+    pthread_mutex_destroy(&map->lock);
+    free(map->ranges);
+    free(map->path);
+    free(map);
+}
+
+int disk_badmap_save(disk_badmap_t* map) {
+    if (!map || !map->path) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&map->lock);
+    int ret = write_map(map);
+    pthread_mutex_unlock(&map->lock);
+    return ret;
+}
+
+void disk_badmap_mark(disk_badmap_t* map, uint64_t offset, uint64_t length,
+                      disk_bad_state_t state) {
+    if (!map) {
+        return;
+    }
+
+    pthread_mutex_lock(&map->lock);
+    set_range(map, offset, length, state);
+    autosave(map);
+    pthread_mutex_unlock(&map->lock);
+}
+
+void disk_badmap_clear(disk_badmap_t* map, uint64_t offset, uint64_t length) {
+    if (!map) {
+        return;
+    }
+
+    pthread_mutex_lock(&map->lock);
+    set_range(map, offset, length, 0);
+    autosave(map);
+    pthread_mutex_unlock(&map->lock);
+}
+
+int disk_badmap_lookup(disk_badmap_t* map, uint64_t offset, uint64_t end,
+                       disk_bad_range_t* range) {
+    if (!map || !range || offset >= end) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&map->lock);
+
+    // 二分查找第一个结束位置大于 offset 的区间
+    size_t low = 0;
+    size_t high = map->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (map->ranges[mid].offset + map->ranges[mid].length <= offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    int found = (low < map->count && map->ranges[low].offset < end);
+    if (found) {
+        *range = map->ranges[low];
+    }
+
+    pthread_mutex_unlock(&map->lock);
+    return found;
+}
+
+int disk_badmap_collect(disk_badmap_t* map, uint64_t start, uint64_t end,
+                        disk_bad_state_t state, disk_bad_range_t** ranges, size_t* count) {
+    if (!map || !ranges || !count) {
+        return -1;
+    }
+
+    *ranges = NULL;
+    *count = 0;
+
+    pthread_mutex_lock(&map->lock);
+
+    size_t n = 0;
+    for (size_t i = 0; i < map->count; i++) {
+        const disk_bad_range_t* r = &map->ranges[i];
+        if (r->state == state && r->offset < end && r->offset + r->length > start) {
+            n++;
+        }
+    }
+
+    if (n > 0) {
+        *ranges = (disk_bad_range_t*)malloc(n * sizeof(disk_bad_range_t));
+        if (!*ranges) {
+            pthread_mutex_unlock(&map->lock);
+            return -1;
+        }
+
+        for (size_t i = 0; i < map->count; i++) {
+            disk_bad_range_t r = map->ranges[i];
+            if (r.state != state || r.offset >= end || r.offset + r.length <= start) {
+                continue;
+            }
+            uint64_t r_start = r.offset < start ? start : r.offset;
+            uint64_t r_end = r.offset + r.length > end ? end : r.offset + r.length;
+            (*ranges)[(*count)++] = (disk_bad_range_t){ r_start, r_end - r_start, r.state };
+        }
+    }
+
+    pthread_mutex_unlock(&map->lock);
+    return 0;
+}
+
+uint64_t disk_badmap_count(disk_badmap_t* map, uint64_t offset, uint64_t size) {
+    if (!map) {
+        return 0;
+    }
+
+    uint64_t end = offset + size;
+    uint64_t total = 0;
+
+    pthread_mutex_lock(&map->lock);
+    for (size_t i = 0; i < map->count; i++) {
+        const disk_bad_range_t* r = &map->ranges[i];
+        if (r->offset >= end) {
+            break;
+        }
+        uint64_t r_end = r->offset + r->length;
+        if (r_end <= offset) {
+            continue;
+        }
+        total += (r_end < end ? r_end : end) - (r->offset > offset ? r->offset : offset);
+    }
+    pthread_mutex_unlock(&map->lock);
+
+    return total;
+}
+
+uint64_t disk_badmap_next_skip(disk_badmap_t* map) {
+    if (!map) {
+        return DISK_BADMAP_MIN_SKIP;
+    }
+
+    pthread_mutex_lock(&map->lock);
+    uint64_t skip = map->skip;
+    map->skip = skip * 2 > DISK_BADMAP_MAX_SKIP ? DISK_BADMAP_MAX_SKIP : skip * 2;
+    map->read_errors++;
+    pthread_mutex_unlock(&map->lock);
+    return skip;
+}
+
+void disk_badmap_reset_skip(disk_badmap_t* map) {
+    if (!map) {
+        return;
+    }
+
+    pthread_mutex_lock(&map->lock);
+    map->skip = DISK_BADMAP_MIN_SKIP;
+    pthread_mutex_unlock(&map->lock);
+}
+
+void disk_badmap_get_stats(disk_badmap_t* map, disk_badmap_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(disk_badmap_stats_t));
+    if (!map) {
+        return;
+    }
+
+    pthread_mutex_lock(&map->lock);
+    stats->ranges = map->count;
+    stats->read_errors = map->read_errors;
+    for (size_t i = 0; i < map->count; i++) {
+        if (map->ranges[i].state == DISK_BAD_SKIPPED) {
+            stats->skipped_bytes += map->ranges[i].length;
+        } else {
+            stats->unreadable_bytes += map->ranges[i].length;
+        }
+    }
+    pthread_mutex_unlock(&map->lock);
+}
+
+const char* disk_badmap_path(const disk_badmap_t* map) {
+    return map ? map->path : NULL;
+}
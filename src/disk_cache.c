@@ -0,0 +1,282 @@
+#include "disk_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// 缓存条目（数据紧跟在结构体之后）
+typedef struct cache_entry {
+    uint64_t block;              // 块号
+    size_t size;                 // 有效数据长度
+    struct cache_entry* hnext;   // 哈希链
+    struct cache_entry* prev;    // LRU 链表（靠近表头为最近使用）
+    struct cache_entry* next;
+    uint8_t data[];
+} cache_entry_t;
+
+// 缓存分片
+typedef struct {
+    pthread_mutex_t lock;
+    cache_entry_t** buckets;     // 哈希桶
+    size_t bucket_mask;          // 桶数量 - 1
+    cache_entry_t* head;         // 最近使用
+    cache_entry_t* tail;         // 最久未使用
+    size_t count;                // 当前条目数
+    size_t capacity;             // 最大条目数
+    disk_cache_stats_t stats;    // 分片统计
+} cache_shard_t;
+
+struct disk_cache {
+    size_t block_size;           // 块大小
+    uint32_t shard_count;        // 分片数量
+    cache_shard_t* shards;       // 分片数组
+};
+
+static uint64_t hash_block(uint64_t block) {
+    // 64 位混合函数，使相邻块分散到不同分片
+    block ^= block >> 33;
+    block *= 0xff51afd7ed558ccdULL;
+    block ^= block >> 33;
+    return block;
+}
+
+static cache_shard_t* shard_for(disk_cache_t* cache, uint64_t hash) {
+    return &cache->shards[hash % cache->shard_count];
+}
+
+static void lru_unlink(cache_shard_t* shard, cache_entry_t* entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        shard->head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        shard->tail = entry->prev;
+    }
+    entry->prev = entry->next = NULL;
+}
+
+static void lru_push_front(cache_shard_t* shard, cache_entry_t* entry) {
+    entry->prev = NULL;
+    entry->next = shard->head;
+    if (shard->head) {
+        shard->head->prev = entry;
+    }
+    shard->head = entry;
+    if (!shard->tail) {
+        shard->tail = entry;
+    }
+}
+
+static cache_entry_t* shard_find(cache_shard_t* shard, uint64_t block, uint64_t hash) {
+    cache_entry_t* entry = shard->buckets[(hash >> 8) & shard->bucket_mask];
+    while (entry && entry->block != block) {
+        entry = entry->hnext;
+    }
+    return entry;
+}
+
+static void shard_unhash(cache_shard_t* shard, cache_entry_t* entry) {
+    cache_entry_t** link = &shard->buckets[(hash_block(entry->block) >> 8) & shard->bucket_mask];
+    while (*link && *link != entry) {
+        link = &(*link)->hnext;
+    }
+    if (*link) {
+        *link = entry->hnext;
+    }
+}
+
+disk_cache_t* disk_cache_create(size_t block_size, size_t capacity, uint32_t shards) {
+    if (block_size == 0 || capacity < block_size) {
+        return NULL;
+    }
+
+    if (shards == 0) {
+        shards = DISK_CACHE_DEFAULT_SHARDS;
+    }
+
+    size_t total_entries = capacity / block_size;
+    if (total_entries < shards) {
+        shards = (uint32_t)total_entries;
+    }
+
+    disk_cache_t* cache = (disk_cache_t*)calloc(1, sizeof(disk_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+
+    cache->block_size = block_size;
+    cache->shard_count = shards;
+    cache->shards = (cache_shard_t*)calloc(shards, sizeof(cache_shard_t));
+    if (!cache->shards) {
+        free(cache);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < shards; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        shard->capacity = total_entries / shards;
+
+        // 桶数量取不小于容量的 2 的幂
+        size_t buckets = 1;
+        while (buckets < shard->capacity) {
+            buckets <<= 1;
+        }
+        shard->bucket_mask = buckets - 1;
+        shard->buckets = (cache_entry_t**)calloc(buckets, sizeof(cache_entry_t*));
+        pthread_mutex_init(&shard->lock, NULL);
+
+        if (!shard->buckets) {
+            cache->shard_count = i + 1;
+            disk_cache_destroy(cache);
+            return NULL;
+        }
+    }
+
+    return cache;
+}
+
+void disk_cache_destroy(disk_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < cache->shard_count; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        cache_entry_t* entry = shard->head;
+        while (entry) {
+            cache_entry_t* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+        free(shard->buckets);
+        pthread_mutex_destroy(&shard->lock);
+    }
+
+    free(cache->shards);
+    free(cache);
+}
+
+size_t disk_cache_block_size(const disk_cache_t* cache) {
+    return cache ? cache->block_size : 0;
+}
+
+long disk_cache_lookup(disk_cache_t* cache, uint64_t block, size_t skip,
+                       void* buffer, size_t size) {
+    if (!cache || !buffer) {
+        return -1;
+    }
+
+    uint64_t hash = hash_block(block);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    cache_entry_t* entry = shard_find(shard, block, hash);
+    if (!entry) {
+        shard->stats.misses++;
+        pthread_mutex_unlock(&shard->lock);
+        return -1;
+    }
+
+    // 移到 LRU 表头
+    lru_unlink(shard, entry);
+    lru_push_front(shard, entry);
+    shard->stats.hits++;
+
+    size_t copied = 0;
+    if (skip < entry->size) {
+        copied = entry->size - skip;
+        if (copied > size) {
+            copied = size;
+        }
+        memcpy(buffer, entry->data + skip, copied);
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return (long)copied;
+}
+
+void disk_cache_insert(disk_cache_t* cache, uint64_t block, const void* data, size_t size) {
+    if (!cache || !data || size == 0 || size > cache->block_size) {
+        return;
+    }
+
+    uint64_t hash = hash_block(block);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+
+    cache_entry_t* entry = shard_find(shard, block, hash);
+    if (entry) {
+        // 已存在：刷新数据和 LRU 位置
+        lru_unlink(shard, entry);
+    } else if (shard->count >= shard->capacity && shard->tail) {
+        // 已满：复用最久未使用的条目
+        entry = shard->tail;
+        lru_unlink(shard, entry);
+        shard_unhash(shard, entry);
+        shard->stats.evictions++;
+        entry->block = block;
+        entry->hnext = shard->buckets[(hash >> 8) & shard->bucket_mask];
+        shard->buckets[(hash >> 8) & shard->bucket_mask] = entry;
+    } else {
+        entry = (cache_entry_t*)malloc(sizeof(cache_entry_t) + cache->block_size);
+        if (!entry) {
+            pthread_mutex_unlock(&shard->lock);
+            return;
+        }
+        entry->block = block;
+        entry->hnext = shard->buckets[(hash >> 8) & shard->bucket_mask];
+        shard->buckets[(hash >> 8) & shard->bucket_mask] = entry;
+        shard->count++;
+    }
+
+    memcpy(entry->data, data, size);
+    entry->size = size;
+    lru_push_front(shard, entry);
+    shard->stats.insertions++;
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void disk_cache_invalidate(disk_cache_t* cache, uint64_t block) {
+    if (!cache) {
+        return;
+    }
+
+    uint64_t hash = hash_block(block);
+    cache_shard_t* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    cache_entry_t* entry = shard_find(shard, block, hash);
+    if (entry) {
+        lru_unlink(shard, entry);
+        shard_unhash(shard, entry);
+        shard->count--;
+        free(entry);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void disk_cache_get_stats(disk_cache_t* cache, disk_cache_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(disk_cache_stats_t));
+    if (!cache) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < cache->shard_count; i++) {
+        cache_shard_t* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        stats->hits += shard->stats.hits;
+        stats->misses += shard->stats.misses;
+        stats->insertions += shard->stats.insertions;
+        stats->evictions += shard->stats.evictions;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
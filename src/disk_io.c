@@ -1,11 +1,15 @@
+#define _GNU_SOURCE
 #include "disk_io.h"
+#include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <errno.h>
+#include <pthread.h>
 
 #ifdef __APPLE__
 #include <sys/disk.h>
@@ -14,7 +18,275 @@
 #include <sys/ioctl.h>
 #endif
 
+#define DISK_DEFAULT_ALIGN 4096      // 缓冲区默认对齐（页大小）
+#define DISK_POOL_SLOTS 16           // 缓冲区池缓存的空闲缓冲区数量
+#define DISK_CACHE_MAX_READ (256 * 1024)  // 不超过此大小的读取经过块缓存
+#define DISK_RESCUE_CHUNK (64 * 1024)     // 容错读取出错后的读取单位
+#define DISK_RETRY_CHUNK (1024 * 1024)    // 重试时单次读取的上限
+
+// 对齐缓冲区池：缓存空闲缓冲区，避免反复 posix_memalign
+// 每个缓冲区前有一个对齐大小的头部，记录可用容量
+struct disk_buffer_pool {
+    pthread_mutex_t lock;            // 保护空闲列表
+    size_t align;                    // 缓冲区对齐
+    size_t count;                    // 空闲缓冲区数量
+    void* buffers[DISK_POOL_SLOTS];  // 空闲缓冲区
+};
+
+static int append_extent(disk_extent_t** extents, size_t* count, size_t* capacity,
+                         uint64_t offset, uint64_t length);
+
+static size_t round_up(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static size_t buffer_capacity(const void* buffer) {
+    return ((const size_t*)buffer)[-1];
+}
+
+// 查询逻辑/物理扇区大小及直接 I/O 对齐要求
+static void detect_sector_sizes(disk_handle_t* handle, const struct stat* st) {
+    handle->sector_size = 512;
+    handle->physical_sector_size = 512;
+
+    if (S_ISBLK(st->st_mode)) {
+#ifdef __APPLE__
+        uint32_t logical = 0;
+        uint32_t physical = 0;
+        if (ioctl(handle->fd, DKIOCGETBLOCKSIZE, &logical) == 0 && logical > 0) {
+            handle->sector_size = logical;
+        }
+#ifdef DKIOCGETPHYSICALBLOCKSIZE
+        if (ioctl(handle->fd, DKIOCGETPHYSICALBLOCKSIZE, &physical) == 0 && physical > 0) {
+            handle->physical_sector_size = physical;
+        }
+#endif
+#elif defined(__linux__)
+        int logical = 0;
+        unsigned int physical = 0;
+        if (ioctl(handle->fd, BLKSSZGET, &logical) == 0 && logical > 0) {
+            handle->sector_size = (uint32_t)logical;
+        }
+        if (ioctl(handle->fd, BLKPBSZGET, &physical) == 0 && physical > 0) {
+            handle->physical_sector_size = physical;
+        }
+#endif
+    } else if (st->st_blksize > 0) {
+        // 磁盘镜像：以文件系统块大小作为物理对齐单位
+        handle->physical_sector_size = (uint32_t)st->st_blksize;
+    }
+
+    if (handle->physical_sector_size < handle->sector_size) {
+        handle->physical_sector_size = handle->sector_size;
+    }
+}
+
+// 以直接 I/O 方式重新打开分段（Linux 使用 O_DIRECT，macOS 使用 F_NOCACHE）
+static int enable_direct_io(disk_segment_t* segment) {
+#if defined(__linux__) && defined(O_DIRECT)
+    int fd = open(segment->path, O_RDONLY | O_DIRECT);
+    if (fd < 0) {
+        return -1;
+    }
+    close(segment->fd);
+    segment->fd = fd;
+    return 0;
+#elif defined(__APPLE__)
+    return fcntl(segment->fd, F_NOCACHE, 1) < 0 ? -1 : 0;
+#else
+    (void)segment;
+    return -1;
+#endif
+}
+
+// 映射整个磁盘镜像，失败时保持 read() 路径
+// 分卷镜像先保留一段连续地址空间，再将各分段依次映射到对应位置
+static void map_image(disk_handle_t* handle) {
+    if (handle->size == 0 || handle->size > (uint64_t)SIZE_MAX) {
+        return;
+    }
+
+    // 分段起点必须页对齐才能拼接映射
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    for (uint32_t i = 1; i < handle->segment_count; i++) {
+        if (handle->segments[i].offset % page) {
+            return;
+        }
+    }
+
+    void* base;
+    if (handle->segment_count == 1) {
+        base = mmap(NULL, (size_t)handle->size, PROT_READ, MAP_SHARED, handle->fd, 0);
+    } else {
+        base = mmap(NULL, (size_t)handle->size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        for (uint32_t i = 0; base != MAP_FAILED && i < handle->segment_count; i++) {
+            const disk_segment_t* segment = &handle->segments[i];
+            if (segment->size == 0) {
+                continue;
+            }
+            if (mmap((uint8_t*)base + segment->offset, (size_t)segment->size, PROT_READ,
+                     MAP_SHARED | MAP_FIXED, segment->fd, 0) == MAP_FAILED) {
+                int saved = errno;
+                munmap(base, (size_t)handle->size);
+                errno = saved;
+                base = MAP_FAILED;
+            }
+        }
+    }
+
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Warning: Cannot map image, falling back to read(): %s\n",
+                strerror(errno));
+        return;
+    }
+
+    handle->map_base = (uint8_t*)base;
+    madvise(base, (size_t)handle->size, MADV_SEQUENTIAL);
+}
+
+// 生成分卷镜像的下一个分段路径（image.001 -> image.002，image.aa -> image.ab）
+// 路径没有分卷后缀或后缀已用尽时返回 -1
+static int next_segment_path(const char* path, char* next, size_t size) {
+    const char* dot = strrchr(path, '.');
+    if (!dot || strchr(dot, '/') || strlen(path) >= size) {
+        return -1;
+    }
+
+    const char* suffix = dot + 1;
+    size_t len = strlen(suffix);
+    int numeric = len >= 3;
+    int alpha = len == 2;
+    for (size_t i = 0; i < len; i++) {
+        numeric = numeric && suffix[i] >= '0' && suffix[i] <= '9';
+        alpha = alpha && suffix[i] >= 'a' && suffix[i] <= 'z';
+    }
+    if (!numeric && !alpha) {
+        return -1;
+    }
+
+    strcpy(next, path);
+    char* digit = next + (suffix - path) + len;
+    char low = numeric ? '0' : 'a';
+    char high = numeric ? '9' : 'z';
+
+    // 末位加一并向前进位，宽度保持不变
+    while (digit-- > next + (suffix - path)) {
+        if (*digit < high) {
+            (*digit)++;
+            return 0;
+        }
+        *digit = low;
+    }
+    return -1;
+}
+
+// 判断路径是否为分卷镜像的第一个分段（image.000/image.001 或 image.aa）
+static int is_first_segment(const char* path) {
+    const char* dot = strrchr(path, '.');
+    if (!dot || strchr(dot, '/')) {
+        return 0;
+    }
+
+    const char* suffix = dot + 1;
+    size_t len = strlen(suffix);
+    if (len == 2) {
+        return strcmp(suffix, "aa") == 0;
+    }
+    if (len < 3) {
+        return 0;
+    }
+    for (size_t i = 0; i < len - 1; i++) {
+        if (suffix[i] != '0') {
+            return 0;
+        }
+    }
+    return suffix[len - 1] == '0' || suffix[len - 1] == '1';
+}
+
+// 追加一个分段，必要时扩容
+static disk_segment_t* add_segment(disk_handle_t* handle, const char* path, int fd,
+                                   uint64_t size) {
+    disk_segment_t* grown = (disk_segment_t*)realloc(handle->segments,
+                                (handle->segment_count + 1) * sizeof(disk_segment_t));
+    if (!grown) {
+        return NULL;
+    }
+    handle->segments = grown;
+
+    disk_segment_t* segment = &handle->segments[handle->segment_count++];
+    memset(segment, 0, sizeof(disk_segment_t));
+    segment->fd = fd;
+    segment->offset = handle->size;
+    segment->size = size;
+    strncpy(segment->path, path, sizeof(segment->path) - 1);
+    handle->size += size;
+    return segment;
+}
+
+// 打开分卷镜像的其余分段，直到下一个分段不存在
+static int open_split_segments(disk_handle_t* handle, const char* first_path) {
+    char path[sizeof(handle->segments[0].path)];
+    char next[sizeof(path)];
+
+    // 路径过长时无法生成后续分段的路径，只打开第一个分段
+    if (strlen(first_path) >= sizeof(path)) {
+        fprintf(stderr, "Warning: Path too long, split image segments after '%s' not detected\n",
+                first_path);
+        return 0;
+    }
+    strcpy(path, first_path);
+
+    while (next_segment_path(path, next, sizeof(next)) == 0) {
+        int fd = open(next, O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                break;  // 分卷结束
+            }
+            fprintf(stderr, "Error: Cannot open segment '%s': %s\n", next, strerror(errno));
+            return -1;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+            fprintf(stderr, "Error: Segment '%s' is not a regular file\n", next);
+            close(fd);
+            return -1;
+        }
+
+        if (!add_segment(handle, next, fd, (uint64_t)st.st_size)) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            close(fd);
+            return -1;
+        }
+        strcpy(path, next);
+    }
+
+    return 0;
+}
+
+// 对所有分段启用直接 I/O；分段边界不满足对齐要求时不启用
+static int enable_direct_segments(disk_handle_t* handle) {
+    for (uint32_t i = 1; i < handle->segment_count; i++) {
+        if (handle->segments[i].offset % handle->physical_sector_size) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < handle->segment_count; i++) {
+        if (enable_direct_io(&handle->segments[i]) < 0) {
+            return -1;
+        }
+    }
+    handle->fd = handle->segments[0].fd;
+    return 0;
+}
+
 disk_handle_t* disk_open(const char* device_path) {
+    return disk_open_ex(device_path, DISK_OPEN_DEFAULT);
+}
+
+disk_handle_t* disk_open_ex(const char* device_path, uint32_t flags) {
     if (!device_path) {
         fprintf(stderr, "Error: Invalid device path\n");
         return NULL;
@@ -47,9 +319,10 @@ disk_handle_t* disk_open(const char* device_path) {
         return NULL;
     }
 
+    uint64_t size = 0;
     if (S_ISREG(st.st_mode)) {
         // 普通文件（磁盘镜像）
-        handle->size = st.st_size;
+        size = st.st_size;
     } else if (S_ISBLK(st.st_mode)) {
         // 块设备
 #ifdef __APPLE__
@@ -62,16 +335,14 @@ disk_handle_t* disk_open(const char* device_path) {
             free(handle);
             return NULL;
         }
-        handle->size = (uint64_t)block_size * block_count;
+        size = (uint64_t)block_size * block_count;
 #elif defined(__linux__)
-        uint64_t size;
         if (ioctl(handle->fd, BLKGETSIZE64, &size) < 0) {
             fprintf(stderr, "Error: Cannot get device size: %s\n", strerror(errno));
             close(handle->fd);
             free(handle);
             return NULL;
         }
-        handle->size = size;
 #else
         fprintf(stderr, "Error: Block device not supported on this platform\n");
         close(handle->fd);
@@ -85,11 +356,59 @@ disk_handle_t* disk_open(const char* device_path) {
         return NULL;
     }
 
-    // 设置默认扇区大小
-    handle->sector_size = 512;
+    if (!add_segment(handle, device_path, handle->fd, size)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        close(handle->fd);
+        free(handle);
+        return NULL;
+    }
+
+    // 分卷镜像：从第一个分段开始依次打开后续分段
+    if (S_ISREG(st.st_mode) && is_first_segment(device_path) &&
+        open_split_segments(handle, device_path) < 0) {
+        disk_close(handle);
+        return NULL;
+    }
+
+    // 查询扇区大小
+    detect_sector_sizes(handle, &st);
 
-    printf("Opened device: %s (Size: %llu bytes, Sector size: %u bytes)\n",
-           device_path, (unsigned long long)handle->size, handle->sector_size);
+    if (flags & DISK_OPEN_DIRECT) {
+        if (enable_direct_segments(handle) == 0) {
+            handle->io_align = handle->physical_sector_size;
+        } else {
+            fprintf(stderr, "Warning: Direct I/O not available, using page cache: %s\n",
+                    strerror(errno));
+        }
+    } else if (S_ISREG(st.st_mode) && !(flags & DISK_OPEN_NO_MMAP)) {
+        map_image(handle);
+    }
+
+    // 缓冲区池的对齐至少为页大小，且满足直接 I/O 要求
+    handle->pool = (disk_buffer_pool_t*)calloc(1, sizeof(disk_buffer_pool_t));
+    if (!handle->pool) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        disk_close(handle);
+        return NULL;
+    }
+    pthread_mutex_init(&handle->pool->lock, NULL);
+    handle->pool->align = handle->io_align > DISK_DEFAULT_ALIGN ? 
+                          handle->io_align : DISK_DEFAULT_ALIGN;
+
+    // 默认启用块缓存（映射模式除外）
+    if (!(flags & DISK_OPEN_NO_CACHE)) {
+        disk_set_cache(handle, DISK_CACHE_DEFAULT_CAPACITY);
+    }
+
+    printf("Opened device: %s (Size: %llu bytes, Sector size: %u/%u bytes%s)\n",
+           device_path, (unsigned long long)handle->size, handle->sector_size,
+           handle->physical_sector_size,
+           handle->map_base ? ", memory-mapped" : 
+           (handle->io_align ? ", direct I/O" : ""));
+    if (handle->segment_count > 1) {
+        printf("Split image: %u segments, last segment %s\n", handle->segment_count,
+               handle->segments[handle->segment_count - 1].path);
+    }
 
     return handle;
 }
@@ -99,13 +418,341 @@ void disk_close(disk_handle_t* handle) {
         return;
     }
 
-    if (handle->fd >= 0) {
+    if (handle->map_base) {
+        munmap(handle->map_base, (size_t)handle->size);
+    }
+
+    // 第一个分段的描述符即 handle->fd
+    for (uint32_t i = 0; i < handle->segment_count; i++) {
+        if (handle->segments[i].fd >= 0) {
+            close(handle->segments[i].fd);
+        }
+    }
+    if (handle->segment_count == 0 && handle->fd >= 0) {
         close(handle->fd);
     }
+    free(handle->segments);
+
+    disk_cache_destroy(handle->cache);
+    disk_throttle_destroy(handle->throttle);
+    disk_badmap_destroy(handle->badmap);
+
+    if (handle->pool) {
+        for (size_t i = 0; i < handle->pool->count; i++) {
+            free((uint8_t*)handle->pool->buffers[i] - handle->pool->align);
+        }
+        pthread_mutex_destroy(&handle->pool->lock);
+        free(handle->pool);
+    }
 
     free(handle);
 }
 
+// 二分查找包含指定偏移的分段
+static const disk_segment_t* find_segment(const disk_handle_t* handle, uint64_t offset) {
+    uint32_t low = 0;
+    uint32_t high = handle->segment_count;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const disk_segment_t* segment = &handle->segments[mid];
+        if (offset < segment->offset) {
+            high = mid;
+        } else if (offset >= segment->offset + segment->size) {
+            low = mid + 1;
+        } else {
+            return segment;
+        }
+    }
+    return NULL;
+}
+
+int disk_segment_at(const disk_handle_t* handle, uint64_t offset,
+                    uint64_t* local_offset, uint64_t* remaining) {
+    if (!handle || !local_offset) {
+        return -1;
+    }
+
+    const disk_segment_t* segment = find_segment(handle, offset);
+    if (!segment) {
+        return -1;
+    }
+
+    *local_offset = offset - segment->offset;
+    if (remaining) {
+        *remaining = segment->size - *local_offset;
+    }
+    return segment->fd;
+}
+
+// 从指定偏移连续读取，跨分段的请求按分段拆分
+// 使用 pread() 不改变共享的文件偏移，可被多个线程同时调用
+// 返回出错或到达末尾前读到的字节数，出错时 error 输出 errno（否则为 0）
+static size_t read_span(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size,
+                        int* error) {
+    size_t total = 0;
+    *error = 0;
+
+    while (total < size) {
+        uint64_t local;
+        uint64_t remaining;
+        int fd = disk_segment_at(handle, offset + total, &local, &remaining);
+        if (fd < 0) {
+            break;  // 超出最后一个分段
+        }
+
+        size_t chunk = size - total;
+        if (chunk > remaining) {
+            chunk = (size_t)remaining;
+        }
+
+        disk_throttle_acquire(handle->throttle, chunk);
+        uint64_t started = handle->throttle ? utils_monotonic_ns() : 0;
+        ssize_t bytes_read = pread(fd, (uint8_t*)buffer + total, chunk, (off_t)local);
+        if (handle->throttle && bytes_read > 0) {
+            disk_throttle_record(handle->throttle, (size_t)bytes_read,
+                                 utils_monotonic_ns() - started);
+        }
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = errno;
+            break;
+        }
+        if (bytes_read == 0) {
+            break;  // 到达文件末尾
+        }
+        total += bytes_read;
+    }
+
+    return total;
+}
+
+// 容错读取（ddrescue 策略）：已记录的跳过区和坏区填零不再读取；
+// 先尝试整块读取，出错后改为按 DISK_RESCUE_CHUNK 读取，
+// 每次出错从出错位置向后跳过一段（连续出错时距离指数增长）并记录到坏块图，留待重试
+static ssize_t read_rescue(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size) {
+    uint8_t* out = (uint8_t*)buffer;
+    uint64_t end = offset + size;
+    uint64_t pos = offset;
+    size_t max_chunk = size;
+
+    while (pos < end) {
+        disk_bad_range_t range;
+        uint64_t limit = end;
+        if (disk_badmap_lookup(handle->badmap, pos, end, &range)) {
+            if (range.offset <= pos) {
+                uint64_t stop = range.offset + range.length < end ? range.offset + range.length : end;
+                memset(out + (pos - offset), 0, (size_t)(stop - pos));
+                pos = stop;
+                continue;
+            }
+            limit = range.offset;
+        }
+
+        size_t chunk = (size_t)(limit - pos) < max_chunk ? (size_t)(limit - pos) : max_chunk;
+        int error;
+        size_t bytes_read = read_span(handle, pos, out + (pos - offset), chunk, &error);
+        pos += bytes_read;
+
+        if (!error) {
+            if (bytes_read == 0) {
+                break;  // 到达设备末尾
+            }
+            disk_badmap_reset_skip(handle->badmap);
+            continue;
+        }
+
+        // 大块读取失败且无法确定出错位置时，先缩小读取单位再定位
+        if (bytes_read == 0 && chunk > DISK_RESCUE_CHUNK) {
+            max_chunk = DISK_RESCUE_CHUNK;
+            continue;
+        }
+
+        // 从出错位置向后跳过，跳过区的终点对齐到物理扇区
+        uint64_t align = handle->physical_sector_size;
+        uint64_t skip = disk_badmap_next_skip(handle->badmap);
+        uint64_t stop = (pos + skip) / align * align;
+        if (stop <= pos) {
+            stop = pos + align;
+        }
+        if (stop > handle->size) {
+            stop = handle->size;
+        }
+
+        char size_buf[32];
+        fprintf(stderr, "\nWarning: Read error at offset 0x%llx (%s), skipping %s\n",
+                (unsigned long long)pos, strerror(error),
+                utils_format_size(stop - pos, size_buf, sizeof(size_buf)));
+        disk_badmap_mark(handle->badmap, pos, stop - pos, DISK_BAD_SKIPPED);
+    }
+
+    return (ssize_t)(pos - offset);
+}
+
+// 从指定偏移读取（无对齐处理）
+static ssize_t read_at(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size) {
+    if (handle->badmap) {
+        return read_rescue(handle, offset, buffer, size);
+    }
+
+    int error;
+    size_t total = read_span(handle, offset, buffer, size, &error);
+    if (error) {
+        fprintf(stderr, "Error: Read failed at offset %llu: %s\n",
+                (unsigned long long)(offset + total), strerror(error));
+        return total > 0 ? (ssize_t)total : -1;
+    }
+
+    return (ssize_t)total;
+}
+
+// 未对齐的请求：扩展到物理扇区边界，读入对齐的中转缓冲区后复制
+static ssize_t read_bounced(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size) {
+    uint64_t align = handle->io_align;
+    uint64_t aligned_start = offset - (offset % align);
+    size_t head = (size_t)(offset - aligned_start);
+    size_t aligned_size = round_up(head + size, align);
+
+    uint8_t* bounce = (uint8_t*)disk_buffer_alloc(handle, aligned_size);
+    if (!bounce) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    ssize_t bytes_read = read_at(handle, aligned_start, bounce, aligned_size);
+    if (bytes_read >= 0) {
+        if ((size_t)bytes_read <= head) {
+            bytes_read = 0;
+        } else {
+            bytes_read -= head;
+            if ((size_t)bytes_read > size) {
+                bytes_read = size;
+            }
+            memcpy(buffer, bounce + head, bytes_read);
+        }
+    }
+
+    disk_buffer_free(handle, bounce);
+    return bytes_read;
+}
+
+// 不经过缓存的读取（处理直接 I/O 对齐）
+static ssize_t read_uncached(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size) {
+    // 直接 I/O 要求偏移、长度和缓冲区地址均按扇区对齐
+    if (handle->io_align && 
+        (offset % handle->io_align || size % handle->io_align ||
+         (uintptr_t)buffer % handle->io_align)) {
+        return read_bounced(handle, offset, buffer, size);
+    }
+
+    return read_at(handle, offset, buffer, size);
+}
+
+// 经过块缓存的读取：未命中时读取整个缓存块并插入缓存
+static ssize_t read_cached(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size) {
+    size_t block_size = disk_cache_block_size(handle->cache);
+    size_t done = 0;
+
+    while (done < size) {
+        uint64_t pos = offset + done;
+        uint64_t block = pos / block_size;
+        size_t skip = (size_t)(pos % block_size);
+
+        long copied = disk_cache_lookup(handle->cache, block, skip,
+                                        (uint8_t*)buffer + done, size - done);
+        if (copied < 0) {
+            uint64_t block_start = block * block_size;
+            size_t block_len = block_size;
+            if (block_start + block_len > handle->size) {
+                block_len = (size_t)(handle->size - block_start);
+            }
+
+            uint8_t* block_buf = (uint8_t*)disk_buffer_alloc(handle, block_size);
+            if (!block_buf) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                return done > 0 ? (ssize_t)done : -1;
+            }
+
+            ssize_t bytes_read = read_uncached(handle, block_start, block_buf, block_len);
+            if (bytes_read < 0) {
+                disk_buffer_free(handle, block_buf);
+                return done > 0 ? (ssize_t)done : -1;
+            }
+
+            // 只缓存完整读取的块
+            if ((size_t)bytes_read == block_len) {
+                disk_cache_insert(handle->cache, block, block_buf, block_len);
+            }
+
+            copied = 0;
+            if ((size_t)bytes_read > skip) {
+                copied = (long)((size_t)bytes_read - skip);
+                if ((size_t)copied > size - done) {
+                    copied = (long)(size - done);
+                }
+                memcpy((uint8_t*)buffer + done, block_buf + skip, (size_t)copied);
+            }
+            disk_buffer_free(handle, block_buf);
+        }
+
+        if (copied == 0) {
+            break;
+        }
+        done += (size_t)copied;
+    }
+
+    return (ssize_t)done;
+}
+
+void* disk_buffer_alloc(disk_handle_t* handle, size_t size) {
+    if (!handle || !handle->pool || size == 0) {
+        return NULL;
+    }
+
+    disk_buffer_pool_t* pool = handle->pool;
+    size_t capacity = round_up(size, pool->align);
+
+    // 优先复用池中容量足够的缓冲区
+    pthread_mutex_lock(&pool->lock);
+    for (size_t i = 0; i < pool->count; i++) {
+        if (buffer_capacity(pool->buffers[i]) >= capacity) {
+            void* buffer = pool->buffers[i];
+            pool->buffers[i] = pool->buffers[--pool->count];
+            pthread_mutex_unlock(&pool->lock);
+            return buffer;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    void* base = NULL;
+    if (posix_memalign(&base, pool->align, pool->align + capacity) != 0) {
+        return NULL;
+    }
+
+    uint8_t* buffer = (uint8_t*)base + pool->align;
+    ((size_t*)buffer)[-1] = capacity;
+    return buffer;
+}
+
+void disk_buffer_free(disk_handle_t* handle, void* buffer) {
+    if (!handle || !handle->pool || !buffer) {
+        return;
+    }
+
+    disk_buffer_pool_t* pool = handle->pool;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->count < DISK_POOL_SLOTS) {
+        pool->buffers[pool->count++] = buffer;
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    free((uint8_t*)buffer - pool->align);
+}
+
 ssize_t disk_read(disk_handle_t* handle, uint64_t offset, void* buffer, size_t size) {
     if (!handle || !buffer || handle->fd < 0) {
         return -1;
@@ -121,21 +768,244 @@ ssize_t disk_read(disk_handle_t* handle, uint64_t offset, void* buffer, size_t s
         size = handle->size - offset;
     }
 
-    // 定位到指定偏移
-    if (lseek(handle->fd, offset, SEEK_SET) < 0) {
-        fprintf(stderr, "Error: Cannot seek to offset %llu: %s\n",
-                (unsigned long long)offset, strerror(errno));
+    // 映射模式直接从映射区复制（缺页即设备读取，同样计入限速）
+    if (handle->map_base) {
+        disk_throttle_acquire(handle->throttle, size);
+        memcpy(buffer, handle->map_base + offset, size);
+        return (ssize_t)size;
+    }
+
+    // 小块读取经过块缓存
+    if (handle->cache && size <= DISK_CACHE_MAX_READ) {
+        return read_cached(handle, offset, buffer, size);
+    }
+
+    ssize_t bytes_read = read_uncached(handle, offset, buffer, size);
+    if (bytes_read > 0) {
+        disk_populate_cache(handle, offset, buffer, (size_t)bytes_read);
+    }
+    return bytes_read;
+}
+
+void disk_populate_cache(disk_handle_t* handle, uint64_t offset, const void* data, size_t size) {
+    if (!handle || !handle->cache || !data) {
+        return;
+    }
+
+    // 只缓存范围内完整的块（设备末尾的块除外）
+    uint64_t block_size = disk_cache_block_size(handle->cache);
+    uint64_t end = offset + size;
+    for (uint64_t block = (offset + block_size - 1) / block_size; ; block++) {
+        uint64_t block_start = block * block_size;
+        uint64_t block_len = block_size;
+        if (block_start >= handle->size) {
+            break;
+        }
+        if (block_start + block_len > handle->size) {
+            block_len = handle->size - block_start;
+        }
+        if (block_start + block_len > end) {
+            break;
+        }
+        disk_cache_insert(handle->cache, block, (const uint8_t*)data + (block_start - offset),
+                          (size_t)block_len);
+    }
+}
+
+int disk_set_cache(disk_handle_t* handle, size_t capacity) {
+    if (!handle) {
         return -1;
     }
 
-    // 读取数据
-    ssize_t bytes_read = read(handle->fd, buffer, size);
-    if (bytes_read < 0) {
-        fprintf(stderr, "Error: Read failed: %s\n", strerror(errno));
+    disk_cache_destroy(handle->cache);
+    handle->cache = NULL;
+
+    // 映射模式直接访问页缓存，无需额外的块缓存
+    if (capacity == 0 || handle->map_base) {
+        return 0;
+    }
+
+    handle->cache = disk_cache_create(DISK_CACHE_BLOCK_SIZE, capacity, DISK_CACHE_DEFAULT_SHARDS);
+    return handle->cache ? 0 : -1;
+}
+
+int disk_set_throttle(disk_handle_t* handle, uint64_t bytes_per_sec, uint32_t iops) {
+    if (!handle) {
         return -1;
     }
 
-    return bytes_read;
+    disk_throttle_destroy(handle->throttle);
+    handle->throttle = NULL;
+
+    if (bytes_per_sec == 0 && iops == 0) {
+        return 0;
+    }
+
+    handle->throttle = disk_throttle_create(bytes_per_sec, iops);
+    return handle->throttle ? 0 : -1;
+}
+
+int disk_set_rescue(disk_handle_t* handle, const char* map_path) {
+    if (!handle) {
+        return -1;
+    }
+
+    disk_badmap_destroy(handle->badmap);
+    handle->badmap = disk_badmap_create(map_path, handle->size);
+    return handle->badmap ? 0 : -1;
+}
+
+// 将重新读取成功的区间记入结果（与上一个区间相邻时合并），并使对应缓存块失效
+static int add_recovered(disk_handle_t* handle, disk_extent_t** extents, size_t* count,
+                         size_t* capacity, uint64_t offset, uint64_t length) {
+    disk_badmap_clear(handle->badmap, offset, length);
+
+    if (handle->cache) {
+        uint64_t block_size = disk_cache_block_size(handle->cache);
+        for (uint64_t block = offset / block_size; block <= (offset + length - 1) / block_size; block++) {
+            disk_cache_invalidate(handle->cache, block);
+        }
+    }
+
+    if (*count > 0 && (*extents)[*count - 1].offset + (*extents)[*count - 1].length == offset) {
+        (*extents)[*count - 1].length += length;
+        return 0;
+    }
+    return append_extent(extents, count, capacity, offset, length);
+}
+
+int disk_retry_skipped(disk_handle_t* handle, uint64_t start, uint64_t end,
+                       disk_extent_t** recovered, size_t* count) {
+    if (!handle || !recovered || !count) {
+        return -1;
+    }
+
+    *recovered = NULL;
+    *count = 0;
+    if (!handle->badmap) {
+        return 0;
+    }
+
+    disk_bad_range_t* ranges = NULL;
+    size_t range_count = 0;
+    if (disk_badmap_collect(handle->badmap, start, end, DISK_BAD_SKIPPED,
+                            &ranges, &range_count) < 0) {
+        return -1;
+    }
+    if (range_count == 0) {
+        return 0;
+    }
+
+    // 待重试区间栈：先处理低偏移的区间
+    size_t stack_capacity = range_count + 64;
+    disk_extent_t* stack = (disk_extent_t*)malloc(stack_capacity * sizeof(disk_extent_t));
+    uint8_t* buffer = (uint8_t*)disk_buffer_alloc(handle, DISK_RETRY_CHUNK);
+    if (!stack || !buffer) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(stack);
+        disk_buffer_free(handle, buffer);
+        free(ranges);
+        return -1;
+    }
+
+    size_t depth = 0;
+    for (size_t i = range_count; i-- > 0; ) {
+        stack[depth++] = (disk_extent_t){ ranges[i].offset, ranges[i].length };
+    }
+    free(ranges);
+
+    // 最小拆分单位：直接 I/O 下为对齐要求，否则为逻辑扇区
+    uint64_t unit = handle->io_align ? handle->io_align : handle->sector_size;
+    size_t capacity = 0;
+    int ret = 0;
+
+    while (depth > 0 && ret == 0) {
+        disk_extent_t r = stack[--depth];
+
+        // 栈空间不足时扩容（每次最多压入两个区间）
+        if (depth + 2 > stack_capacity) {
+            stack_capacity *= 2;
+            disk_extent_t* grown = (disk_extent_t*)realloc(stack, stack_capacity * sizeof(disk_extent_t));
+            if (!grown) {
+                ret = -1;
+                break;
+            }
+            stack = grown;
+        }
+
+        if (r.length > DISK_RETRY_CHUNK) {
+            stack[depth++] = (disk_extent_t){ r.offset + DISK_RETRY_CHUNK, r.length - DISK_RETRY_CHUNK };
+            stack[depth++] = (disk_extent_t){ r.offset, DISK_RETRY_CHUNK };
+            continue;
+        }
+
+        int error;
+        size_t got = read_span(handle, r.offset, buffer, (size_t)r.length, &error);
+        if (got > 0) {
+            ret = add_recovered(handle, recovered, count, &capacity, r.offset, got);
+        }
+        if (!error) {
+            continue;
+        }
+
+        // 读取失败：能确定出错位置时只记录该扇区，否则二分缩小范围
+        disk_extent_t rest = { r.offset + got, r.length - got };
+        if (rest.length <= unit) {
+            disk_badmap_mark(handle->badmap, rest.offset, rest.length, DISK_BAD_UNREADABLE);
+        } else if (got > 0) {
+            disk_badmap_mark(handle->badmap, rest.offset, unit, DISK_BAD_UNREADABLE);
+            stack[depth++] = (disk_extent_t){ rest.offset + unit, rest.length - unit };
+        } else {
+            uint64_t half = (rest.length / 2 + unit - 1) / unit * unit;
+            stack[depth++] = (disk_extent_t){ rest.offset + half, rest.length - half };
+            stack[depth++] = (disk_extent_t){ rest.offset, half };
+        }
+    }
+
+    free(stack);
+    disk_buffer_free(handle, buffer);
+    disk_badmap_save(handle->badmap);
+
+    if (ret < 0) {
+        free(*recovered);
+        *recovered = NULL;
+        *count = 0;
+    }
+    return ret;
+}
+
+uint64_t disk_unreadable_bytes(disk_handle_t* handle, uint64_t offset, uint64_t size) {
+    if (!handle || !handle->badmap) {
+        return 0;
+    }
+    return disk_badmap_count(handle->badmap, offset, size);
+}
+
+int disk_get_rescue_stats(disk_handle_t* handle, disk_badmap_stats_t* stats) {
+    if (!handle || !handle->badmap || !stats) {
+        return -1;
+    }
+
+    disk_badmap_get_stats(handle->badmap, stats);
+    return 0;
+}
+
+int disk_get_throttle_stats(disk_handle_t* handle, disk_throttle_stats_t* stats) {
+    if (!handle || !handle->throttle || !stats) {
+        return -1;
+    }
+
+    disk_throttle_get_stats(handle->throttle, stats);
+    return 0;
+}
+
+int disk_get_cache_stats(disk_handle_t* handle, disk_cache_stats_t* stats) {
+    if (!handle || !handle->cache || !stats) {
+        return -1;
+    }
+
+    disk_cache_get_stats(handle->cache, stats);
+    return 0;
 }
 
 ssize_t disk_read_sectors(disk_handle_t* handle, uint64_t sector, 
@@ -157,3 +1027,180 @@ uint64_t disk_get_size(disk_handle_t* handle) {
     return handle->size;
 }
 
+
+int disk_is_mapped(const disk_handle_t* handle) {
+    return handle && handle->map_base != NULL;
+}
+
+const uint8_t* disk_map_range(disk_handle_t* handle, uint64_t offset, size_t size,
+                              size_t* mapped_size) {
+    if (!handle || !handle->map_base || offset >= handle->size) {
+        return NULL;
+    }
+
+    if (offset + size > handle->size) {
+        size = handle->size - offset;
+    }
+
+    if (mapped_size) {
+        *mapped_size = size;
+    }
+
+    // 调用者随后访问映射页，按请求范围计入限速
+    disk_throttle_acquire(handle->throttle, size);
+    return handle->map_base + offset;
+}
+
+int disk_advise(disk_handle_t* handle, uint64_t offset, uint64_t size, disk_advice_t advice) {
+    if (!handle || offset >= handle->size) {
+        return -1;
+    }
+
+    if (offset + size > handle->size) {
+        size = handle->size - offset;
+    }
+
+    if (handle->map_base) {
+        // madvise 要求页对齐的起始地址
+        uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+        uint64_t aligned = offset - (offset % page);
+        int mode;
+        switch (advice) {
+            case DISK_ADVICE_SEQUENTIAL: mode = MADV_SEQUENTIAL; break;
+            case DISK_ADVICE_WILLNEED:   mode = MADV_WILLNEED; break;
+            case DISK_ADVICE_DONTNEED:   mode = MADV_DONTNEED; break;
+            default:                     mode = MADV_NORMAL; break;
+        }
+        return madvise(handle->map_base + aligned, (size_t)(size + offset - aligned), mode);
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    int mode;
+    switch (advice) {
+        case DISK_ADVICE_SEQUENTIAL: mode = POSIX_FADV_SEQUENTIAL; break;
+        case DISK_ADVICE_WILLNEED:   mode = POSIX_FADV_WILLNEED; break;
+        case DISK_ADVICE_DONTNEED:   mode = POSIX_FADV_DONTNEED; break;
+        default:                     mode = POSIX_FADV_NORMAL; break;
+    }
+    // 按分段逐段给出建议
+    uint64_t end = offset + size;
+    while (offset < end) {
+        uint64_t local;
+        uint64_t remaining;
+        int fd = disk_segment_at(handle, offset, &local, &remaining);
+        if (fd < 0) {
+            break;
+        }
+        uint64_t chunk = end - offset < remaining ? end - offset : remaining;
+        if (posix_fadvise(fd, (off_t)local, (off_t)chunk, mode) != 0) {
+            return -1;
+        }
+        offset += chunk;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+// 追加一个区间，必要时扩容
+static int append_extent(disk_extent_t** extents, size_t* count, size_t* capacity,
+                         uint64_t offset, uint64_t length) {
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 16;
+        disk_extent_t* grown = (disk_extent_t*)realloc(*extents, new_capacity * sizeof(disk_extent_t));
+        if (!grown) {
+            return -1;
+        }
+        *extents = grown;
+        *capacity = new_capacity;
+    }
+
+    (*extents)[*count].offset = offset;
+    (*extents)[*count].length = length;
+    (*count)++;
+    return 0;
+}
+
+int disk_get_data_extents(disk_handle_t* handle, uint64_t start, uint64_t end,
+                          disk_extent_t** extents, size_t* count) {
+    if (!handle || !extents || !count) {
+        return -1;
+    }
+
+    *extents = NULL;
+    *count = 0;
+    size_t capacity = 0;
+
+    if (end > handle->size) {
+        end = handle->size;
+    }
+    if (start >= end) {
+        return 0;
+    }
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    struct stat st;
+    if (fstat(handle->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        // lseek 只改变文件偏移，所有读取都使用 pread，因此不影响并发读取
+        uint64_t pos = start;
+        int supported = 1;
+        while (supported && pos < end) {
+            uint64_t local;
+            uint64_t remaining;
+            int fd = disk_segment_at(handle, pos, &local, &remaining);
+            if (fd < 0) {
+                break;
+            }
+            uint64_t base = pos - local;
+            uint64_t segment_end = pos + remaining < end ? pos + remaining : end;
+
+            // 在当前分段内查找数据区间
+            off_t data = lseek(fd, (off_t)local, SEEK_DATA);
+            if (data < 0) {
+                if (errno != ENXIO) {
+                    supported = 0;  // 文件系统不支持，按整个范围处理
+                }
+                pos = segment_end;  // ENXIO：该分段之后没有数据
+                continue;
+            }
+            if (base + (uint64_t)data >= segment_end) {
+                pos = segment_end;
+                continue;
+            }
+
+            off_t hole = lseek(fd, data, SEEK_HOLE);
+            uint64_t data_start = base + (uint64_t)data;
+            uint64_t data_end = (hole < 0 || base + (uint64_t)hole > segment_end) ?
+                                segment_end : base + (uint64_t)hole;
+
+            // 与上一个区间相邻（跨分段）时合并
+            if (*count > 0 &&
+                (*extents)[*count - 1].offset + (*extents)[*count - 1].length == data_start) {
+                (*extents)[*count - 1].length += data_end - data_start;
+            } else if (append_extent(extents, count, &capacity, data_start,
+                                     data_end - data_start) < 0) {
+                free(*extents);
+                *extents = NULL;
+                *count = 0;
+                return -1;
+            }
+            pos = data_end;
+        }
+
+        if (supported) {
+            return 0;
+        }
+
+        free(*extents);
+        *extents = NULL;
+        *count = 0;
+        capacity = 0;
+    }
+#endif
+
+    if (append_extent(extents, count, &capacity, start, end - start) < 0) {
+        return -1;
+    }
+    return 0;
+}
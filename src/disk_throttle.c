@@ -0,0 +1,206 @@
+#define _GNU_SOURCE
+#include "disk_throttle.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define LATENCY_UNIT (64 * 1024)     // 延迟按 64KB 请求折算
+#define SCALE_STEP 0.05              // 每个周期的加性回升幅度
+#define SCALE_BACKOFF 0.5            // 繁忙时的乘性降速系数
+#define MIN_CONTENTION_NS 200000ULL  // 延迟至少升高 200us 才视为繁忙，过滤页缓存命中的抖动
+
+struct disk_throttle {
+    pthread_mutex_t lock;
+    uint64_t bytes_per_sec;   // 配置的带宽上限
+    uint32_t iops;            // 配置的 IOPS 上限
+    double scale;             // 自适应系数
+    double byte_tokens;       // 带宽令牌（可为负，表示透支）
+    double op_tokens;         // 请求令牌
+    uint64_t last_refill;     // 上次补充令牌的时间
+    uint64_t window_start;    // 当前调整周期的起点
+    uint64_t latency_ns;      // 平滑延迟（EWMA）
+    uint64_t baseline_ns;     // 基准延迟
+    disk_throttle_stats_t stats;
+};
+
+// 按经过的时间补充令牌，令牌数不超过桶容量
+static void refill(disk_throttle_t* t, uint64_t now) {
+    double elapsed = (double)(now - t->last_refill) / 1e9;
+    t->last_refill = now;
+
+    if (t->bytes_per_sec) {
+        double rate = (double)t->bytes_per_sec * t->scale;
+        double capacity = rate * DISK_THROTTLE_BURST_MS / 1000.0;
+        t->byte_tokens += elapsed * rate;
+        if (t->byte_tokens > capacity) {
+            t->byte_tokens = capacity;
+        }
+    }
+    if (t->iops) {
+        double rate = (double)t->iops * t->scale;
+        double capacity = rate * DISK_THROTTLE_BURST_MS / 1000.0;
+        if (capacity < 1.0) {
+            capacity = 1.0;
+        }
+        t->op_tokens += elapsed * rate;
+        if (t->op_tokens > capacity) {
+            t->op_tokens = capacity;
+        }
+    }
+}
+
+// 令牌补足到 0 所需的等待时间（纳秒）
+static uint64_t time_to_refill(const disk_throttle_t* t) {
+    double wait = 0.0;
+    if (t->bytes_per_sec && t->byte_tokens < 0) {
+        wait = -t->byte_tokens / ((double)t->bytes_per_sec * t->scale);
+    }
+    if (t->iops && t->op_tokens < 0) {
+        double op_wait = -t->op_tokens / ((double)t->iops * t->scale);
+        if (op_wait > wait) {
+            wait = op_wait;
+        }
+    }
+    return (uint64_t)(wait * 1e9) + 1;
+}
+
+disk_throttle_t* disk_throttle_create(uint64_t bytes_per_sec, uint32_t iops) {
+    if (bytes_per_sec == 0 && iops == 0) {
+        return NULL;
+    }
+
+    disk_throttle_t* t = (disk_throttle_t*)calloc(1, sizeof(disk_throttle_t));
+    if (!t) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    pthread_mutex_init(&t->lock, NULL);
+    t->bytes_per_sec = bytes_per_sec;
+    t->iops = iops;
+    t->scale = 1.0;
+    t->last_refill = utils_monotonic_ns();
+    t->window_start = t->last_refill;
+    t->stats.bytes_per_sec = bytes_per_sec;
+    t->stats.iops = iops;
+    return t;
+}
+
+void disk_throttle_destroy(disk_throttle_t* throttle) {
+    if (!throttle) {
+        return;
+    }
+
+    pthread_mutex_destroy(&throttle->lock);
+    free(throttle);
+}
+
+void disk_throttle_acquire(disk_throttle_t* throttle, size_t bytes) {
+    if (!throttle) {
+        return;
+    }
+
+    pthread_mutex_lock(&throttle->lock);
+    for (;;) {
+        uint64_t now = utils_monotonic_ns();
+        refill(throttle, now);
+
+        // 令牌未透支时放行（单个大请求可以透支，由后续请求偿还）
+        if (throttle->byte_tokens >= 0 && throttle->op_tokens >= 0) {
+            if (throttle->bytes_per_sec) {
+                throttle->byte_tokens -= (double)bytes;
+            }
+            if (throttle->iops) {
+                throttle->op_tokens -= 1.0;
+            }
+            throttle->stats.bytes += bytes;
+            throttle->stats.ops++;
+            break;
+        }
+
+        uint64_t wait = time_to_refill(throttle);
+        throttle->stats.waits++;
+        throttle->stats.wait_ns += wait;
+        pthread_mutex_unlock(&throttle->lock);
+
+        struct timespec ts = {
+            .tv_sec = (time_t)(wait / 1000000000ULL),
+            .tv_nsec = (long)(wait % 1000000000ULL)
+        };
+        nanosleep(&ts, NULL);
+
+        pthread_mutex_lock(&throttle->lock);
+    }
+    pthread_mutex_unlock(&throttle->lock);
+}
+
+void disk_throttle_record(disk_throttle_t* throttle, size_t bytes, uint64_t latency_ns) {
+    if (!throttle) {
+        return;
+    }
+
+    // 大请求的延迟按 64KB 折算，使不同大小的请求可以比较
+    if (bytes > LATENCY_UNIT) {
+        latency_ns = latency_ns * LATENCY_UNIT / bytes;
+    }
+
+    pthread_mutex_lock(&throttle->lock);
+
+    if (throttle->latency_ns == 0) {
+        throttle->latency_ns = latency_ns;
+        throttle->baseline_ns = latency_ns;
+    } else {
+        throttle->latency_ns = (throttle->latency_ns * 7 + latency_ns) / 8;
+    }
+
+    // 基准延迟跟踪平滑延迟的最小值，并缓慢上移以适应设备本身的变化
+    if (throttle->latency_ns < throttle->baseline_ns) {
+        throttle->baseline_ns = throttle->latency_ns;
+    } else {
+        throttle->baseline_ns += (throttle->latency_ns - throttle->baseline_ns) / 256;
+    }
+
+    uint64_t now = utils_monotonic_ns();
+    if (now - throttle->window_start >= DISK_THROTTLE_WINDOW_MS * 1000000ULL) {
+        throttle->window_start = now;
+        refill(throttle, now);
+
+        int contended = throttle->latency_ns > throttle->baseline_ns * DISK_THROTTLE_CONTENTION_FACTOR &&
+                        throttle->latency_ns > throttle->baseline_ns + MIN_CONTENTION_NS;
+        if (contended) {
+            throttle->scale *= SCALE_BACKOFF;
+            if (throttle->scale < DISK_THROTTLE_MIN_SCALE) {
+                throttle->scale = DISK_THROTTLE_MIN_SCALE;
+            }
+            throttle->stats.backoffs++;
+        } else if (throttle->scale < 1.0) {
+            throttle->scale += SCALE_STEP;
+            if (throttle->scale > 1.0) {
+                throttle->scale = 1.0;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&throttle->lock);
+}
+
+void disk_throttle_get_stats(disk_throttle_t* throttle, disk_throttle_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(disk_throttle_stats_t));
+    if (!throttle) {
+        return;
+    }
+
+    pthread_mutex_lock(&throttle->lock);
+    *stats = throttle->stats;
+    stats->scale = throttle->scale;
+    stats->latency_us = throttle->latency_ns / 1000;
+    stats->baseline_us = throttle->baseline_ns / 1000;
+    pthread_mutex_unlock(&throttle->lock);
+}
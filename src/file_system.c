@@ -216,8 +216,8 @@ int fs_parse_info(disk_handle_t* handle, fs_info_t* info) {
 }
 
 int fs_scan_deleted_files(disk_handle_t* handle, const fs_info_t* info,
-                         file_entry_t* entries, int max_entries) {
-    if (!handle || !info || !entries || max_entries <= 0) {
+                         fs_entry_callback_t callback, void* user_data) {
+    if (!handle || !info || !callback) {
         return 0;
     }
 
@@ -257,7 +257,7 @@ int fs_scan_deleted_files(disk_handle_t* handle, const fs_info_t* info,
     fat_dir_entry_t* dir_entries = (fat_dir_entry_t*)buffer;
     int num_entries = scan_size / sizeof(fat_dir_entry_t);
 
-    for (int i = 0; i < num_entries && found_count < max_entries; i++) {
+    for (int i = 0; i < num_entries; i++) {
         fat_dir_entry_t* entry = &dir_entries[i];
         
         // 跳过空项
@@ -267,7 +267,8 @@ int fs_scan_deleted_files(disk_handle_t* handle, const fs_info_t* info,
         
         // 检查已删除的文件（第一个字节为 0xE5）
         if ((uint8_t)entry->name[0] == 0xE5 && entry->attr != 0x0F) {
-            file_entry_t* fe = &entries[found_count];
+            file_entry_t deleted;
+            file_entry_t* fe = &deleted;
             memset(fe, 0, sizeof(file_entry_t));
             
             // 恢复文件名的第一个字符为 '?'
@@ -293,6 +294,9 @@ int fs_scan_deleted_files(disk_handle_t* handle, const fs_info_t* info,
             fe->fs_type = info->type;
             
             found_count++;
+            if (callback(fe, user_data) != 0) {
+                break;
+            }
         }
     }
 
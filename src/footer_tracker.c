@@ -0,0 +1,254 @@
+#include "footer_tracker.h"
+#include "signature_matcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_PATTERN UINT32_MAX
+
+// 一种文件尾标记（标记字节、固定字节数和长度字段都相同的类型共用）
+typedef struct {
+    const file_type_info_t* info; // 第一个使用该标记的类型
+    size_t need;              // 标记和长度字段的字节数
+} footer_pattern_t;
+
+struct footer_tracker {
+    footer_pattern_t* patterns;
+    file_signature_t* magics; // 以标记为魔数的伪签名（下标即标记编号）
+    uint32_t pattern_count;
+    uint32_t* type_patterns;  // 按类型编号索引的标记编号
+    size_t type_slots;
+    size_t max_need;
+    signature_matcher_t* matcher;
+};
+
+static int same_footer(const file_type_info_t* a, const file_type_info_t* b) {
+    return a->footer_len == b->footer_len && a->footer_extra == b->footer_extra &&
+           a->length_field == b->length_field && memcmp(a->footer, b->footer, a->footer_len) == 0;
+}
+
+footer_tracker_t* footer_tracker_create(const file_signature_t* signatures, size_t count) {
+    size_t slots = FILE_TYPE_MAX;
+    for (size_t i = 0; i < count; i++) {
+        if ((size_t)signatures[i].type >= slots) {
+            slots = (size_t)signatures[i].type + 1;
+        }
+    }
+
+    footer_tracker_t* t = (footer_tracker_t*)calloc(1, sizeof(footer_tracker_t));
+    if (!t) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+    t->patterns = (footer_pattern_t*)calloc(slots, sizeof(footer_pattern_t));
+    t->magics = (file_signature_t*)calloc(slots, sizeof(file_signature_t));
+    t->type_patterns = (uint32_t*)malloc(slots * sizeof(uint32_t));
+    if (!t->patterns || !t->magics || !t->type_patterns) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        footer_tracker_destroy(t);
+        return NULL;
+    }
+    t->type_slots = slots;
+
+    // 分类后的类型不一定有自己的签名，按类型编号逐个查询大小规则
+    for (size_t type = 0; type < slots; type++) {
+        t->type_patterns[type] = NO_PATTERN;
+        const file_type_info_t* info = signature_get_type_info((file_type_t)type);
+        uint64_t from;
+        uint64_t to;
+        if (!info || signature_footer_window(info, &from, &to) < 0) {
+            continue;
+        }
+
+        uint32_t p = 0;
+        while (p < t->pattern_count && !same_footer(t->patterns[p].info, info)) {
+            p++;
+        }
+        if (p == t->pattern_count) {
+            t->patterns[p].info = info;
+            t->patterns[p].need = signature_footer_need(info);
+            t->magics[p].type = info->type;
+            t->magics[p].magic = info->footer;
+            t->magics[p].magic_len = info->footer_len;
+            t->magics[p].description = "footer";
+            if (t->patterns[p].need > t->max_need) {
+                t->max_need = t->patterns[p].need;
+            }
+            t->pattern_count++;
+        }
+        t->type_patterns[type] = p;
+    }
+
+    if (t->pattern_count == 0) {
+        footer_tracker_destroy(t);
+        return NULL;
+    }
+    t->matcher = signature_matcher_create(t->magics, t->pattern_count);
+    if (!t->matcher) {
+        footer_tracker_destroy(t);
+        return NULL;
+    }
+    return t;
+}
+
+void footer_tracker_destroy(footer_tracker_t* tracker) {
+    if (!tracker) {
+        return;
+    }
+    if (tracker->matcher) {
+        signature_matcher_destroy(tracker->matcher);
+    }
+    free(tracker->type_patterns);
+    free(tracker->magics);
+    free(tracker->patterns);
+    free(tracker);
+}
+
+size_t footer_tracker_max_need(const footer_tracker_t* tracker) {
+    return tracker ? tracker->max_need : 0;
+}
+
+int footer_tracker_open(const footer_tracker_t* tracker, const file_signature_t* signature,
+                        file_type_t type, uint64_t offset, footer_candidate_t* candidate) {
+    // 自定义的文件尾搜索函数可能不只是查找标记
+    if (!tracker || !signature || !candidate || signature->find_footer ||
+        (size_t)type >= tracker->type_slots || tracker->type_patterns[type] == NO_PATTERN) {
+        return 0;
+    }
+
+    const file_type_info_t* info = signature_get_type_info(type);
+    uint64_t from;
+    uint64_t to;
+    if (!info || signature_footer_window(info, &from, &to) < 0) {
+        return 0;
+    }
+    candidate->offset = offset;
+    candidate->from = offset + from;
+    candidate->to = offset + to;
+    candidate->default_size = info->default_size;
+    candidate->pattern = tracker->type_patterns[type];
+    candidate->info = info;
+    return 1;
+}
+
+// 一次扫描的状态
+typedef struct {
+    const footer_tracker_t* tracker;
+    const uint8_t* data;
+    size_t size;
+    size_t available;
+    uint64_t offset;
+    signature_read_fn read;
+    void* source;
+    footer_hit_t** hits;
+    size_t* count;
+    size_t* capacity;
+    int failed;
+} footer_scan_t;
+
+static int on_footer(const signature_match_t* match, void* user_data) {
+    footer_scan_t* scan = (footer_scan_t*)user_data;
+    // 起始位置在重叠部分的标记由下一数据块报告
+    if (match->position >= scan->size) {
+        return 1;
+    }
+
+    const footer_pattern_t* pattern = &scan->tracker->patterns[match->signature];
+    uint64_t position = scan->offset + match->position;
+    const uint8_t* footer = scan->data + match->position;
+    uint8_t tail[64];
+    if (match->position + pattern->need > scan->available) {
+        // 长度字段超出可用数据（区间末尾），单独读取
+        if (pattern->need > sizeof(tail) || !scan->read ||
+            scan->read(scan->source, position, tail, pattern->need) < (int64_t)pattern->need) {
+            return 0;
+        }
+        footer = tail;
+    }
+
+    if (*scan->count == *scan->capacity) {
+        size_t grown = *scan->capacity ? *scan->capacity * 2 : 64;
+        footer_hit_t* resized = (footer_hit_t*)realloc(*scan->hits, grown * sizeof(footer_hit_t));
+        if (!resized) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            scan->failed = 1;
+            return 1;
+        }
+        *scan->hits = resized;
+        *scan->capacity = grown;
+    }
+    footer_hit_t* hit = &(*scan->hits)[(*scan->count)++];
+    hit->offset = position;
+    hit->end = signature_footer_end(pattern->info, position, footer);
+    hit->pattern = match->signature;
+    return 0;
+}
+
+int footer_tracker_scan(const footer_tracker_t* tracker, const uint8_t* data, size_t size,
+                        size_t available, uint64_t offset, signature_read_fn read, void* source,
+                        footer_hit_t** hits, size_t* count, size_t* capacity) {
+    if (!tracker || !data || !hits || !count || !capacity || available < size) {
+        return -1;
+    }
+
+    footer_scan_t scan = {
+        .tracker = tracker,
+        .data = data,
+        .size = size,
+        .available = available,
+        .offset = offset,
+        .read = read,
+        .source = source,
+        .hits = hits,
+        .count = count,
+        .capacity = capacity,
+        .failed = 0
+    };
+    if (signature_matcher_scan(tracker->matcher, data, available, on_footer, &scan) < 0 || scan.failed) {
+        return -1;
+    }
+    return 0;
+}
+
+int footer_tracker_match(const footer_candidate_t* candidate, const footer_hit_t* hits, size_t count,
+                         uint64_t* size) {
+    if (!candidate || !size) {
+        return -1;
+    }
+
+    // 第一个不早于 from 的标记
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (hits[mid].offset < candidate->from) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (size_t i = lo; i < count && hits[i].offset <= candidate->to; i++) {
+        if (hits[i].pattern == candidate->pattern) {
+            *size = hits[i].end - candidate->offset;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int footer_tracker_search(const footer_candidate_t* candidate, const signature_candidate_t* source,
+                          uint64_t from, uint64_t* size) {
+    if (!candidate || !size) {
+        return -1;
+    }
+
+    uint64_t start = from > candidate->from ? from : candidate->from;
+    if (source && start <= candidate->to &&
+        signature_find_footer_range(source, candidate->info, start - candidate->offset,
+                                    candidate->to - candidate->offset, size) == 0) {
+        return 0;
+    }
+    *size = candidate->default_size;
+    return -1;
+}
@@ -1,6 +1,7 @@
 #include "recovery.h"
 #include "utils.h"
 #include "signature.h"
+#include "disk_aio.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,42 +11,19 @@
 
 #define RECOVERY_BUFFER_SIZE (1024 * 1024)  // 1MB
 
-recovery_status_t recovery_recover_file(disk_handle_t* handle, 
-                                       const scan_result_t* result,
-                                       const char* output_path) {
-    if (!handle || !result || !output_path) {
-        return RECOVERY_FAILED;
-    }
-
-    if (result->size == 0) {
-        fprintf(stderr, "Error: File size is zero\n");
-        return RECOVERY_FAILED;
-    }
-
-    printf("Recovering file to: %s\n", output_path);
-    printf("  Offset: 0x%llx\n", (unsigned long long)result->offset);
-    printf("  Size: %llu bytes\n", (unsigned long long)result->size);
-    printf("  Type: %s\n", signature_get_description(result->type));
-
-    // 创建输出文件
-    int out_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (out_fd < 0) {
-        fprintf(stderr, "Error: Cannot create output file: %s\n", strerror(errno));
-        return RECOVERY_FAILED;
-    }
-
+// 单个缓冲区顺序复制（小文件）
+static recovery_status_t copy_sync(disk_handle_t* handle, const scan_result_t* result,
+                                   int out_fd, uint64_t* total_recovered) {
     // 分配缓冲区
     uint8_t* buffer = (uint8_t*)malloc(RECOVERY_BUFFER_SIZE);
     if (!buffer) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        close(out_fd);
         return RECOVERY_FAILED;
     }
 
     recovery_status_t status = RECOVERY_SUCCESS;
     uint64_t remaining = result->size;
     uint64_t current_offset = result->offset;
-    uint64_t total_recovered = 0;
 
     while (remaining > 0) {
         // 计算本次读取大小
@@ -70,21 +48,222 @@ recovery_status_t recovery_recover_file(disk_handle_t* handle,
             break;
         }
 
-        total_recovered += bytes_read;
+        *total_recovered += bytes_read;
         remaining -= bytes_read;
         current_offset += bytes_read;
 
         // 显示进度
-        int progress = utils_calculate_progress(total_recovered, result->size);
+        int progress = utils_calculate_progress(*total_recovered, result->size);
         utils_show_progress(progress, "Recovering...");
     }
 
     free(buffer);
+    return status;
+}
+
+// 提交一段读取；提交失败时改为同步读取到槽位缓冲区，结果直接记为已完成
+static void submit_piece(disk_aio_t* aio, disk_handle_t* handle, disk_aio_event_t* completed,
+                         uint32_t slot, uint64_t offset, size_t size) {
+    if (disk_aio_submit(aio, slot, offset, size, NULL) == 0) {
+        return;
+    }
+    uint8_t* buffer = disk_aio_buffer(aio, slot);
+    completed[slot].slot = slot;
+    completed[slot].offset = offset;
+    completed[slot].result = disk_read(handle, offset, buffer, size);
+    completed[slot].data = buffer;
+    completed[slot].user_data = NULL;
+}
+
+// 多请求在途的异步复制（大文件），按偏移顺序写出
+static recovery_status_t copy_async(disk_handle_t* handle, const scan_result_t* result,
+                                    int out_fd, uint32_t io_depth,
+                                    uint64_t* total_recovered) {
+    disk_aio_t* aio = disk_aio_create(handle, io_depth, RECOVERY_BUFFER_SIZE);
+    if (!aio) {
+        return copy_sync(handle, result, out_fd, total_recovered);
+    }
+
+    uint32_t depth = disk_aio_depth(aio);
+    disk_aio_event_t* completed = (disk_aio_event_t*)malloc(depth * sizeof(disk_aio_event_t));
+    if (!completed) {
+        disk_aio_destroy(aio);
+        return copy_sync(handle, result, out_fd, total_recovered);
+    }
+
+    // 未完成的槽位标记为 -2
+    for (uint32_t i = 0; i < depth; i++) {
+        completed[i].result = -2;
+    }
+
+    recovery_status_t status = RECOVERY_SUCCESS;
+    uint64_t end = result->offset + result->size;
+    uint64_t submit_offset = result->offset;
+    uint64_t current_offset = result->offset;
+
+    for (uint32_t slot = 0; slot < depth && submit_offset < end; slot++) {
+        size_t read_size = (end - submit_offset > RECOVERY_BUFFER_SIZE) ?
+                          RECOVERY_BUFFER_SIZE : (end - submit_offset);
+        submit_piece(aio, handle, completed, slot, submit_offset, read_size);
+        submit_offset += read_size;
+    }
+
+    uint32_t head = 0;
+    while (current_offset < end) {
+        // 等待队首槽位完成
+        while (completed[head].result == -2) {
+            disk_aio_event_t event;
+            if (disk_aio_wait(aio, &event) < 0) {
+                break;
+            }
+            completed[event.slot] = event;
+        }
+
+        ssize_t bytes_read = completed[head].result;
+        completed[head].result = -2;
+        if (bytes_read == -2) {
+            fprintf(stderr, "Error: Asynchronous read at offset 0x%llx did not complete\n",
+                    (unsigned long long)current_offset);
+            status = RECOVERY_PARTIAL;
+            break;
+        }
+        if (bytes_read <= 0) {
+            fprintf(stderr, "Error: Failed to read from disk at offset 0x%llx\n", 
+                   (unsigned long long)current_offset);
+            status = RECOVERY_PARTIAL;
+            break;
+        }
+
+        // 写入输出文件
+        ssize_t bytes_written = write(out_fd, completed[head].data, bytes_read);
+        if (bytes_written != bytes_read) {
+            fprintf(stderr, "Error: Failed to write to output file: %s\n", 
+                   strerror(errno));
+            status = RECOVERY_PARTIAL;
+            break;
+        }
+
+        *total_recovered += bytes_read;
+        current_offset += bytes_read;
+
+        // 复用槽位提交下一段
+        if (submit_offset < end) {
+            size_t read_size = (end - submit_offset > RECOVERY_BUFFER_SIZE) ?
+                              RECOVERY_BUFFER_SIZE : (end - submit_offset);
+            submit_piece(aio, handle, completed, head, submit_offset, read_size);
+            submit_offset += read_size;
+        }
+        head = (head + 1) % depth;
+
+        // 显示进度
+        int progress = utils_calculate_progress(*total_recovered, result->size);
+        utils_show_progress(progress, "Recovering...");
+    }
+
+    free(completed);
+    disk_aio_destroy(aio);
+    return status;
+}
+
+// 映射模式：直接从映射区写出，无需中间缓冲区
+static recovery_status_t copy_mapped(disk_handle_t* handle, const scan_result_t* result,
+                                     int out_fd, uint64_t* total_recovered) {
+    recovery_status_t status = RECOVERY_SUCCESS;
+    uint64_t remaining = result->size;
+    uint64_t current_offset = result->offset;
+
+    disk_advise(handle, result->offset, result->size, DISK_ADVICE_WILLNEED);
+
+    while (remaining > 0) {
+        size_t chunk = (remaining > RECOVERY_BUFFER_SIZE) ? 
+                      RECOVERY_BUFFER_SIZE : remaining;
+
+        size_t available = 0;
+        const uint8_t* data = disk_map_range(handle, current_offset, chunk, &available);
+        if (!data || available == 0) {
+            fprintf(stderr, "Error: Failed to read from disk at offset 0x%llx\n", 
+                   (unsigned long long)current_offset);
+            status = RECOVERY_PARTIAL;
+            break;
+        }
+
+        ssize_t bytes_written = write(out_fd, data, available);
+        if (bytes_written != (ssize_t)available) {
+            fprintf(stderr, "Error: Failed to write to output file: %s\n", 
+                   strerror(errno));
+            status = RECOVERY_PARTIAL;
+            break;
+        }
+
+        *total_recovered += available;
+        remaining -= available;
+        current_offset += available;
+
+        // 显示进度
+        int progress = utils_calculate_progress(*total_recovered, result->size);
+        utils_show_progress(progress, "Recovering...");
+    }
+
+    return status;
+}
+
+static recovery_status_t recover_file(disk_handle_t* handle,
+                                      const scan_result_t* result,
+                                      const char* output_path,
+                                      uint32_t io_depth) {
+    if (!handle || !result || !output_path) {
+        return RECOVERY_FAILED;
+    }
+
+    if (result->size == 0) {
+        fprintf(stderr, "Error: File size is zero\n");
+        return RECOVERY_FAILED;
+    }
+
+    printf("Recovering file to: %s\n", output_path);
+    printf("  Offset: 0x%llx\n", (unsigned long long)result->offset);
+    printf("  Size: %llu bytes\n", (unsigned long long)result->size);
+    printf("  Type: %s\n", signature_get_description(result->type));
+
+    // 创建输出文件
+    int out_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        fprintf(stderr, "Error: Cannot create output file: %s\n", strerror(errno));
+        return RECOVERY_FAILED;
+    }
+
+    // 先重试文件范围内被跳过的区域，尽量减少需要填零的部分
+    disk_extent_t* retried = NULL;
+    size_t retried_count = 0;
+    if (disk_retry_skipped(handle, result->offset, result->offset + result->size,
+                           &retried, &retried_count) == 0) {
+        free(retried);
+    }
+
+    // 映射模式零拷贝写出；超过单个缓冲区的文件使用异步读取，保持多个请求在途
+    uint64_t total_recovered = 0;
+    recovery_status_t status;
+    if (disk_is_mapped(handle)) {
+        status = copy_mapped(handle, result, out_fd, &total_recovered);
+    } else if (result->size > RECOVERY_BUFFER_SIZE) {
+        status = copy_async(handle, result, out_fd, io_depth, &total_recovered);
+    } else {
+        status = copy_sync(handle, result, out_fd, &total_recovered);
+    }
+
     close(out_fd);
 
+    // 容错读取时无法读取的区域以零填充，文件只能算部分恢复
+    uint64_t unreadable = disk_unreadable_bytes(handle, result->offset, result->size);
+    if (unreadable > 0 && status == RECOVERY_SUCCESS) {
+        fprintf(stderr, "\nWarning: %llu bytes could not be read and were zero-filled\n",
+                (unsigned long long)unreadable);
+        status = RECOVERY_PARTIAL;
+    }
+
     if (status == RECOVERY_SUCCESS) {
         printf("\nFile recovered successfully: %s\n", output_path);
-    } else {
+    } else if (status == RECOVERY_PARTIAL) {
         printf("\nFile partially recovered: %s (%llu of %llu bytes)\n", 
                output_path, (unsigned long long)total_recovered, 
                (unsigned long long)result->size);
@@ -93,11 +272,17 @@ recovery_status_t recovery_recover_file(disk_handle_t* handle,
     return status;
 }
 
-int recovery_recover_batch(disk_handle_t* handle,
-                          const scan_result_t* results,
-                          int count,
-                          const recovery_options_t* options) {
-    if (!handle || !results || count <= 0 || !options) {
+recovery_status_t recovery_recover_file(disk_handle_t* handle, 
+                                       const scan_result_t* result,
+                                       const char* output_path) {
+    return recover_file(handle, result, output_path, DISK_AIO_DEFAULT_DEPTH);
+}
+
+uint64_t recovery_recover_batch(disk_handle_t* handle,
+                               result_sink_t* results,
+                               const recovery_options_t* options) {
+    uint64_t count = result_sink_count(results);
+    if (!handle || count == 0 || !options) {
         return 0;
     }
 
@@ -115,19 +300,23 @@ int recovery_recover_batch(disk_handle_t* handle,
 
     printf("Batch recovery starting...\n");
     printf("Output directory: %s\n", options->output_dir);
-    printf("Total files: %d\n", count);
+    printf("Total files: %llu\n", (unsigned long long)count);
 
-    int success_count = 0;
+    uint64_t success_count = 0;
     char output_path[1024];
     char base_name[256];
 
-    for (int i = 0; i < count; i++) {
-        const scan_result_t* result = &results[i];
+    for (uint64_t i = 0; i < count; i++) {
+        scan_result_t entry;
+        if (result_sink_get(results, i, &entry) < 0) {
+            break;
+        }
+        const scan_result_t* result = &entry;
         
         // 生成输出文件名
         const char* ext = signature_get_extension(result->type);
-        snprintf(base_name, sizeof(base_name), "%s/recovered_%04d", 
-                options->output_dir, i + 1);
+        snprintf(base_name, sizeof(base_name), "%s/recovered_%04llu", 
+                options->output_dir, (unsigned long long)(i + 1));
         
         utils_generate_unique_filename(base_name, ext, 
                                        output_path, sizeof(output_path));
@@ -139,8 +328,9 @@ int recovery_recover_batch(disk_handle_t* handle,
         }
 
         // 恢复文件
-        printf("\n[%d/%d] ", i + 1, count);
-        recovery_status_t status = recovery_recover_file(handle, result, output_path);
+        printf("\n[%llu/%llu] ", (unsigned long long)(i + 1), (unsigned long long)count);
+        recovery_status_t status = recover_file(handle, result, output_path,
+                                               options->io_depth);
         
         if (status == RECOVERY_SUCCESS) {
             success_count++;
@@ -157,9 +347,9 @@ int recovery_recover_batch(disk_handle_t* handle,
     }
 
     printf("\n=== Batch Recovery Complete ===\n");
-    printf("Total files: %d\n", count);
-    printf("Successfully recovered: %d\n", success_count);
-    printf("Failed: %d\n", count - success_count);
+    printf("Total files: %llu\n", (unsigned long long)count);
+    printf("Successfully recovered: %llu\n", (unsigned long long)success_count);
+    printf("Failed: %llu\n", (unsigned long long)(count - success_count));
 
     return success_count;
 }
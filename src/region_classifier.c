@@ -0,0 +1,145 @@
+#define _GNU_SOURCE
+#include "region_classifier.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define REGION_X86 1
+#endif
+
+#define SAMPLE_STRIDE 4                                   // 估算熵时每 4 个字节取 1 个
+#define SAMPLE_COUNT (REGION_CLASSIFIER_UNIT / SAMPLE_STRIDE)
+
+// 检查数据是否以 16 字节为周期重复（覆盖零填充、单字节填充和 2/4/8/16 字节的擦除模式）
+typedef int (*is_fill_fn)(const uint8_t* data, size_t size);
+
+struct region_classifier {
+    double max_entropy;                       // 熵阈值
+    float plogp[SAMPLE_COUNT + 1];            // c * log2(c)，估算熵时查表
+    is_fill_fn is_fill;                       // 按 CPU 选择的实现
+    const char* isa;                          // 实现使用的指令集
+};
+
+static int is_fill_scalar(const uint8_t* data, size_t size) {
+    return size <= 16 || memcmp(data, data + 16, size - 16) == 0;
+}
+
+#ifdef REGION_X86
+__attribute__((target("sse2")))
+static int is_fill_sse2(const uint8_t* data, size_t size) {
+    if (size < 64) {
+        return is_fill_scalar(data, size);
+    }
+    __m128i first = _mm_loadu_si128((const __m128i*)data);
+    size_t pos = 16;
+    // 每次比较 64 字节，有差异时尽早退出
+    for (; pos + 64 <= size; pos += 64) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + pos)), first);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + pos + 16)), first);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + pos + 32)), first);
+        __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + pos + 48)), first);
+        __m128i all = _mm_and_si128(_mm_and_si128(a, b), _mm_and_si128(c, d));
+        if (_mm_movemask_epi8(all) != 0xFFFF) {
+            return 0;
+        }
+    }
+    return memcmp(data + pos - 16, data + pos, size - pos) == 0;
+}
+
+__attribute__((target("avx2")))
+static int is_fill_avx2(const uint8_t* data, size_t size) {
+    if (size < 128) {
+        return is_fill_scalar(data, size);
+    }
+    // 前 16 字节复制到两个通道，与每 32 字节比较
+    __m256i first = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)data));
+    size_t pos = 16;
+    for (; pos + 128 <= size; pos += 128) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + pos)), first);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + pos + 32)), first);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + pos + 64)), first);
+        __m256i d = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + pos + 96)), first);
+        __m256i all = _mm256_and_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, d));
+        if ((uint32_t)_mm256_movemask_epi8(all) != 0xFFFFFFFFu) {
+            return 0;
+        }
+    }
+    return memcmp(data + pos - 16, data + pos, size - pos) == 0;
+}
+#endif
+
+region_classifier_t* region_classifier_create(double max_entropy) {
+    region_classifier_t* c = (region_classifier_t*)calloc(1, sizeof(region_classifier_t));
+    if (!c) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    c->max_entropy = max_entropy >= 0 ? max_entropy : REGION_CLASSIFIER_DEFAULT_MAX_ENTROPY;
+    for (int i = 1; i <= SAMPLE_COUNT; i++) {
+        c->plogp[i] = (float)(i * log2((double)i));
+    }
+
+    c->is_fill = is_fill_scalar;
+    c->isa = "scalar";
+#ifdef REGION_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        c->is_fill = is_fill_avx2;
+        c->isa = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        c->is_fill = is_fill_sse2;
+        c->isa = "sse2";
+    }
+#endif
+    return c;
+}
+
+void region_classifier_destroy(region_classifier_t* classifier) {
+    free(classifier);
+}
+
+// 字节熵的估计：按间隔取样计数（直方图无法向量化，取样使开销降为四分之一），
+// H = log2(n) - sum(c * log2(c)) / n，再加上 Miller-Madow 修正 (k - 1) / (2n ln 2)
+// 抵消样本少时的低估（k 为出现过的字节值数量），随机数据的估计值仍在 7.93 以上
+static double unit_entropy(const region_classifier_t* c, const uint8_t* data) {
+    uint16_t hist[2][256];
+    memset(hist, 0, sizeof(hist));
+    for (size_t i = 0; i < REGION_CLASSIFIER_UNIT; i += SAMPLE_STRIDE * 2) {
+        hist[0][data[i]]++;
+        hist[1][data[i + SAMPLE_STRIDE]]++;
+    }
+
+    float sum = 0;
+    int distinct = 0;
+    for (int b = 0; b < 256; b++) {
+        int count = hist[0][b] + hist[1][b];
+        sum += c->plogp[count];
+        distinct += count != 0;
+    }
+    double n = SAMPLE_COUNT;
+    return log2(n) - (double)sum / n + (distinct - 1) / (2.0 * n * M_LN2);
+}
+
+region_class_t region_classify(const region_classifier_t* classifier, const uint8_t* data, size_t size) {
+    if (!classifier || !data || size == 0 || size > REGION_CLASSIFIER_UNIT) {
+        return REGION_DATA;
+    }
+    // 太短的数据不足以判断重复模式
+    if (size >= 64 && classifier->is_fill(data, size)) {
+        return REGION_FILL;
+    }
+    // 不足一个单元时估算的熵偏低，不按熵分类
+    if (size == REGION_CLASSIFIER_UNIT && classifier->max_entropy <= 8.0 &&
+        unit_entropy(classifier, data) >= classifier->max_entropy) {
+        return REGION_RANDOM;
+    }
+    return REGION_DATA;
+}
+
+const char* region_classifier_isa(const region_classifier_t* classifier) {
+    return classifier ? classifier->isa : "none";
+}
@@ -0,0 +1,281 @@
+#define _GNU_SOURCE
+#include "result_sink.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SPILL_MAGIC "DASRESLT"
+#define SPILL_VERSION 1
+
+// 溢出文件头
+typedef struct {
+    char magic[8];            // SPILL_MAGIC
+    uint32_t version;         // SPILL_VERSION
+    uint32_t record_size;     // sizeof(spill_record_t)
+} spill_header_t;
+
+// 溢出文件中的一个结果
+typedef struct __attribute__((packed)) {
+    uint64_t offset;
+    uint64_t size;
+    uint16_t type;
+    uint8_t confidence;
+    uint8_t reserved;
+} spill_record_t;
+
+struct result_sink {
+    scan_result_t** chunks;   // 内存中的分块（没有溢出文件时）
+    size_t chunk_count;
+    size_t chunk_capacity;
+    uint64_t count;
+
+    int fd;                   // 溢出文件（-1 表示没有）
+    char* path;
+    uint64_t spilled;         // 已写入文件的结果数
+    scan_result_t* tail;      // 尚未写入文件的结果 [spilled, count)
+    scan_result_t* cache;     // 最近读取的分块
+    uint64_t cache_first;     // 缓存中第一个结果的编号
+    size_t cache_count;       // 缓存中的结果数（0 表示没有缓存）
+    spill_record_t* records;  // 编码和解码用的记录缓冲区
+};
+
+static int write_at(int fd, const void* data, size_t size, uint64_t offset) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t written = pwrite(fd, (const uint8_t*)data + total, size - total, (off_t)(offset + total));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t)written;
+    }
+    return 0;
+}
+
+static int read_at(int fd, void* data, size_t size, uint64_t offset) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t got = pread(fd, (uint8_t*)data + total, size - total, (off_t)(offset + total));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return -1;
+        }
+        total += (size_t)got;
+    }
+    return 0;
+}
+
+static uint64_t record_position(uint64_t index) {
+    return sizeof(spill_header_t) + index * sizeof(spill_record_t);
+}
+
+static void encode(const scan_result_t* result, spill_record_t* record) {
+    record->offset = result->offset;
+    record->size = result->size;
+    record->type = (uint16_t)result->type;
+    record->confidence = result->confidence;
+    record->reserved = 0;
+}
+
+static void decode(const spill_record_t* record, scan_result_t* result) {
+    result->offset = record->offset;
+    result->size = record->size;
+    result->type = (file_type_t)record->type;
+    result->confidence = record->confidence;
+}
+
+result_sink_t* result_sink_create(const char* spill_path) {
+    result_sink_t* sink = (result_sink_t*)calloc(1, sizeof(result_sink_t));
+    if (!sink) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+    sink->fd = -1;
+    if (!spill_path) {
+        return sink;
+    }
+
+    sink->path = strdup(spill_path);
+    sink->tail = (scan_result_t*)malloc(RESULT_SINK_CHUNK * sizeof(scan_result_t));
+    sink->cache = (scan_result_t*)malloc(RESULT_SINK_CHUNK * sizeof(scan_result_t));
+    sink->records = (spill_record_t*)malloc(RESULT_SINK_CHUNK * sizeof(spill_record_t));
+    if (!sink->path || !sink->tail || !sink->cache || !sink->records) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        result_sink_destroy(sink);
+        return NULL;
+    }
+
+    sink->fd = open(spill_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (sink->fd < 0) {
+        fprintf(stderr, "Error: Cannot create result spill file '%s': %s\n", spill_path, strerror(errno));
+        result_sink_destroy(sink);
+        return NULL;
+    }
+
+    spill_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SPILL_MAGIC, sizeof(header.magic));
+    header.version = SPILL_VERSION;
+    header.record_size = sizeof(spill_record_t);
+    if (write_at(sink->fd, &header, sizeof(header), 0) < 0) {
+        fprintf(stderr, "Error: Cannot write result spill file '%s': %s\n", spill_path, strerror(errno));
+        result_sink_destroy(sink);
+        return NULL;
+    }
+    return sink;
+}
+
+void result_sink_destroy(result_sink_t* sink) {
+    if (!sink) {
+        return;
+    }
+
+    if (sink->fd >= 0) {
+        result_sink_flush(sink);
+        close(sink->fd);
+    }
+    for (size_t i = 0; i < sink->chunk_count; i++) {
+        free(sink->chunks[i]);
+    }
+    free(sink->chunks);
+    free(sink->records);
+    free(sink->cache);
+    free(sink->tail);
+    free(sink->path);
+    free(sink);
+}
+
+int result_sink_flush(result_sink_t* sink) {
+    if (!sink) {
+        return -1;
+    }
+    if (sink->fd < 0 || sink->count == sink->spilled) {
+        return 0;
+    }
+
+    size_t n = (size_t)(sink->count - sink->spilled);
+    for (size_t i = 0; i < n; i++) {
+        encode(&sink->tail[i], &sink->records[i]);
+    }
+    if (write_at(sink->fd, sink->records, n * sizeof(spill_record_t), record_position(sink->spilled)) < 0) {
+        fprintf(stderr, "Error: Cannot write result spill file '%s': %s\n", sink->path, strerror(errno));
+        return -1;
+    }
+    sink->spilled = sink->count;
+    return 0;
+}
+
+int64_t result_sink_append(result_sink_t* sink, const scan_result_t* result) {
+    if (!sink || !result) {
+        return -1;
+    }
+
+    if (sink->fd >= 0) {
+        // 追加分块已满时整块写入文件
+        if (sink->count - sink->spilled == RESULT_SINK_CHUNK && result_sink_flush(sink) < 0) {
+            return -1;
+        }
+        sink->tail[sink->count - sink->spilled] = *result;
+        return (int64_t)sink->count++;
+    }
+
+    size_t chunk = (size_t)(sink->count / RESULT_SINK_CHUNK);
+    if (chunk == sink->chunk_count) {
+        if (sink->chunk_count == sink->chunk_capacity) {
+            size_t grown = sink->chunk_capacity ? sink->chunk_capacity * 2 : 16;
+            scan_result_t** chunks = (scan_result_t**)realloc(sink->chunks, grown * sizeof(scan_result_t*));
+            if (!chunks) {
+                fprintf(stderr, "Error: Memory allocation failed\n");
+                return -1;
+            }
+            sink->chunks = chunks;
+            sink->chunk_capacity = grown;
+        }
+        sink->chunks[chunk] = (scan_result_t*)malloc(RESULT_SINK_CHUNK * sizeof(scan_result_t));
+        if (!sink->chunks[chunk]) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            return -1;
+        }
+        sink->chunk_count++;
+    }
+    sink->chunks[chunk][sink->count % RESULT_SINK_CHUNK] = *result;
+    return (int64_t)sink->count++;
+}
+
+// 把编号所在的分块从溢出文件读入缓存
+static int load_chunk(result_sink_t* sink, uint64_t index) {
+    uint64_t first = index - index % RESULT_SINK_CHUNK;
+    size_t n = sink->spilled - first < RESULT_SINK_CHUNK ? (size_t)(sink->spilled - first) : RESULT_SINK_CHUNK;
+    if (read_at(sink->fd, sink->records, n * sizeof(spill_record_t), record_position(first)) < 0) {
+        fprintf(stderr, "Error: Cannot read result spill file '%s'\n", sink->path);
+        sink->cache_count = 0;
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        decode(&sink->records[i], &sink->cache[i]);
+    }
+    sink->cache_first = first;
+    sink->cache_count = n;
+    return 0;
+}
+
+static int cached(const result_sink_t* sink, uint64_t index) {
+    return sink->cache_count > 0 && index >= sink->cache_first && index - sink->cache_first < sink->cache_count;
+}
+
+int result_sink_get(result_sink_t* sink, uint64_t index, scan_result_t* result) {
+    if (!sink || !result || index >= sink->count) {
+        return -1;
+    }
+
+    if (sink->fd < 0) {
+        *result = sink->chunks[index / RESULT_SINK_CHUNK][index % RESULT_SINK_CHUNK];
+        return 0;
+    }
+    if (index >= sink->spilled) {
+        *result = sink->tail[index - sink->spilled];
+        return 0;
+    }
+    if (!cached(sink, index) && load_chunk(sink, index) < 0) {
+        return -1;
+    }
+    *result = sink->cache[index - sink->cache_first];
+    return 0;
+}
+
+int result_sink_update(result_sink_t* sink, uint64_t index, const scan_result_t* result) {
+    if (!sink || !result || index >= sink->count) {
+        return -1;
+    }
+
+    if (sink->fd < 0) {
+        sink->chunks[index / RESULT_SINK_CHUNK][index % RESULT_SINK_CHUNK] = *result;
+        return 0;
+    }
+    if (index >= sink->spilled) {
+        sink->tail[index - sink->spilled] = *result;
+        return 0;
+    }
+
+    spill_record_t record;
+    encode(result, &record);
+    if (write_at(sink->fd, &record, sizeof(record), record_position(index)) < 0) {
+        fprintf(stderr, "Error: Cannot write result spill file '%s': %s\n", sink->path, strerror(errno));
+        return -1;
+    }
+    if (cached(sink, index)) {
+        sink->cache[index - sink->cache_first] = *result;
+    }
+    return 0;
+}
+
+uint64_t result_sink_count(const result_sink_t* sink) {
+    return sink ? sink->count : 0;
+}
@@ -0,0 +1,412 @@
+#include "scan_pipeline.h"
+#include "disk_aio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define PAGE_TOUCH_STRIDE 4096
+
+// 缓冲区槽位状态
+typedef enum {
+    SLOT_FREE = 0,            // 空闲
+    SLOT_INFLIGHT,            // 读取中
+    SLOT_READY,               // 数据就绪，等待消费
+    SLOT_CONSUMING            // 消费者使用中
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    uint64_t sequence;        // 数据块顺序号
+    uint64_t offset;          // 数据块偏移
+    size_t size;              // 数据块大小（不含重叠部分）
+    const uint8_t* data;      // 数据位置
+    ssize_t result;           // 读取结果（含重叠部分）
+} pipeline_slot_t;
+
+struct scan_pipeline {
+    disk_handle_t* handle;
+    disk_aio_t* aio;          // 非映射模式的异步读取引擎（仅读取线程使用）
+    disk_extent_t* extents;   // 待读取的数据区间（已跳过空洞）
+    size_t extent_count;
+    size_t extent_index;      // 当前区间
+    uint32_t block_size;
+    size_t overlap;           // 每个数据块多读取的下一数据块开头字节数
+    uint32_t io_depth;        // 在途请求上限
+    uint32_t buffer_count;    // 缓冲区数量 N
+    pipeline_slot_t* slots;
+
+    pthread_t reader;         // 读取线程
+    int reader_started;
+    pthread_mutex_t lock;
+    pthread_cond_t cond_ready;  // 有数据块就绪
+    pthread_cond_t cond_free;   // 有缓冲区被归还
+
+    uint64_t next_offset;     // 下一个要读取的偏移
+    uint64_t next_sequence;   // 下一个要读取的顺序号
+    uint64_t consume_sequence;  // 下一个要交给消费者的顺序号
+    uint32_t free_count;      // 空闲槽位数量
+    uint32_t inflight;        // 在途请求数
+    int reader_done;          // 读取线程已结束
+    int failed;               // 读取线程出错
+    int stop;                 // 请求停止
+
+    scan_pipeline_stats_t stats;
+};
+
+static int find_slot(scan_pipeline_t* p, slot_state_t state) {
+    for (uint32_t i = 0; i < p->buffer_count; i++) {
+        if (p->slots[i].state == state) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int has_more(const scan_pipeline_t* p) {
+    return p->extent_index < p->extent_count;
+}
+
+// 取出下一个数据块的范围（数据块和重叠部分都不跨越区间边界），read_size 为包含重叠部分的读取长度
+static void take_block(scan_pipeline_t* p, uint64_t* offset, size_t* size, size_t* read_size) {
+    const disk_extent_t* extent = &p->extents[p->extent_index];
+    uint64_t extent_end = extent->offset + extent->length;
+
+    *offset = p->next_offset;
+    *size = (p->next_offset + p->block_size <= extent_end) ? 
+            p->block_size : (size_t)(extent_end - p->next_offset);
+    uint64_t rest = extent_end - (p->next_offset + *size);
+    *read_size = *size + (rest < p->overlap ? (size_t)rest : p->overlap);
+
+    p->next_offset += *size;
+    if (p->next_offset >= extent_end && ++p->extent_index < p->extent_count) {
+        p->next_offset = p->extents[p->extent_index].offset;
+    }
+}
+
+// 映射模式：预取并预先触发缺页，使扫描线程访问时页面已在内存中
+static void reader_mapped(scan_pipeline_t* p) {
+    pthread_mutex_lock(&p->lock);
+    while (!p->stop && has_more(p)) {
+        if (p->free_count == 0) {
+            // 背压：等待消费者归还缓冲区
+            p->stats.producer_waits++;
+            pthread_cond_wait(&p->cond_free, &p->lock);
+            continue;
+        }
+
+        int slot = find_slot(p, SLOT_FREE);
+        uint64_t offset;
+        size_t size;
+        size_t read_size;
+        take_block(p, &offset, &size, &read_size);
+        pipeline_slot_t* s = &p->slots[slot];
+        s->state = SLOT_INFLIGHT;
+        s->sequence = p->next_sequence++;
+        s->offset = offset;
+        s->size = size;
+        p->free_count--;
+        pthread_mutex_unlock(&p->lock);
+
+        size_t mapped = 0;
+        const uint8_t* data = disk_map_range(p->handle, offset, read_size, &mapped);
+        if (data) {
+            disk_advise(p->handle, offset, mapped, DISK_ADVICE_WILLNEED);
+            volatile uint8_t sink = 0;
+            for (size_t i = 0; i < mapped; i += PAGE_TOUCH_STRIDE) {
+                sink ^= data[i];
+            }
+            (void)sink;
+        }
+
+        pthread_mutex_lock(&p->lock);
+        s->data = data;
+        s->result = data ? (ssize_t)mapped : -1;
+        s->state = SLOT_READY;
+        pthread_cond_broadcast(&p->cond_ready);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+// 非映射模式：通过 disk_aio 保持最多 io_depth 个读取请求在途
+static void reader_async(scan_pipeline_t* p) {
+    pthread_mutex_lock(&p->lock);
+    while (!p->stop) {
+        // 在空闲缓冲区允许的范围内尽量提交
+        while (!p->stop && p->free_count > 0 && p->inflight < p->io_depth &&
+               has_more(p)) {
+            int slot = find_slot(p, SLOT_FREE);
+            uint64_t offset;
+            size_t size;
+            size_t read_size;
+            take_block(p, &offset, &size, &read_size);
+            pipeline_slot_t* s = &p->slots[slot];
+            s->state = SLOT_INFLIGHT;
+            s->sequence = p->next_sequence++;
+            s->offset = offset;
+            s->size = size;
+            p->free_count--;
+            p->inflight++;
+
+            // 提交可能因限速而等待，期间不持有锁，扫描线程可以继续消费已就绪的数据块
+            pthread_mutex_unlock(&p->lock);
+            int ret = disk_aio_submit(p->aio, (uint32_t)slot, offset, read_size, NULL);
+            pthread_mutex_lock(&p->lock);
+            if (ret < 0) {
+                p->failed = 1;
+                break;
+            }
+        }
+
+        if (p->failed || p->stop) {
+            break;
+        }
+
+        if (p->inflight == 0) {
+            if (!has_more(p)) {
+                break;
+            }
+            // 背压：等待消费者归还缓冲区
+            p->stats.producer_waits++;
+            pthread_cond_wait(&p->cond_free, &p->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&p->lock);
+        disk_aio_event_t event;
+        int ret = disk_aio_wait(p->aio, &event);
+        if (ret == 0 && event.result > 0) {
+            // 数据块放入块缓存，文件大小估算时可直接命中
+            disk_populate_cache(p->handle, event.offset, event.data, (size_t)event.result);
+        }
+        pthread_mutex_lock(&p->lock);
+
+        if (ret < 0) {
+            p->failed = 1;
+            break;
+        }
+
+        pipeline_slot_t* s = &p->slots[event.slot];
+        s->data = event.data;
+        s->result = event.result;
+        s->state = SLOT_READY;
+        p->inflight--;
+        pthread_cond_broadcast(&p->cond_ready);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void* reader_main(void* arg) {
+    scan_pipeline_t* p = (scan_pipeline_t*)arg;
+
+    if (p->aio) {
+        reader_async(p);
+    } else {
+        reader_mapped(p);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->reader_done = 1;
+    pthread_cond_broadcast(&p->cond_ready);
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+scan_pipeline_t* scan_pipeline_create(disk_handle_t* handle, const disk_extent_t* extents,
+                                      size_t extent_count, uint32_t block_size, size_t overlap,
+                                      uint32_t io_depth, size_t memory_budget) {
+    if (!handle || (!extents && extent_count > 0) || block_size == 0) {
+        return NULL;
+    }
+
+    if (memory_budget == 0) {
+        memory_budget = SCAN_PIPELINE_DEFAULT_BUDGET;
+    }
+    if (io_depth == 0) {
+        io_depth = DISK_AIO_DEFAULT_DEPTH;
+    }
+
+    // 缓冲区数量由内存预算决定，至少双缓冲
+    size_t buffers = memory_budget / block_size;
+    if (buffers < SCAN_PIPELINE_MIN_BUFFERS) {
+        buffers = SCAN_PIPELINE_MIN_BUFFERS;
+    }
+    if (buffers > DISK_AIO_MAX_DEPTH) {
+        buffers = DISK_AIO_MAX_DEPTH;
+    }
+    if (io_depth > buffers) {
+        io_depth = (uint32_t)buffers;
+    }
+
+    scan_pipeline_t* p = (scan_pipeline_t*)calloc(1, sizeof(scan_pipeline_t));
+    if (!p) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    p->handle = handle;
+    p->block_size = block_size;
+    p->overlap = overlap;
+    p->io_depth = io_depth;
+    p->buffer_count = (uint32_t)buffers;
+    p->free_count = p->buffer_count;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond_ready, NULL);
+    pthread_cond_init(&p->cond_free, NULL);
+
+    p->slots = (pipeline_slot_t*)calloc(p->buffer_count, sizeof(pipeline_slot_t));
+    p->extents = (disk_extent_t*)malloc((extent_count ? extent_count : 1) * sizeof(disk_extent_t));
+    if (!p->slots || !p->extents) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        scan_pipeline_destroy(p);
+        return NULL;
+    }
+
+    // 复制非空区间
+    for (size_t i = 0; i < extent_count; i++) {
+        if (extents[i].length > 0) {
+            p->extents[p->extent_count++] = extents[i];
+        }
+    }
+    if (p->extent_count > 0) {
+        p->next_offset = p->extents[0].offset;
+    }
+
+    // 映射模式无需缓冲区，槽位只用于限制预读窗口
+    if (!disk_is_mapped(handle)) {
+        p->aio = disk_aio_create(handle, p->buffer_count, block_size + overlap);
+        if (!p->aio) {
+            scan_pipeline_destroy(p);
+            return NULL;
+        }
+    }
+
+    if (pthread_create(&p->reader, NULL, reader_main, p) != 0) {
+        fprintf(stderr, "Error: Cannot start reader thread\n");
+        scan_pipeline_destroy(p);
+        return NULL;
+    }
+    p->reader_started = 1;
+
+    return p;
+}
+
+int scan_pipeline_next(scan_pipeline_t* p, scan_pipeline_block_t* block) {
+    if (!p || !block) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        // 查找下一个顺序号对应的就绪数据块
+        int slot = -1;
+        for (uint32_t i = 0; i < p->buffer_count; i++) {
+            if (p->slots[i].state == SLOT_READY &&
+                p->slots[i].sequence == p->consume_sequence) {
+                slot = (int)i;
+                break;
+            }
+        }
+
+        if (slot >= 0) {
+            pipeline_slot_t* s = &p->slots[slot];
+            if (s->result <= 0) {
+                pthread_mutex_unlock(&p->lock);
+                return -1;
+            }
+
+            s->state = SLOT_CONSUMING;
+            p->consume_sequence++;
+
+            block->offset = s->offset;
+            block->data = s->data;
+            block->size = (size_t)s->result < s->size ? (size_t)s->result : s->size;
+            block->overlap = (size_t)s->result - block->size;
+            p->stats.blocks++;
+            p->stats.bytes += block->size;
+            block->sequence = s->sequence;
+            block->slot = (uint32_t)slot;
+            pthread_mutex_unlock(&p->lock);
+            return 1;
+        }
+
+        if (p->reader_done) {
+            int ret = (p->failed || p->consume_sequence < p->next_sequence) ? -1 : 0;
+            pthread_mutex_unlock(&p->lock);
+            return ret;
+        }
+
+        p->stats.consumer_waits++;
+        pthread_cond_wait(&p->cond_ready, &p->lock);
+    }
+}
+
+void scan_pipeline_release(scan_pipeline_t* p, const scan_pipeline_block_t* block) {
+    if (!p || !block || block->slot >= p->buffer_count) {
+        return;
+    }
+
+    // 映射模式：已扫描的区域不再需要，释放映射页
+    if (!p->aio) {
+        disk_advise(p->handle, block->offset, block->size, DISK_ADVICE_DONTNEED);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    pipeline_slot_t* s = &p->slots[block->slot];
+    if (s->state == SLOT_CONSUMING) {
+        s->state = SLOT_FREE;
+        s->data = NULL;
+        p->free_count++;
+        pthread_cond_signal(&p->cond_free);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+void scan_pipeline_destroy(scan_pipeline_t* p) {
+    if (!p) {
+        return;
+    }
+
+    if (p->reader_started) {
+        pthread_mutex_lock(&p->lock);
+        p->stop = 1;
+        pthread_cond_broadcast(&p->cond_free);
+        pthread_mutex_unlock(&p->lock);
+        pthread_join(p->reader, NULL);
+    }
+
+    // disk_aio_destroy() 会等待仍在途的请求
+    disk_aio_destroy(p->aio);
+    pthread_cond_destroy(&p->cond_free);
+    pthread_cond_destroy(&p->cond_ready);
+    pthread_mutex_destroy(&p->lock);
+    free(p->extents);
+    free(p->slots);
+    free(p);
+}
+
+void scan_pipeline_get_stats(scan_pipeline_t* p, scan_pipeline_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(scan_pipeline_stats_t));
+    if (!p) {
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    *stats = p->stats;
+    pthread_mutex_unlock(&p->lock);
+}
+
+const char* scan_pipeline_backend(const scan_pipeline_t* p) {
+    if (!p) {
+        return "none";
+    }
+    return p->aio ? disk_aio_backend_name(p->aio) : "mmap";
+}
+
+uint32_t scan_pipeline_buffers(const scan_pipeline_t* p) {
+    return p ? p->buffer_count : 0;
+}
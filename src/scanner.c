@@ -1,13 +1,24 @@
+#define _GNU_SOURCE
 #include "scanner.h"
 #include "signature.h"
+#include "signature_matcher.h"
+#include "text_detector.h"
+#include "region_classifier.h"
 #include "file_system.h"
 #include "utils.h"
+#include "disk_aio.h"
+#include "scan_pipeline.h"
+#include "work_queue.h"
+#include "footer_tracker.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #define DEFAULT_BLOCK_SIZE (1024 * 1024)  // 1MB
 #define SCAN_BUFFER_SIZE (64 * 1024)      // 64KB
+#define JOBS_PER_THREAD 4                 // 每个工作线程平均可领先合并进度的数据块数
 
 static int initialized = 0;
 
@@ -23,101 +34,1269 @@ int scanner_init(void) {
     return 0;
 }
 
-// 估算文件大小（基于文件类型）
-static uint64_t estimate_file_size(disk_handle_t* handle, uint64_t offset, file_type_t type) {
-    // 对于某些文件类型，可以从文件头读取大小
-    uint8_t buffer[512];
-    if (disk_read(handle, offset, buffer, sizeof(buffer)) < 0) {
+// 候选文件的数据源
+typedef struct {
+    disk_handle_t* handle;
+    uint64_t offset;          // 文件起始偏移
+} candidate_source_t;
+
+// 读取范围截断到设备末尾：格式解析跟随文件中的偏移和长度字段，可能指向设备之外，
+// 此时返回实际读到的字节数（在设备之外为 0），由解析函数按数据不完整处理
+static int64_t read_candidate(void* source, uint64_t offset, void* buffer, size_t size) {
+    const candidate_source_t* src = (const candidate_source_t*)source;
+    uint64_t device_size = disk_get_size(src->handle);
+    uint64_t pos = src->offset + offset;
+    if (pos < src->offset || pos >= device_size) {
         return 0;
     }
+    if (size > device_size - pos) {
+        size = (size_t)(device_size - pos);
+    }
+    return disk_read(src->handle, pos, buffer, size);
+}
 
-    switch (type) {
-        case FILE_TYPE_JPEG: {
-            // JPEG 文件以 FF D9 结束
-            uint64_t max_search = 50 * 1024 * 1024; // 最多搜索 50MB
-            uint8_t search_buf[4096];
-            for (uint64_t pos = offset + 2; pos < offset + max_search; pos += sizeof(search_buf) - 1) {
-                ssize_t read_size = disk_read(handle, pos, search_buf, sizeof(search_buf));
-                if (read_size <= 0) break;
-                
-                for (int i = 0; i < read_size - 1; i++) {
-                    if (search_buf[i] == 0xFF && search_buf[i + 1] == 0xD9) {
-                        return (pos + i + 2) - offset;
-                    }
-                }
+// 扫描任务状态
+typedef enum {
+    JOB_FREE = 0,             // 空闲
+    JOB_SCANNING,             // 匹配或解析中
+    JOB_DONE                  // 解析完成，等待按顺序合并
+} job_state_t;
+
+// 同一位置的候选签名的分类状态
+typedef enum {
+    GROUP_PENDING = 0,        // 尚未分类
+    GROUP_CARVING,            // 某个线程正在读取文件头、分类和计算大小
+    GROUP_DONE,               // 已完成
+    GROUP_SKIPPED             // 位于已识别的文件或文本区间内，不再分类
+} group_state_t;
+
+// 候选文件的大小如何确定
+typedef enum {
+    SIZE_RESOLVED = 0,        // 由文件结构或签名的文件尾搜索确定
+    SIZE_FOOTER_SEEN,         // 由本数据块中已找出的文件尾标记确定
+    SIZE_FOOTER_SEARCHED,     // 单独读取之后的数据查找文件尾标记
+    SIZE_FOOTER_OPEN          // 文件尾在之后的数据块中（size 为默认大小），合并后继续等待
+} size_source_t;
+
+// 同一位置的候选签名：按签名顺序尝试，第一个有效的签名决定文件类型和大小
+typedef struct {
+    size_t position;          // 在数据块中的位置
+    size_t first;             // 第一个签名在任务签名列表中的下标
+    size_t count;
+    group_state_t state;
+    int found;                // 找到有效的文件头
+    file_type_t type;
+    uint64_t size;
+    size_source_t source;
+    footer_candidate_t footer;
+} scan_group_t;
+
+struct scan_context;
+
+// 一个数据块的扫描任务：文本区间在派发时按数据块顺序检测；匹配任务找出候选位置，
+// 每个位置的分类和大小计算作为单独的任务放入工作窃取队列，解析时按位置顺序取用结果；
+// 结果暂存在任务中，再按数据块顺序合并
+typedef struct {
+    struct scan_context* ctx;
+    job_state_t state;
+    uint64_t sequence;        // 数据块顺序号
+    scan_pipeline_block_t block;
+    text_run_t* runs;         // 在本数据块中结束的文本区间
+    size_t run_count;
+    size_t run_capacity;
+    uint64_t text_from;       // 延续到下一数据块、已满足阈值的文本区间起点（之后的签名匹配不报告）
+    uint64_t open_from;       // 延续到下一数据块的文本区间起点（含未满足阈值的，UINT64_MAX 表示没有）
+    text_run_t carried;       // 起点在之前数据块中的文本区间（长度为 0 表示没有）
+    scan_group_t* groups;     // 候选位置（按位置排列）
+    size_t group_count;
+    size_t group_capacity;
+    uint32_t* group_signatures; // 候选位置的签名下标
+    size_t signature_count;
+    size_t signature_capacity;
+    int match_failed;         // 匹配出错，不再报告文本区间
+    pthread_mutex_t lock;     // 保护候选位置的状态、skip_to、resolved 和 outstanding
+    pthread_cond_t carved;    // 有候选位置分类完成
+    size_t skip_to;           // 解析进度：之前的候选位置已不需要分类
+    int resolved;             // 解析已结束，剩余的分类任务直接跳过
+    uint32_t outstanding;     // 尚未结束的分类任务数（加上解析本身）
+    footer_hit_t* hits;       // 本数据块中的文件尾标记（按偏移排列）
+    size_t hit_count;
+    size_t hit_capacity;
+    int hits_valid;           // 文件尾标记已完整找出
+    scan_result_t* found;     // 本数据块中找到的文件（按偏移排列）
+    size_t found_count;
+    size_t found_capacity;
+    footer_candidate_t* pending; // 找到的文件中文件尾尚未出现的（按偏移排列）
+    size_t pending_count;
+    size_t pending_capacity;
+    uint64_t footers_streamed;
+    uint64_t footers_searched;
+    disk_extent_t* claims;    // 本数据块中已识别文件的跳过范围
+    size_t claim_count;
+    size_t claim_capacity;
+    uint64_t fill_bytes;
+    uint64_t random_bytes;
+} scan_job_t;
+
+// 已合并、文件尾尚未出现的结果
+typedef struct {
+    footer_candidate_t candidate;
+    uint64_t index;           // 在结果存储中的编号
+} open_result_t;
+
+// 扫描上下文
+typedef struct scan_context {
+    disk_handle_t* handle;
+    const scan_options_t* options;
+    result_sink_t* results;
+    uint64_t max_results;
+    uint64_t found_count;     // 本次扫描加入结果存储的结果数
+    int store_failed;         // 结果存储写入失败
+    uint64_t start;
+    uint64_t end;
+    uint32_t block_size;
+    uint64_t started_ns;      // 扫描开始时间
+    uint64_t bytes_scanned;   // 已扫描的字节数
+    text_detector_t* text;    // 流式文本检测器（跨数据块保持状态，只在派发任务时使用）
+    disk_extent_t* claims;    // 已合并结果的跳过范围（只保留可能包含未结束文本区间起点的）
+    size_t claim_count;
+    size_t claim_capacity;
+    const file_signature_t* signatures; // 参与匹配的签名（按类型选择后的子集）
+    size_t signature_count;
+    const signature_matcher_t* matcher; // 签名子集的匹配器（没有签名时为 NULL）
+    signature_matcher_t* own_matcher;   // 为子集单独编译的匹配器
+    file_signature_t* own_signatures;
+    uint8_t* selected;        // 按类型编号索引的选择标志（NULL 表示全部类型）
+    size_t selected_slots;
+    region_classifier_t* regions; // 区域分类器（NULL 表示不跳过无效区域）
+    uint32_t alignment;       // 只检查与 alignment_base 相差 alignment 整数倍的起始位置（0 表示每个字节）
+    uint64_t alignment_base;
+    footer_tracker_t* footers;    // 文件尾跟踪器（NULL 表示每个候选文件单独搜索文件尾）
+    int stream_footers;       // 本遍扫描的数据块连续，可以由顺序读到的标记确定文件尾
+    open_result_t* open;      // 已合并、文件尾尚未出现的结果（按偏移排列）
+    size_t open_count;
+    size_t open_capacity;
+    uint64_t covered_end;     // 已合并的数据块的结束偏移（之前的文件尾标记都已处理）
+    uint64_t footers_streamed;  // 由顺序读到的标记确定文件尾的结果数
+    uint64_t footers_searched;  // 单独读取查找文件尾的结果数
+    uint64_t fill_bytes;      // 跳过的重复模式区域字节数
+    uint64_t random_bytes;    // 只检查扇区对齐位置的高熵区域字节数
+    uint32_t threads;         // 工作线程数
+    work_queue_t* queue;      // 分类任务的工作窃取队列
+    uint64_t carve_tasks;     // 提交的分类任务数
+    uint64_t carve_skipped;   // 执行前已被跳过的分类任务数
+    scan_pipeline_t* pipeline;  // 当前一遍扫描的预读流水线
+    scan_job_t* jobs;         // 任务环（按顺序号取模）
+    uint32_t job_slots;
+    uint64_t dispatch_sequence; // 下一个派发的顺序号
+    uint64_t merge_sequence;  // 下一个合并的顺序号
+    int dispatch_done;        // 流水线已读完或出错
+    int read_failed;
+    int stop;                 // 结果数量已达上限（工作线程原子读取）
+    pthread_mutex_t dispatch_lock;  // 保护派发顺序和文本检测器
+    pthread_mutex_t merge_lock;     // 保护任务环和已合并的结果
+} scan_context_t;
+
+static int scan_stopped(const scan_context_t* ctx) {
+    return __atomic_load_n(&ctx->stop, __ATOMIC_RELAXED);
+}
+
+// 类型是否在扫描范围内
+static int type_selected(const scan_context_t* ctx, file_type_t type) {
+    return !ctx->selected || ((size_t)type < ctx->selected_slots && ctx->selected[type]);
+}
+
+// 确定文件类型和大小（由签名的处理函数决定）；文件头无效或分类后的类型未被选择时返回 -1，
+// 此时不计算文件大小。按文件尾标记确定大小的类型在本数据块中查找已找出的标记，
+// 标记不在本数据块中时大小暂用默认值，由之后的数据块确定
+static int carve_file(scan_context_t* ctx, const scan_job_t* job, uint64_t offset,
+                      const file_signature_t* signature, scan_group_t* group) {
+    group->source = SIZE_RESOLVED;
+    uint8_t header[SIGNATURE_HEADER_LEN];
+    ssize_t header_len = disk_read(ctx->handle, offset, header, sizeof(header));
+    if (header_len < 0) {
+        // 文件头无法读取，仍然报告候选位置
+        group->type = signature->type;
+        group->size = 0;
+        return 0;
+    }
+
+    candidate_source_t source = { ctx->handle, offset };
+    signature_candidate_t candidate = {
+        .header = header,
+        .header_len = (size_t)header_len,
+        .read = read_candidate,
+        .source = &source
+    };
+    if (signature_classify(signature, &candidate, &group->type) < 0 ||
+        !type_selected(ctx, group->type)) {
+        return -1;
+    }
+    if (signature_structure_size(signature, &candidate, &group->size) == 0) {
+        return 0;
+    }
+    if (!ctx->stream_footers || !job->hits_valid ||
+        !footer_tracker_open(ctx->footers, signature, group->type, offset, &group->footer)) {
+        return signature_footer_size(signature, &candidate, group->type, &group->size);
+    }
+
+    if (footer_tracker_match(&group->footer, job->hits, job->hit_count, &group->size) == 0) {
+        group->source = SIZE_FOOTER_SEEN;
+        return 0;
+    }
+    // 默认大小在本数据块内结束时，跳过范围取决于之后有没有文件尾标记，直接读取查找
+    uint64_t block_end = job->block.offset + job->block.size;
+    if (offset + 1 + group->footer.default_size < block_end) {
+        footer_tracker_search(&group->footer, &candidate, block_end, &group->size);
+        group->source = SIZE_FOOTER_SEARCHED;
+        return 0;
+    }
+    // 文件在本数据块之后结束（无论有没有标记），跳过范围与最终大小无关
+    group->size = group->footer.default_size;
+    group->source = SIZE_FOOTER_OPEN;
+    return 0;
+}
+
+// 按扫描选项选择类型，为选中的签名子集单独编译匹配器（选择了全部签名时沿用数据库的匹配器）
+static int select_types(scan_context_t* ctx) {
+    const scan_options_t* options = ctx->options;
+    size_t count;
+    const file_signature_t* all = signature_get_all(&count);
+
+    ctx->signatures = all;
+    ctx->signature_count = count;
+    ctx->matcher = signature_get_matcher();
+    if (!options->include_types && options->exclude_count == 0) {
+        return 0;
+    }
+
+    size_t slots = FILE_TYPE_MAX;
+    for (size_t i = 0; i < count; i++) {
+        if ((size_t)all[i].type >= slots) {
+            slots = (size_t)all[i].type + 1;
+        }
+    }
+    ctx->selected = (uint8_t*)calloc(slots, 1);
+    ctx->own_signatures = (file_signature_t*)malloc((count ? count : 1) * sizeof(file_signature_t));
+    if (!ctx->selected || !ctx->own_signatures) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    ctx->selected_slots = slots;
+
+    if (options->include_types) {
+        for (size_t i = 0; i < options->include_count; i++) {
+            if ((size_t)options->include_types[i] < slots) {
+                ctx->selected[options->include_types[i]] = 1;
             }
-            return 1024 * 1024; // 默认 1MB
-        }
-        
-        case FILE_TYPE_PNG: {
-            // PNG 文件大小在 IHDR 块之后
-            if (buffer[0] == 0x89 && buffer[1] == 0x50) {
-                // 读取到文件末尾标记 IEND
-                uint64_t max_search = 20 * 1024 * 1024;
-                uint8_t search_buf[4096];
-                for (uint64_t pos = offset + 8; pos < offset + max_search; pos += sizeof(search_buf) - 4) {
-                    ssize_t read_size = disk_read(handle, pos, search_buf, sizeof(search_buf));
-                    if (read_size <= 0) break;
-                    
-                    for (int i = 0; i < read_size - 4; i++) {
-                        if (memcmp(&search_buf[i], "IEND", 4) == 0) {
-                            return (pos + i + 8) - offset;
-                        }
-                    }
-                }
+        }
+    } else {
+        memset(ctx->selected, 1, slots);
+    }
+    for (size_t i = 0; i < options->exclude_count; i++) {
+        if ((size_t)options->exclude_types[i] < slots) {
+            ctx->selected[options->exclude_types[i]] = 0;
+        }
+    }
+
+    // 魔数相同的类型各有一个签名，分类后的类型不在范围内时丢弃，因此只需保留本身类型被选择的签名
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (ctx->selected[all[i].type]) {
+            ctx->own_signatures[kept++] = all[i];
+        }
+    }
+    if (kept == count) {
+        return 0;
+    }
+
+    ctx->signatures = ctx->own_signatures;
+    ctx->signature_count = kept;
+    ctx->matcher = NULL;
+    if (kept > 0) {
+        ctx->own_matcher = signature_matcher_create(ctx->own_signatures, kept);
+        if (!ctx->own_matcher) {
+            return -1;
+        }
+        ctx->matcher = ctx->own_matcher;
+    }
+    return 0;
+}
+
+// 生成带有效速率的进度消息（限速时同时显示当前上限）
+static void format_progress(scan_context_t* ctx, char* message, size_t size) {
+    uint64_t elapsed = utils_monotonic_ns() - ctx->started_ns;
+    uint64_t rate = elapsed ? (uint64_t)((double)ctx->bytes_scanned * 1e9 / (double)elapsed) : 0;
+
+    char rate_buf[32];
+    char text[112];
+    utils_format_size(rate, rate_buf, sizeof(rate_buf));
+
+    disk_throttle_stats_t throttle;
+    if (disk_get_throttle_stats(ctx->handle, &throttle) == 0 && throttle.bytes_per_sec) {
+        char limit_buf[32];
+        utils_format_size((uint64_t)((double)throttle.bytes_per_sec * throttle.scale),
+                          limit_buf, sizeof(limit_buf));
+        snprintf(text, sizeof(text), "Scanning... %s/s (limit %s/s)", rate_buf, limit_buf);
+    } else {
+        snprintf(text, sizeof(text), "Scanning... %s/s", rate_buf);
+    }
+
+    // 补齐宽度，覆盖上一次输出的较长内容
+    snprintf(message, size, "%-44s", text);
+}
+
+// 单个数据块的扫描状态
+typedef struct {
+    scan_context_t* ctx;
+    scan_job_t* job;
+    const uint8_t* buffer;
+    size_t size;              // 数据块大小（起始位置不小于它的匹配属于下一数据块）
+    size_t available;         // 可匹配的字节数（含下一数据块开头的重叠部分）
+    size_t next;              // 下一个待检查的位置（之前的位置已被跳过）
+    size_t run_index;         // 下一个待处理的文本区间
+    uint64_t offset;          // 数据块在磁盘上的偏移
+    size_t base;              // 当前匹配窗口在数据块中的起点
+    size_t accept_from;       // 只报告起始位置在 [accept_from, accept_to) 内的匹配
+    size_t accept_to;
+    int aligned_only;         // 只报告扇区对齐的起始位置（高熵区域）
+} block_scan_t;
+
+// 数组已满时容量加倍，失败返回 -1
+static int reserve(void** items, size_t* capacity, size_t count, size_t item_size) {
+    if (count < *capacity) {
+        return 0;
+    }
+    size_t grown = *capacity ? *capacity * 2 : 64;
+    void* resized = realloc(*items, grown * item_size);
+    if (!resized) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    *items = resized;
+    *capacity = grown;
+    return 0;
+}
+
+// 把一个扫描结果追加到结果存储（文本区间内的签名匹配不报告，跨数据块的文本区间结束时
+// 才报告也不会落后于已有结果）；文件尾尚未出现的结果先占位，确定大小后再调用回调。
+// 返回结果编号，写入失败时停止扫描并返回 -1
+static int64_t add_result(scan_context_t* ctx, const scan_result_t* found, int notify) {
+    // 找到一个潜在的文件
+    int64_t index = result_sink_append(ctx->results, found);
+    if (index < 0) {
+        ctx->store_failed = 1;
+        __atomic_store_n(&ctx->stop, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    ctx->found_count++;
+
+    // 如果设置了回调，调用它
+    if (notify && ctx->options->callback) {
+        ctx->options->callback(found, ctx->options->user_data);
+    }
+    return index;
+}
+
+// 在任务中记录一个找到的文件，合并时再加入结果数组
+static void job_add_result(scan_job_t* job, uint64_t offset, uint64_t size, file_type_t type) {
+    if (reserve((void**)&job->found, &job->found_capacity, job->found_count, sizeof(scan_result_t)) < 0) {
+        return;
+    }
+    scan_result_t* result = &job->found[job->found_count++];
+    result->offset = offset;
+    result->size = size;
+    result->type = type;
+    result->confidence = 80; // 基本置信度
+}
+
+// 记录跳过范围，供起点在之前数据块中的文本区间判断是否位于已识别的文件内
+static void add_claim(disk_extent_t** claims, size_t* count, size_t* capacity,
+                      uint64_t offset, uint64_t end) {
+    if (reserve((void**)claims, capacity, *count, sizeof(disk_extent_t)) < 0) {
+        return;
+    }
+    (*claims)[*count].offset = offset;
+    (*claims)[*count].length = end - offset;
+    (*count)++;
+}
+
+// 检查偏移是否位于之前识别出的文件的跳过范围内
+static int is_claimed(const scan_context_t* ctx, uint64_t offset) {
+    for (size_t i = 0; i < ctx->claim_count; i++) {
+        const disk_extent_t* claim = &ctx->claims[i];
+        if (offset >= claim->offset && offset - claim->offset < claim->length) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 合并一个数据块后丢弃不再需要的跳过范围（open_from 为尚未结束的文本区间起点）
+static void trim_claims(scan_context_t* ctx, uint64_t open_from) {
+    if (open_from == UINT64_MAX) {
+        ctx->claim_count = 0;
+        return;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < ctx->claim_count; i++) {
+        if (ctx->claims[i].offset + ctx->claims[i].length > open_from) {
+            ctx->claims[kept++] = ctx->claims[i];
+        }
+    }
+    ctx->claim_count = kept;
+}
+
+// 本数据块不必再继续查找（结果已达上限）
+static int job_full(const block_scan_t* scan) {
+    return scan->job->found_count >= scan->ctx->max_results || scan_stopped(scan->ctx);
+}
+
+// 读取文件头、分类并计算大小：同一位置的签名按顺序尝试，第一个有效的签名决定结果
+static void carve_group(scan_context_t* ctx, scan_job_t* job, scan_group_t* group) {
+    group->found = 0;
+    for (size_t i = 0; i < group->count && !scan_stopped(ctx); i++) {
+        const file_signature_t* signature = &ctx->signatures[job->group_signatures[group->first + i]];
+        if (carve_file(ctx, job, job->block.offset + group->position, signature, group) == 0) {
+            group->found = 1;
+            return;
+        }
+    }
+}
+
+// 结束任务中的一个分类任务或解析；全部结束后按顺序合并（任务槽位此后才能复用）
+static void complete_job(scan_context_t* ctx, scan_job_t* job);
+
+static void release_task(scan_context_t* ctx, scan_job_t* job) {
+    pthread_mutex_lock(&job->lock);
+    int last = --job->outstanding == 0;
+    pthread_mutex_unlock(&job->lock);
+    if (last) {
+        complete_job(ctx, job);
+    }
+}
+
+// 分类任务（可被其他线程窃取）：提前计算解析线程稍后需要的结果；
+// 位置已被解析跳过或解析已结束时直接返回
+static void carve_task(void* arg, size_t index) {
+    scan_job_t* job = (scan_job_t*)arg;
+    scan_context_t* ctx = job->ctx;
+    scan_group_t* group = &job->groups[index];
+
+    pthread_mutex_lock(&job->lock);
+    int claimed = 0;
+    if (group->state == GROUP_PENDING) {
+        if (job->resolved || group->position < job->skip_to) {
+            group->state = GROUP_SKIPPED;
+        } else {
+            group->state = GROUP_CARVING;
+            claimed = 1;
+        }
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    if (claimed) {
+        carve_group(ctx, job, group);
+        pthread_mutex_lock(&job->lock);
+        group->state = GROUP_DONE;
+        pthread_cond_broadcast(&job->carved);
+        pthread_mutex_unlock(&job->lock);
+    } else {
+        __atomic_fetch_add(&ctx->carve_skipped, 1, __ATOMIC_RELAXED);
+    }
+    release_task(ctx, job);
+}
+
+// 解析线程取得候选位置的结果：尚未开始时自己计算，其他线程计算中时等待
+static const scan_group_t* take_group(scan_context_t* ctx, scan_job_t* job, size_t index) {
+    scan_group_t* group = &job->groups[index];
+    pthread_mutex_lock(&job->lock);
+    while (group->state == GROUP_CARVING) {
+        pthread_cond_wait(&job->carved, &job->lock);
+    }
+    if (group->state == GROUP_DONE) {
+        pthread_mutex_unlock(&job->lock);
+        return group;
+    }
+    group->state = GROUP_CARVING;
+    pthread_mutex_unlock(&job->lock);
+
+    carve_group(ctx, job, group);
+
+    pthread_mutex_lock(&job->lock);
+    group->state = GROUP_DONE;
+    pthread_mutex_unlock(&job->lock);
+    return group;
+}
+
+// 公布解析进度，之前的候选位置不再需要分类
+static void publish_skip(block_scan_t* scan) {
+    scan_job_t* job = scan->job;
+    pthread_mutex_lock(&job->lock);
+    if (scan->next > job->skip_to) {
+        job->skip_to = scan->next;
+    }
+    pthread_mutex_unlock(&job->lock);
+}
+
+// 记录一个有效的文件头，并跳过已识别的文件内容
+static void record_match(block_scan_t* scan, size_t position, file_type_t type, uint64_t size) {
+    scan_job_t* job = scan->job;
+    uint64_t offset = scan->offset + position;
+    job_add_result(job, offset, size, type);
+
+    // 跳过已识别的文件内容（到数据块末尾为止）
+    scan->next = position + 1 + ((size < scan->ctx->block_size) ? size : scan->ctx->block_size);
+    add_claim(&job->claims, &job->claim_count, &job->claim_capacity, offset,
+              scan->offset + (scan->next < scan->size ? scan->next : scan->size));
+    publish_skip(scan);
+}
+
+// 记录起始位置在 end 之前的文本区间（文本区间长度已知，不再估算）
+static void record_runs(block_scan_t* scan, uint64_t end) {
+    scan_job_t* job = scan->job;
+    size_t next = scan->next;
+    while (scan->run_index < job->run_count && !job_full(scan)) {
+        const text_run_t* run = &job->runs[scan->run_index];
+        if (run->offset >= end) {
+            break;
+        }
+        scan->run_index++;
+
+        if (run->offset < scan->offset) {
+            // 起点在之前的数据块中：是否位于已识别的文件内要等之前的数据块合并后才能确定，
+            // 留到合并时判断；区间内的签名匹配照常不报告
+            job->carried = *run;
+        } else if (run->offset - scan->offset < scan->next) {
+            continue;
+        } else {
+            job_add_result(job, run->offset, run->length, FILE_TYPE_TXT);
+            add_claim(&job->claims, &job->claim_count, &job->claim_capacity,
+                      run->offset, run->offset + run->length);
+        }
+
+        // 文本区间内的签名匹配（如正文中的 "BM"、"MZ"）不再报告
+        uint64_t run_end = run->offset + run->length;
+        if (run_end > scan->offset && run_end - scan->offset > scan->next) {
+            scan->next = (size_t)(run_end - scan->offset);
+        }
+    }
+    if (scan->next != next) {
+        publish_skip(scan);
+    }
+}
+
+// 收集文本检测器报告的区间，在签名匹配时按偏移顺序合并
+static int collect_run(const text_run_t* run, void* user_data) {
+    scan_job_t* job = (scan_job_t*)user_data;
+    if (reserve((void**)&job->runs, &job->run_capacity, job->run_count, sizeof(text_run_t)) < 0) {
+        return 1;
+    }
+    job->runs[job->run_count++] = *run;
+    return 0;
+}
+
+// 收集签名匹配：同一位置的匹配合并为一组候选（匹配按位置、同一位置按签名顺序报告）
+static int collect_match(const signature_match_t* match, void* user_data) {
+    block_scan_t* scan = (block_scan_t*)user_data;
+    scan_job_t* job = scan->job;
+    size_t position = scan->base + match->position;
+    // 起始位置在重叠部分的匹配由下一数据块报告
+    if (position >= scan->size || position >= scan->accept_to || scan_stopped(scan->ctx)) {
+        return 1;
+    }
+    // 高熵区域中未对齐的位置，或位于尚未结束的文本区间内
+    if (position < scan->accept_from ||
+        (scan->aligned_only && (scan->offset + position) % REGION_CLASSIFIER_SECTOR != 0) ||
+        scan->offset + position > job->text_from) {
+        return 0;
+    }
+
+    if (reserve((void**)&job->group_signatures, &job->signature_capacity, job->signature_count,
+                sizeof(uint32_t)) < 0) {
+        job->match_failed = 1;
+        return 1;
+    }
+    if (job->group_count == 0 || job->groups[job->group_count - 1].position != position) {
+        if (reserve((void**)&job->groups, &job->group_capacity, job->group_count,
+                    sizeof(scan_group_t)) < 0) {
+            job->match_failed = 1;
+            return 1;
+        }
+        scan_group_t* group = &job->groups[job->group_count++];
+        memset(group, 0, sizeof(scan_group_t));
+        group->position = position;
+        group->first = job->signature_count;
+    }
+    job->groups[job->group_count - 1].count++;
+    job->group_signatures[job->signature_count++] = match->signature;
+    return 0;
+}
+
+// 匹配数据块中的 [from, to)，只报告起始位置在 [accept_from, accept_to) 内的匹配
+static int64_t match_window(block_scan_t* scan, size_t from, size_t to,
+                            size_t accept_from, size_t accept_to) {
+    scan->base = from;
+    scan->accept_from = accept_from;
+    scan->accept_to = accept_to;
+    return signature_matcher_scan(scan->ctx->matcher, scan->buffer + from, to - from,
+                                  collect_match, scan);
+}
+
+static size_t unit_length(const block_scan_t* scan, size_t pos) {
+    return scan->size - pos < REGION_CLASSIFIER_UNIT ? scan->size - pos : REGION_CLASSIFIER_UNIT;
+}
+
+static region_class_t classify_unit(const block_scan_t* scan, size_t pos) {
+    return region_classify(scan->ctx->regions, scan->buffer + pos, unit_length(scan, pos));
+}
+
+// 按区域类别匹配：重复模式单元跳过，类别相同的连续单元合并为一个窗口，
+// 高熵窗口只报告扇区对齐的文件起始位置；窗口向后延伸 span - 1 字节
+// （前一段是重复模式时也向前延伸），跨越单元边界的魔数不会遗漏
+static int scan_regions(block_scan_t* scan) {
+    scan_context_t* ctx = scan->ctx;
+    size_t span = signature_matcher_max_span(ctx->matcher);
+    size_t reach = span > 0 ? span - 1 : 0;
+    region_class_t prev = REGION_DATA;
+    region_class_t cls = classify_unit(scan, 0);
+    size_t pos = 0;
+
+    while (pos < scan->size && !scan_stopped(ctx)) {
+        size_t end = pos + unit_length(scan, pos);
+        region_class_t next = REGION_DATA;
+        while (end < scan->size && (next = classify_unit(scan, end)) == cls) {
+            end += unit_length(scan, end);
+        }
+
+        if (cls == REGION_FILL) {
+            scan->job->fill_bytes += end - pos;
+        } else {
+            size_t from = pos;
+            if (prev == REGION_FILL) {
+                from = pos > reach ? pos - reach : 0;
             }
-            return 512 * 1024; // 默认 512KB
-        }
-        
-        case FILE_TYPE_PDF: {
-            // 搜索 %%EOF 标记
-            uint64_t max_search = 100 * 1024 * 1024;
-            uint8_t search_buf[4096];
-            for (uint64_t pos = offset + 5; pos < offset + max_search; pos += sizeof(search_buf) - 5) {
-                ssize_t read_size = disk_read(handle, pos, search_buf, sizeof(search_buf));
-                if (read_size <= 0) break;
-                
-                for (int i = 0; i < read_size - 5; i++) {
-                    if (memcmp(&search_buf[i], "%%EOF", 5) == 0) {
-                        return (pos + i + 5) - offset;
-                    }
-                }
+            size_t to = end + reach < scan->available ? end + reach : scan->available;
+            scan->aligned_only = cls == REGION_RANDOM;
+            if (scan->aligned_only) {
+                scan->job->random_bytes += end - pos;
+            }
+            int64_t ret = match_window(scan, from, to, from, end);
+            scan->aligned_only = 0;
+            if (ret < 0) {
+                return -1;
+            }
+        }
+
+        prev = cls;
+        cls = next;
+        pos = end;
+    }
+    return 0;
+}
+
+// 对齐扫描：只在对齐的位置尝试匹配，每个位置只匹配最长魔数跨度内的数据；
+// 跳过无效区域时，魔数完整位于重复模式单元内的位置不匹配，高熵单元中只检查扇区对齐的位置
+static int scan_aligned(block_scan_t* scan) {
+    scan_context_t* ctx = scan->ctx;
+    size_t span = signature_matcher_max_span(ctx->matcher);
+    uint64_t alignment = ctx->alignment;
+    size_t pos = (size_t)((ctx->alignment_base % alignment + alignment - scan->offset % alignment) % alignment);
+    size_t unit = SIZE_MAX;
+    region_class_t cls = REGION_DATA;
+
+    for (; pos < scan->size && !scan_stopped(ctx); pos += alignment) {
+        if (ctx->regions && pos / REGION_CLASSIFIER_UNIT != unit) {
+            unit = pos / REGION_CLASSIFIER_UNIT;
+            size_t start = unit * REGION_CLASSIFIER_UNIT;
+            cls = classify_unit(scan, start);
+            if (cls == REGION_FILL) {
+                scan->job->fill_bytes += unit_length(scan, start);
+            } else if (cls == REGION_RANDOM) {
+                scan->job->random_bytes += unit_length(scan, start);
+            }
+        }
+        size_t unit_end = (pos / REGION_CLASSIFIER_UNIT + 1) * REGION_CLASSIFIER_UNIT;
+        if (cls == REGION_FILL && pos + span <= unit_end) {
+            continue;
+        }
+
+        size_t to = pos + span < scan->available ? pos + span : scan->available;
+        scan->aligned_only = cls == REGION_RANDOM;
+        int64_t ret = match_window(scan, pos, to, pos, pos + 1);
+        scan->aligned_only = 0;
+        if (ret < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 匹配任务：自动机单遍找出数据块中的所有候选位置（匹配范围包含下一数据块开头的重叠部分，
+// 跨越数据块边界的魔数不会遗漏），之后不再需要数据块本身
+static void match_job(scan_context_t* ctx, scan_job_t* job) {
+    block_scan_t scan = {
+        .ctx = ctx,
+        .job = job,
+        .buffer = job->block.data,
+        .size = job->block.size,
+        .available = job->block.size + job->block.overlap,
+        .offset = job->block.offset,
+        .accept_to = SIZE_MAX
+    };
+
+    int ret = 0;
+    if (ctx->matcher && ctx->alignment > 1) {
+        ret = scan_aligned(&scan);
+    } else if (ctx->matcher && ctx->regions) {
+        ret = scan_regions(&scan);
+    } else if (ctx->matcher) {
+        ret = signature_matcher_scan(ctx->matcher, scan.buffer, scan.available,
+                                     collect_match, &scan) < 0 ? -1 : 0;
+    }
+    if (ret < 0) {
+        job->match_failed = 1;
+    }
+
+    // 同一遍读取中找出文件尾标记，候选文件不必各自向后读取
+    if (ctx->stream_footers) {
+        candidate_source_t source = { ctx->handle, 0 };
+        job->hits_valid = footer_tracker_scan(ctx->footers, scan.buffer, scan.size, scan.available,
+                                              scan.offset, read_candidate, &source, &job->hits,
+                                              &job->hit_count, &job->hit_capacity) == 0;
+    }
+}
+
+// 解析：按位置顺序取用候选位置的分类结果，与派发时检测出的文本区间合并，
+// 跳过已识别的文件内容（顺序决定结果，与分类任务由哪个线程执行无关）
+static void resolve_job(scan_context_t* ctx, scan_job_t* job) {
+    block_scan_t scan = {
+        .ctx = ctx,
+        .job = job,
+        .size = job->block.size,
+        .offset = job->block.offset
+    };
+
+    for (size_t i = 0; i < job->group_count; i++) {
+        size_t position = job->groups[i].position;
+
+        // 同一位置签名优先于文本区间
+        record_runs(&scan, scan.offset + position);
+        if (job_full(&scan)) {
+            break;
+        }
+        // 位于已识别文件内部或文本区间内
+        if (position < scan.next) {
+            continue;
+        }
+
+        const scan_group_t* group = take_group(ctx, job, i);
+        if (group->found) {
+            record_match(&scan, position, group->type, group->size);
+            job->footers_streamed += group->source == SIZE_FOOTER_SEEN;
+            job->footers_searched += group->source == SIZE_FOOTER_SEARCHED;
+            if (group->source == SIZE_FOOTER_OPEN &&
+                reserve((void**)&job->pending, &job->pending_capacity, job->pending_count,
+                        sizeof(footer_candidate_t)) == 0) {
+                job->pending[job->pending_count++] = group->footer;
+            }
+        }
+    }
+    if (!job->match_failed) {
+        record_runs(&scan, UINT64_MAX);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    job->resolved = 1;
+    pthread_mutex_unlock(&job->lock);
+}
+
+// 报告起点在之前数据块中的文本区间（之前的结果都已合并，位于已识别的文件内时不报告）
+static void record_carried(scan_context_t* ctx, const text_run_t* run) {
+    if (ctx->found_count >= ctx->max_results || is_claimed(ctx, run->offset)) {
+        return;
+    }
+    scan_result_t result = { run->offset, run->length, FILE_TYPE_TXT, 80 };
+    add_result(ctx, &result, 1);
+    add_claim(&ctx->claims, &ctx->claim_count, &ctx->claim_capacity,
+              run->offset, run->offset + run->length);
+}
+
+static int finish_run(const text_run_t* run, void* user_data) {
+    record_carried((scan_context_t*)user_data, run);
+    return 0;
+}
+
+// 确定一个等待文件尾的结果的大小，并调用回调
+static void close_open(scan_context_t* ctx, const open_result_t* open, uint64_t size) {
+    scan_result_t result;
+    if (result_sink_get(ctx->results, open->index, &result) < 0) {
+        ctx->store_failed = 1;
+        return;
+    }
+    result.size = size;
+    if (result_sink_update(ctx->results, open->index, &result) < 0) {
+        ctx->store_failed = 1;
+        return;
+    }
+    if (ctx->options->callback) {
+        ctx->options->callback(&result, ctx->options->user_data);
+    }
+}
+
+// 用本数据块中的文件尾标记确定之前数据块中结果的大小；范围已全部读过而没有标记的使用默认大小
+static void advance_open(scan_context_t* ctx, const scan_job_t* job) {
+    uint64_t block_end = job->block.offset + job->block.size;
+    size_t kept = 0;
+    for (size_t i = 0; i < ctx->open_count; i++) {
+        const open_result_t* open = &ctx->open[i];
+        uint64_t size;
+        if (footer_tracker_match(&open->candidate, job->hits, job->hit_count, &size) == 0) {
+            close_open(ctx, open, size);
+            ctx->footers_streamed++;
+        } else if (open->candidate.to < block_end) {
+            close_open(ctx, open, open->candidate.default_size);
+            ctx->footers_streamed++;
+        } else {
+            ctx->open[kept++] = *open;
+        }
+    }
+    ctx->open_count = kept;
+}
+
+// 顺序读取无法继续确定文件尾（扫描结束、提前停止或标记查找失败），
+// 从已读过的位置起直接读取查找剩余的范围
+static void search_open(scan_context_t* ctx) {
+    for (size_t i = 0; i < ctx->open_count; i++) {
+        const open_result_t* open = &ctx->open[i];
+        candidate_source_t source = { ctx->handle, open->candidate.offset };
+        signature_candidate_t candidate = { NULL, 0, read_candidate, &source };
+        uint64_t size;
+        footer_tracker_search(&open->candidate, &candidate, ctx->covered_end, &size);
+        close_open(ctx, open, size);
+        ctx->footers_searched++;
+    }
+    ctx->open_count = 0;
+}
+
+// 合并一个数据块的结果（持有 merge_lock，按数据块顺序调用）
+static void merge_job(scan_context_t* ctx, scan_job_t* job) {
+    if (job->carried.length > 0) {
+        record_carried(ctx, &job->carried);
+    }
+    if (ctx->open_count > 0) {
+        if (job->hits_valid) {
+            advance_open(ctx, job);
+        } else {
+            ctx->covered_end = job->block.offset;
+            search_open(ctx);
+        }
+    }
+    ctx->covered_end = job->block.offset + job->block.size;
+
+    size_t pending = 0;
+    for (size_t i = 0; i < job->found_count && ctx->found_count < ctx->max_results && !ctx->store_failed; i++) {
+        int open = pending < job->pending_count && job->pending[pending].offset == job->found[i].offset;
+        int64_t index = add_result(ctx, &job->found[i], !open);
+        if (open) {
+            if (index >= 0 && reserve((void**)&ctx->open, &ctx->open_capacity, ctx->open_count,
+                                      sizeof(open_result_t)) == 0) {
+                ctx->open[ctx->open_count].candidate = job->pending[pending];
+                ctx->open[ctx->open_count].index = (uint64_t)index;
+                ctx->open_count++;
             }
-            return 2 * 1024 * 1024; // 默认 2MB
-        }
-        
-        case FILE_TYPE_ZIP:
-        case FILE_TYPE_DOCX:
-        case FILE_TYPE_XLSX:
-        case FILE_TYPE_PPTX: {
-            // ZIP 格式，查找 End of Central Directory
-            uint64_t max_search = 200 * 1024 * 1024;
-            uint8_t search_buf[4096];
-            for (uint64_t pos = offset + 4; pos < offset + max_search; pos += sizeof(search_buf) - 22) {
-                ssize_t read_size = disk_read(handle, pos, search_buf, sizeof(search_buf));
-                if (read_size <= 0) break;
-                
-                for (int i = 0; i < read_size - 22; i++) {
-                    if (search_buf[i] == 0x50 && search_buf[i+1] == 0x4B && 
-                        search_buf[i+2] == 0x05 && search_buf[i+3] == 0x06) {
-                        // 找到 EOCD 标记
-                        uint16_t comment_len = *(uint16_t*)(&search_buf[i + 20]);
-                        return (pos + i + 22 + comment_len) - offset;
-                    }
+            pending++;
+        }
+    }
+    for (size_t i = 0; i < job->claim_count; i++) {
+        add_claim(&ctx->claims, &ctx->claim_count, &ctx->claim_capacity, job->claims[i].offset,
+                  job->claims[i].offset + job->claims[i].length);
+    }
+    trim_claims(ctx, job->open_from);
+    ctx->footers_streamed += job->footers_streamed;
+    ctx->footers_searched += job->footers_searched;
+    ctx->fill_bytes += job->fill_bytes;
+    ctx->random_bytes += job->random_bytes;
+    if (ctx->found_count >= ctx->max_results) {
+        __atomic_store_n(&ctx->stop, 1, __ATOMIC_RELAXED);
+    }
+
+    // 更新进度
+    ctx->bytes_scanned += job->block.size;
+    char message[128];
+    format_progress(ctx, message, sizeof(message));
+    int progress = utils_calculate_progress(job->block.offset - ctx->start, ctx->end - ctx->start);
+    utils_show_progress(progress, message);
+}
+
+// 派发下一个数据块：按顺序从流水线取出并送入文本检测器（文本区间跨数据块累计，只能顺序检测）。
+// 取到数据块返回 1；任务环已满（最早的任务尚未合并）返回 0；没有更多数据块返回 -1
+static int dispatch_job(scan_context_t* ctx, scan_job_t** out) {
+    int ret = -1;
+    int finished = 0;
+    pthread_mutex_lock(&ctx->dispatch_lock);
+    if (!ctx->dispatch_done && !scan_stopped(ctx)) {
+        pthread_mutex_lock(&ctx->merge_lock);
+        int full = ctx->dispatch_sequence - ctx->merge_sequence >= ctx->job_slots;
+        pthread_mutex_unlock(&ctx->merge_lock);
+
+        scan_job_t* job = &ctx->jobs[ctx->dispatch_sequence % ctx->job_slots];
+        ret = full ? 0 : scan_pipeline_next(ctx->pipeline, &job->block);
+        if (ret <= 0 && !full) {
+            ctx->dispatch_done = 1;
+            ctx->read_failed = ret < 0;
+            finished = 1;
+            ret = -1;
+        } else if (ret > 0) {
+            // 合并线程会检查最早任务的状态，状态和顺序号在 merge_lock 下更新
+            pthread_mutex_lock(&ctx->merge_lock);
+            job->state = JOB_SCANNING;
+            job->sequence = ctx->dispatch_sequence++;
+            pthread_mutex_unlock(&ctx->merge_lock);
+            job->run_count = 0;
+            job->group_count = 0;
+            job->signature_count = 0;
+            job->match_failed = 0;
+            job->skip_to = 0;
+            job->resolved = 0;
+            job->outstanding = 0;
+            job->hit_count = 0;
+            job->hits_valid = 0;
+            job->found_count = 0;
+            job->pending_count = 0;
+            job->footers_streamed = 0;
+            job->footers_searched = 0;
+            job->claim_count = 0;
+            job->carried.length = 0;
+            job->text_from = UINT64_MAX;
+            job->open_from = UINT64_MAX;
+            job->fill_bytes = 0;
+            job->random_bytes = 0;
+
+            text_run_t open = { 0, 0, 0 };
+            if (ctx->text) {
+                text_detector_feed(ctx->text, job->block.data, job->block.size, job->block.offset,
+                                   collect_run, job);
+                if (text_detector_pending(ctx->text, &open)) {
+                    job->text_from = open.offset;
                 }
             }
-            return 5 * 1024 * 1024; // 默认 5MB
+            if (open.length > 0) {
+                job->open_from = open.offset;
+            }
+            *out = job;
+            ret = 1;
+        }
+    }
+    pthread_mutex_unlock(&ctx->dispatch_lock);
+
+    if (finished) {
+        // 等待中的线程重新检查是否已全部完成
+        work_queue_notify(ctx->queue);
+    }
+    return ret;
+}
+
+static void complete_job(scan_context_t* ctx, scan_job_t* job) {
+    pthread_mutex_lock(&ctx->merge_lock);
+    job->state = JOB_DONE;
+    for (;;) {
+        scan_job_t* next = &ctx->jobs[ctx->merge_sequence % ctx->job_slots];
+        if (next->state != JOB_DONE || next->sequence != ctx->merge_sequence) {
+            break;
+        }
+        merge_job(ctx, next);
+        next->state = JOB_FREE;
+        ctx->merge_sequence++;
+    }
+    pthread_mutex_unlock(&ctx->merge_lock);
+    // 任务环出现空位，等待中的线程可以继续派发
+    work_queue_notify(ctx->queue);
+}
+
+// 处理一个数据块：匹配后归还缓冲区，每个候选位置提交一个分类任务（空闲线程从队列头部窃取，
+// 即最靠前、解析最先需要的位置），自己随即按顺序解析
+static void run_job(scan_context_t* ctx, scan_job_t* job, uint32_t worker) {
+    match_job(ctx, job);
+    scan_pipeline_release(ctx->pipeline, &job->block);
+
+    job->outstanding = 1;
+    size_t submitted = 0;
+    if (ctx->threads > 1 && job->group_count > 1) {
+        pthread_mutex_lock(&job->lock);
+        job->outstanding += (uint32_t)job->group_count;
+        pthread_mutex_unlock(&job->lock);
+        for (; submitted < job->group_count; submitted++) {
+            if (work_queue_push(ctx->queue, worker, carve_task, job, submitted) < 0) {
+                break;
+            }
+        }
+        if (submitted < job->group_count) {
+            pthread_mutex_lock(&job->lock);
+            job->outstanding -= (uint32_t)(job->group_count - submitted);
+            pthread_mutex_unlock(&job->lock);
+        }
+        __atomic_fetch_add(&ctx->carve_tasks, submitted, __ATOMIC_RELAXED);
+    }
+
+    resolve_job(ctx, job);
+    release_task(ctx, job);
+}
+
+// 工作线程：先执行自己队列中的任务，再窃取其他线程的分类任务，都没有时派发新的数据块
+typedef struct {
+    scan_context_t* ctx;
+    uint32_t index;
+} scan_worker_t;
+
+static int all_merged(scan_context_t* ctx) {
+    pthread_mutex_lock(&ctx->dispatch_lock);
+    int done = ctx->dispatch_done || scan_stopped(ctx);
+    uint64_t dispatched = ctx->dispatch_sequence;
+    pthread_mutex_unlock(&ctx->dispatch_lock);
+
+    pthread_mutex_lock(&ctx->merge_lock);
+    done = done && ctx->merge_sequence == dispatched;
+    pthread_mutex_unlock(&ctx->merge_lock);
+    return done;
+}
+
+static void* scan_worker(void* arg) {
+    scan_worker_t* worker = (scan_worker_t*)arg;
+    scan_context_t* ctx = worker->ctx;
+
+    for (;;) {
+        uint64_t epoch = work_queue_epoch(ctx->queue);
+        work_item_t item;
+        if (work_queue_pop(ctx->queue, worker->index, &item)) {
+            item.fn(item.arg, item.index);
+            continue;
+        }
+
+        scan_job_t* job;
+        int ret = dispatch_job(ctx, &job);
+        if (ret > 0) {
+            run_job(ctx, job, worker->index);
+            continue;
+        }
+        if (ret < 0 && all_merged(ctx)) {
+            break;
+        }
+        work_queue_wait(ctx->queue, epoch);
+    }
+    return NULL;
+}
+
+// 通过预读流水线扫描指定区间：读取线程在后台读取，多个工作线程并行匹配和分类，结果按偏移顺序合并
+static int scan_extents(scan_context_t* ctx, const disk_extent_t* extents, size_t extent_count,
+                        scan_pipeline_stats_t* stats) {
+    // 每个数据块多读取最长魔数跨度（或文件尾标记和长度字段）减一个字节，
+    // 跨越数据块边界的魔数和文件尾标记完整可见
+    size_t span = signature_matcher_max_span(ctx->matcher);
+    if (ctx->stream_footers && footer_tracker_max_need(ctx->footers) > span) {
+        span = footer_tracker_max_need(ctx->footers);
+    }
+    scan_pipeline_t* pipeline = scan_pipeline_create(ctx->handle, extents, extent_count,
+                                                     ctx->block_size, span > 0 ? span - 1 : 0,
+                                                     ctx->options->io_depth,
+                                                     ctx->options->memory_budget);
+    if (!pipeline) {
+        return -1;
+    }
+
+    if (stats->blocks == 0) {
+        printf("I/O backend: %s, %u read-ahead buffers, %u scan threads\n",
+               scan_pipeline_backend(pipeline), scan_pipeline_buffers(pipeline), ctx->threads);
+    }
+
+    ctx->pipeline = pipeline;
+    ctx->dispatch_done = 0;
+    ctx->read_failed = 0;
+
+    // 调用线程也作为一个工作线程（编号 0）
+    pthread_t threads[SCANNER_MAX_THREADS];
+    scan_worker_t workers[SCANNER_MAX_THREADS];
+    for (uint32_t i = 0; i < ctx->threads; i++) {
+        workers[i].ctx = ctx;
+        workers[i].index = i;
+    }
+    uint32_t started = 0;
+    while (started + 1 < ctx->threads) {
+        if (pthread_create(&threads[started], NULL, scan_worker, &workers[started + 1]) != 0) {
+            fprintf(stderr, "Warning: Cannot start scan thread, continuing with %u\n", started + 1);
+            break;
+        }
+        started++;
+    }
+    scan_worker(&workers[0]);
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    ctx->pipeline = NULL;
+
+    // 文件尾仍未出现的结果：剩余范围不在本遍读取的数据中
+    search_open(ctx);
+
+    // 最后一个文本区间延续到扫描范围末尾
+    if (ctx->text) {
+        text_detector_finish(ctx->text, finish_run, ctx);
+    }
+
+    if (ctx->read_failed) {
+        fprintf(stderr, "\nError: Read failed, scan stopped early "
+                "(enable rescue reads to skip unreadable regions)\n");
+    }
+
+    scan_pipeline_stats_t pass;
+    scan_pipeline_get_stats(pipeline, &pass);
+    scan_pipeline_destroy(pipeline);
+
+    stats->blocks += pass.blocks;
+    stats->bytes += pass.bytes;
+    stats->consumer_waits += pass.consumer_waits;
+    stats->producer_waits += pass.producer_waits;
+    return 0;
+}
+
+static int scan_pipelined(scan_context_t* ctx) {
+    // 稀疏镜像：只读取包含数据的区间，空洞直接跳过
+    disk_extent_t* extents = NULL;
+    size_t extent_count = 0;
+    if (disk_get_data_extents(ctx->handle, ctx->start, ctx->end, &extents, &extent_count) < 0) {
+        fprintf(stderr, "Error: Cannot determine data extents\n");
+        return -1;
+    }
+
+    uint64_t data_bytes = 0;
+    for (size_t i = 0; i < extent_count; i++) {
+        data_bytes += extents[i].length;
+    }
+    uint64_t range_end = ctx->end < disk_get_size(ctx->handle) ? ctx->end : disk_get_size(ctx->handle);
+    uint64_t hole_bytes = range_end > ctx->start ? (range_end - ctx->start) - data_bytes : 0;
+
+    scan_pipeline_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    ctx->stream_footers = ctx->footers != NULL;
+    int ret = scan_extents(ctx, extents, extent_count, &stats);
+    free(extents);
+    if (ret < 0) {
+        return -1;
+    }
+
+    // 容错读取：重试第一遍跳过的区间，并扫描重新读到的数据
+    disk_extent_t* recovered = NULL;
+    size_t recovered_count = 0;
+    if (ctx->found_count < ctx->max_results &&
+        disk_retry_skipped(ctx->handle, ctx->start, ctx->end, &recovered, &recovered_count) < 0) {
+        // 跳过的区间仍记录在坏块图中，下次运行时重试
+        fprintf(stderr, "Warning: Retry pass failed, skipped regions were not rescanned\n");
+    } else if (recovered_count > 0) {
+        uint64_t recovered_bytes = 0;
+        for (size_t i = 0; i < recovered_count; i++) {
+            recovered_bytes += recovered[i].length;
         }
-        
-        default:
-            // 对于未知类型，返回一个合理的默认大小
-            return 1024 * 1024; // 1MB
+
+        char size_buf[32];
+        printf("\nRetry pass recovered %s in %zu regions, rescanning...\n",
+               utils_format_size(recovered_bytes, size_buf, sizeof(size_buf)), recovered_count);
+        // 重新读到的区间互不相连，不能由顺序读到的标记确定文件尾
+        ctx->stream_footers = 0;
+        ret = scan_extents(ctx, recovered, recovered_count, &stats);
+    }
+    free(recovered);
+    if (ret < 0) {
+        return -1;
+    }
+
+    printf("\nRead-ahead: %llu blocks, scanner waited %llu times, reader throttled %llu times\n",
+           (unsigned long long)stats.blocks,
+           (unsigned long long)stats.consumer_waits,
+           (unsigned long long)stats.producer_waits);
+
+    if (ctx->threads > 1) {
+        work_queue_stats_t queue_stats;
+        work_queue_get_stats(ctx->queue, &queue_stats);
+        printf("Scheduler: %llu carve tasks, %llu stolen, %llu skipped (already resolved)\n",
+               (unsigned long long)ctx->carve_tasks,
+               (unsigned long long)queue_stats.stolen,
+               (unsigned long long)ctx->carve_skipped);
+    }
+
+    if (hole_bytes > 0) {
+        char size_buf[32];
+        printf("Skipped %s of sparse holes (%zu data extents)\n",
+               utils_format_size(hole_bytes, size_buf, sizeof(size_buf)), extent_count);
+    }
+    return 0;
+}
+
+// 工作线程数：未指定时使用在线 CPU 核数
+static uint32_t scan_threads(const scan_options_t* options) {
+    long threads = options->threads ? (long)options->threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > SCANNER_MAX_THREADS) {
+        threads = SCANNER_MAX_THREADS;
+    }
+    return (uint32_t)threads;
+}
+
+static void release_jobs(scan_context_t* ctx) {
+    for (uint32_t i = 0; ctx->jobs && i < ctx->job_slots; i++) {
+        free(ctx->jobs[i].runs);
+        free(ctx->jobs[i].hits);
+        free(ctx->jobs[i].found);
+        free(ctx->jobs[i].pending);
+        free(ctx->jobs[i].claims);
+        free(ctx->jobs[i].groups);
+        free(ctx->jobs[i].group_signatures);
+        pthread_cond_destroy(&ctx->jobs[i].carved);
+        pthread_mutex_destroy(&ctx->jobs[i].lock);
     }
+    free(ctx->jobs);
+    free(ctx->claims);
+    free(ctx->open);
+    work_queue_destroy(ctx->queue);
+    pthread_mutex_destroy(&ctx->merge_lock);
+    pthread_mutex_destroy(&ctx->dispatch_lock);
 }
 
-int scanner_scan(disk_handle_t* handle, const scan_options_t* options,
-                scan_result_t* results, int max_results) {
-    if (!handle || !options || !results || max_results <= 0) {
+// 确定对齐扫描的对齐值：自动对齐时使用识别出的文件系统的簇大小（簇从数据区起点开始排列），
+// 无法识别时使用设备的逻辑扇区大小；返回对齐值的来源
+static const char* select_alignment(scan_context_t* ctx) {
+    const scan_options_t* options = ctx->options;
+    ctx->alignment = options->alignment;
+    ctx->alignment_base = options->alignment_base;
+    if (options->alignment != SCANNER_ALIGN_AUTO) {
+        return "configured";
+    }
+
+    fs_info_t info;
+    if (fs_parse_info(ctx->handle, &info) == 0 && info.cluster_size > 0 &&
+        info.cluster_size < SCANNER_ALIGN_AUTO) {
+        ctx->alignment = (uint32_t)info.cluster_size;
+        ctx->alignment_base = info.data_offset % info.cluster_size;
+        return fs_get_type_name(info.type);
+    }
+    ctx->alignment = ctx->handle->sector_size ? ctx->handle->sector_size : REGION_CLASSIFIER_SECTOR;
+    ctx->alignment_base = 0;
+    return "sector size, no file system recognized";
+}
+
+static void release_selection(scan_context_t* ctx) {
+    region_classifier_destroy(ctx->regions);
+    footer_tracker_destroy(ctx->footers);
+    if (ctx->own_matcher) {
+        signature_matcher_destroy(ctx->own_matcher);
+    }
+    free(ctx->own_signatures);
+    free(ctx->selected);
+}
+
+int64_t scanner_scan(disk_handle_t* handle, const scan_options_t* options, result_sink_t* results) {
+    if (!handle || !options || !results) {
         return -1;
     }
 
@@ -125,75 +1304,193 @@ int scanner_scan(disk_handle_t* handle, const scan_options_t* options,
         scanner_init();
     }
 
-    uint64_t start = options->start_offset;
-    uint64_t end = options->end_offset ? options->end_offset : disk_get_size(handle);
-    uint32_t block_size = options->block_size ? options->block_size : DEFAULT_BLOCK_SIZE;
-    
-    uint8_t* buffer = (uint8_t*)malloc(block_size);
-    if (!buffer) {
+    scan_context_t ctx = {
+        .handle = handle,
+        .options = options,
+        .results = results,
+        .max_results = options->max_results ? options->max_results : UINT64_MAX,
+        .found_count = 0,
+        .start = options->start_offset,
+        .end = options->end_offset ? options->end_offset : disk_get_size(handle),
+        .block_size = options->block_size ? options->block_size : DEFAULT_BLOCK_SIZE,
+        .started_ns = utils_monotonic_ns(),
+        .bytes_scanned = 0,
+        .threads = scan_threads(options)
+    };
+    pthread_mutex_init(&ctx.dispatch_lock, NULL);
+    pthread_mutex_init(&ctx.merge_lock, NULL);
+
+    // 任务环限制工作线程领先合并进度的数据块数，最慢的数据块不会使暂存的结果无限增长
+    ctx.job_slots = ctx.threads * JOBS_PER_THREAD;
+    ctx.jobs = (scan_job_t*)calloc(ctx.job_slots, sizeof(scan_job_t));
+    if (!ctx.jobs) {
         fprintf(stderr, "Error: Memory allocation failed\n");
+        release_jobs(&ctx);
+        return -1;
+    }
+    for (uint32_t i = 0; i < ctx.job_slots; i++) {
+        ctx.jobs[i].ctx = &ctx;
+        pthread_mutex_init(&ctx.jobs[i].lock, NULL);
+        pthread_cond_init(&ctx.jobs[i].carved, NULL);
+    }
+
+    ctx.queue = work_queue_create(ctx.threads);
+    if (!ctx.queue) {
+        release_jobs(&ctx);
         return -1;
     }
 
-    int found_count = 0;
-    uint64_t current_offset = start;
+    if (select_types(&ctx) < 0) {
+        release_selection(&ctx);
+        release_jobs(&ctx);
+        return -1;
+    }
 
-    printf("Scanning from offset 0x%llx to 0x%llx...\n", 
-           (unsigned long long)start, (unsigned long long)end);
-
-    while (current_offset < end && found_count < max_results) {
-        // 读取数据块
-        size_t read_size = (current_offset + block_size <= end) ? 
-                          block_size : (end - current_offset);
-        
-        ssize_t bytes_read = disk_read(handle, current_offset, buffer, read_size);
-        if (bytes_read <= 0) {
-            break;
+    if (options->skip_barren) {
+        ctx.regions = region_classifier_create(options->barren_entropy);
+        if (!ctx.regions) {
+            release_selection(&ctx);
+            release_jobs(&ctx);
+            return -1;
         }
+    }
 
-        // 扫描数据块中的文件签名
-        for (size_t i = 0; i < (size_t)bytes_read - 16 && found_count < max_results; i++) {
-            file_type_t type = signature_identify(&buffer[i], bytes_read - i);
-            
-            if (type != FILE_TYPE_UNKNOWN) {
-                // 找到一个潜在的文件
-                scan_result_t* result = &results[found_count];
-                result->offset = current_offset + i;
-                result->type = type;
-                result->confidence = 80; // 基本置信度
-                
-                // 估算文件大小
-                result->size = estimate_file_size(handle, result->offset, type);
-                
-                found_count++;
-                
-                // 跳过已识别的文件内容
-                i += (result->size < block_size) ? result->size : block_size;
-                
-                // 如果设置了回调，调用它
-                if (options->callback) {
-                    options->callback(result, options->user_data);
-                }
-            }
+    // 没有选择纯文本类型时不运行文本检测
+    if (type_selected(&ctx, FILE_TYPE_TXT)) {
+        ctx.text = text_detector_create(options->text_min_length, options->text_min_entropy);
+        if (!ctx.text) {
+            release_selection(&ctx);
+            release_jobs(&ctx);
+            return -1;
         }
+    }
 
-        // 更新进度
-        int progress = utils_calculate_progress(current_offset - start, end - start);
-        utils_show_progress(progress, "Scanning...");
+    const char* alignment_source = select_alignment(&ctx);
 
-        current_offset += bytes_read;
+    // 没有任何类型有文件尾标记时为 NULL，每个候选文件单独搜索
+    if (ctx.matcher) {
+        ctx.footers = footer_tracker_create(ctx.signatures, ctx.signature_count);
+    }
+
+    printf("Scanning from offset 0x%llx to 0x%llx...\n", 
+           (unsigned long long)ctx.start, (unsigned long long)ctx.end);
+    if (ctx.selected) {
+        size_t total;
+        signature_get_all(&total);
+        printf("Type filter: %zu of %zu signatures, text detection %s\n",
+               ctx.signature_count, total, ctx.text ? "on" : "off");
+    }
+    if (ctx.regions) {
+        printf("Barren region skipping: fill patterns and entropy >= %.2f bits/byte (%s)\n",
+               options->barren_entropy >= 0 ? options->barren_entropy : REGION_CLASSIFIER_DEFAULT_MAX_ENTROPY,
+               region_classifier_isa(ctx.regions));
+    }
+    if (ctx.alignment > 1) {
+        printf("Aligned scan: signatures checked at offsets %llu + k * %u (%s)\n",
+               (unsigned long long)(ctx.alignment_base % ctx.alignment), ctx.alignment, alignment_source);
+    }
+
+    int ret = scan_pipelined(&ctx);
+    int text_enabled = ctx.text != NULL;
+    int barren_enabled = ctx.regions != NULL;
+    int footers_enabled = ctx.footers != NULL;
+    text_detector_stats_t text_stats;
+    if (text_enabled) {
+        text_detector_get_stats(ctx.text, &text_stats);
+        text_detector_destroy(ctx.text);
+    }
+    release_jobs(&ctx);
+    release_selection(&ctx);
+    if (ret < 0) {
+        return -1;
     }
 
     utils_show_progress(100, "Scan complete");
     
-    free(buffer);
-    printf("\nFound %d potential files\n", found_count);
+    printf("\nFound %llu potential files\n", (unsigned long long)ctx.found_count);
+
+    if (text_enabled) {
+        char text_buf[32];
+        printf("Text runs: %llu (%s), %llu rejected by entropy\n",
+               (unsigned long long)text_stats.runs,
+               utils_format_size(text_stats.text_bytes, text_buf, sizeof(text_buf)),
+               (unsigned long long)text_stats.low_entropy_runs);
+    }
+
+    if (barren_enabled) {
+        char fill_buf[32];
+        char random_buf[32];
+        printf("Barren regions: %s fill skipped, %s high-entropy (only %d-byte aligned starts checked)\n",
+               utils_format_size(ctx.fill_bytes, fill_buf, sizeof(fill_buf)),
+               utils_format_size(ctx.random_bytes, random_buf, sizeof(random_buf)),
+               REGION_CLASSIFIER_SECTOR);
+    }
+
+    if (footers_enabled) {
+        printf("Footer tracking: %llu sizes resolved in the scan pass, %llu by separate reads\n",
+               (unsigned long long)ctx.footers_streamed,
+               (unsigned long long)ctx.footers_searched);
+    }
+
+    disk_cache_stats_t cache_stats;
+    if (disk_get_cache_stats(handle, &cache_stats) == 0) {
+        printf("Block cache: %llu hits, %llu misses, %llu evictions\n",
+               (unsigned long long)cache_stats.hits,
+               (unsigned long long)cache_stats.misses,
+               (unsigned long long)cache_stats.evictions);
+    }
+
+    disk_badmap_stats_t rescue_stats;
+    if (disk_get_rescue_stats(handle, &rescue_stats) == 0 && rescue_stats.read_errors > 0) {
+        char skipped_buf[32];
+        char bad_buf[32];
+        const char* map_path = disk_badmap_path(handle->badmap);
+        printf("Read errors: %llu, unreadable %s, still skipped %s (bad-block map: %s)\n",
+               (unsigned long long)rescue_stats.read_errors,
+               utils_format_size(rescue_stats.unreadable_bytes, bad_buf, sizeof(bad_buf)),
+               utils_format_size(rescue_stats.skipped_bytes, skipped_buf, sizeof(skipped_buf)),
+               map_path ? map_path : "in memory");
+    }
+
+    disk_throttle_stats_t throttle_stats;
+    if (disk_get_throttle_stats(handle, &throttle_stats) == 0) {
+        printf("Throttle: waited %llu times (%.1fs), %llu backoffs, "
+               "latency %lluus (baseline %lluus), rate at %.0f%% of limit\n",
+               (unsigned long long)throttle_stats.waits,
+               (double)throttle_stats.wait_ns / 1e9,
+               (unsigned long long)throttle_stats.backoffs,
+               (unsigned long long)throttle_stats.latency_us,
+               (unsigned long long)throttle_stats.baseline_us,
+               throttle_stats.scale * 100.0);
+    }
     
-    return found_count;
+    return ctx.store_failed ? -1 : (int64_t)ctx.found_count;
 }
 
-int scanner_quick_scan(disk_handle_t* handle, scan_result_t* results, int max_results) {
-    if (!handle || !results || max_results <= 0) {
+// 快速扫描的状态
+typedef struct {
+    const fs_info_t* info;
+    result_sink_t* results;
+    int failed;
+} quick_scan_t;
+
+// 把一个已删除的文件转换为扫描结果
+static int add_deleted(const file_entry_t* entry, void* user_data) {
+    quick_scan_t* scan = (quick_scan_t*)user_data;
+    scan_result_t result;
+    result.offset = scan->info->data_offset + (entry->cluster - 2) * scan->info->cluster_size;
+    result.size = entry->size;
+    result.type = FILE_TYPE_UNKNOWN; // 需要进一步识别
+    result.confidence = 90; // 文件系统级别的信息更可靠
+    if (result_sink_append(scan->results, &result) < 0) {
+        scan->failed = 1;
+        return 1;
+    }
+    return 0;
+}
+
+int64_t scanner_quick_scan(disk_handle_t* handle, result_sink_t* results) {
+    if (!handle || !results) {
         return -1;
     }
 
@@ -212,46 +1509,52 @@ int scanner_quick_scan(disk_handle_t* handle, scan_result_t* results, int max_re
     printf("Total size: %s\n", utils_format_size(fs_info.total_size, size_buf, sizeof(size_buf)));
     printf("Cluster size: %s\n", utils_format_size(fs_info.cluster_size, size_buf, sizeof(size_buf)));
 
-    // 扫描已删除的文件
-    file_entry_t* entries = (file_entry_t*)malloc(max_results * sizeof(file_entry_t));
-    if (!entries) {
+    // 扫描已删除的文件，逐个转换为扫描结果
+    quick_scan_t scan = { &fs_info, results, 0 };
+    int found = fs_scan_deleted_files(handle, &fs_info, add_deleted, &scan);
+    if (scan.failed) {
         return -1;
     }
-
-    int found = fs_scan_deleted_files(handle, &fs_info, entries, max_results);
-    
-    // 转换为扫描结果
-    for (int i = 0; i < found; i++) {
-        results[i].offset = fs_info.data_offset + 
-                           (entries[i].cluster - 2) * fs_info.cluster_size;
-        results[i].size = entries[i].size;
-        results[i].type = FILE_TYPE_UNKNOWN; // 需要进一步识别
-        results[i].confidence = 90; // 文件系统级别的信息更可靠
-    }
-
-    free(entries);
     printf("Quick scan found %d deleted files\n", found);
     
     return found;
 }
 
-int scanner_deep_scan(disk_handle_t* handle, scan_result_t* results, int max_results) {
-    if (!handle || !results || max_results <= 0) {
+void scanner_default_options(scan_options_t* options) {
+    if (!options) {
+        return;
+    }
+
+    memset(options, 0, sizeof(scan_options_t));
+    options->start_offset = 0;
+    options->end_offset = 0;  // 扫描整个设备
+    options->block_size = DEFAULT_BLOCK_SIZE;
+    options->deep_scan = 1;
+    options->io_depth = DISK_AIO_DEFAULT_DEPTH;
+    options->memory_budget = SCAN_PIPELINE_DEFAULT_BUDGET;
+    options->text_min_length = TEXT_DETECTOR_DEFAULT_MIN_LENGTH;
+    options->text_min_entropy = TEXT_DETECTOR_DEFAULT_MIN_ENTROPY;
+    options->skip_barren = 0;
+    options->barren_entropy = REGION_CLASSIFIER_DEFAULT_MAX_ENTROPY;
+    options->threads = 0;     // CPU 核数
+    options->alignment = 0;   // 每个字节都检查
+    options->alignment_base = 0;
+    options->max_results = 0; // 不限
+    options->callback = NULL;
+    options->user_data = NULL;
+}
+
+int64_t scanner_deep_scan(disk_handle_t* handle, result_sink_t* results) {
+    if (!handle || !results) {
         return -1;
     }
 
     printf("Performing deep scan (signature-based)...\n");
 
-    scan_options_t options = {
-        .start_offset = 0,
-        .end_offset = 0,  // 扫描整个设备
-        .block_size = DEFAULT_BLOCK_SIZE,
-        .deep_scan = 1,
-        .callback = NULL,
-        .user_data = NULL
-    };
+    scan_options_t options;
+    scanner_default_options(&options);
 
-    return scanner_scan(handle, &options, results, max_results);
+    return scanner_scan(handle, &options, results);
 }
 
 void scanner_cleanup(void) {
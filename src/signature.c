@@ -1,101 +1,445 @@
 #include "signature.h"
+#include "signature_matcher.h"
+#include "signature_db.h"
+#include "signature_formats.h"
+#include "utils.h"
+#include "signature_dispatch.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-// 文件签名数据库
+// 文件签名数据库（内置签名定义在 signatures.def 中）
 static file_signature_t signatures[] = {
-    // 图片文件
-    {FILE_TYPE_JPEG, "jpg", (const uint8_t*)"\xFF\xD8\xFF", 3, 0, "JPEG Image"},
-    {FILE_TYPE_PNG, "png", (const uint8_t*)"\x89\x50\x4E\x47\x0D\x0A\x1A\x0A", 8, 0, "PNG Image"},
-    {FILE_TYPE_GIF, "gif", (const uint8_t*)"GIF89a", 6, 0, "GIF Image (89a)"},
-    {FILE_TYPE_GIF, "gif", (const uint8_t*)"GIF87a", 6, 0, "GIF Image (87a)"},
-    {FILE_TYPE_BMP, "bmp", (const uint8_t*)"BM", 2, 0, "BMP Image"},
-    
-    // 文档文件
-    {FILE_TYPE_PDF, "pdf", (const uint8_t*)"%PDF-", 5, 0, "PDF Document"},
-    {FILE_TYPE_DOC, "doc", (const uint8_t*)"\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8, 0, "MS Word Document"},
-    {FILE_TYPE_DOCX, "docx", (const uint8_t*)"\x50\x4B\x03\x04", 4, 0, "MS Word Document (DOCX)"},
-    {FILE_TYPE_XLS, "xls", (const uint8_t*)"\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8, 0, "MS Excel Spreadsheet"},
-    {FILE_TYPE_XLSX, "xlsx", (const uint8_t*)"\x50\x4B\x03\x04", 4, 0, "MS Excel Spreadsheet (XLSX)"},
-    {FILE_TYPE_PPT, "ppt", (const uint8_t*)"\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8, 0, "MS PowerPoint Presentation"},
-    {FILE_TYPE_PPTX, "pptx", (const uint8_t*)"\x50\x4B\x03\x04", 4, 0, "MS PowerPoint Presentation (PPTX)"},
-    
-    // 压缩文件
-    {FILE_TYPE_ZIP, "zip", (const uint8_t*)"\x50\x4B\x03\x04", 4, 0, "ZIP Archive"},
-    {FILE_TYPE_ZIP, "zip", (const uint8_t*)"\x50\x4B\x05\x06", 4, 0, "ZIP Archive (empty)"},
-    {FILE_TYPE_RAR, "rar", (const uint8_t*)"Rar!\x1A\x07\x00", 7, 0, "RAR Archive (v1.5+)"},
-    {FILE_TYPE_RAR, "rar", (const uint8_t*)"Rar!\x1A\x07\x01\x00", 8, 0, "RAR Archive (v5.0+)"},
-    {FILE_TYPE_7Z, "7z", (const uint8_t*)"7z\xBC\xAF\x27\x1C", 6, 0, "7-Zip Archive"},
-    
-    // 音视频文件
-    {FILE_TYPE_MP3, "mp3", (const uint8_t*)"\xFF\xFB", 2, 0, "MP3 Audio (MPEG-1 Layer 3)"},
-    {FILE_TYPE_MP3, "mp3", (const uint8_t*)"\x49\x44\x33", 3, 0, "MP3 Audio (ID3v2)"},
-    {FILE_TYPE_MP4, "mp4", (const uint8_t*)"ftyp", 4, 4, "MP4 Video"},
-    {FILE_TYPE_AVI, "avi", (const uint8_t*)"RIFF", 4, 0, "AVI Video"},
-    {FILE_TYPE_MOV, "mov", (const uint8_t*)"moov", 4, 4, "QuickTime Movie"},
-    
-    // 文本文件
-    {FILE_TYPE_HTML, "html", (const uint8_t*)"<!DOCTYPE html", 14, 0, "HTML Document"},
-    {FILE_TYPE_HTML, "html", (const uint8_t*)"<html", 5, 0, "HTML Document"},
-    {FILE_TYPE_XML, "xml", (const uint8_t*)"<?xml", 5, 0, "XML Document"},
-    
-    // 可执行文件
-    {FILE_TYPE_EXE, "exe", (const uint8_t*)"MZ", 2, 0, "Windows Executable"},
-    {FILE_TYPE_DLL, "dll", (const uint8_t*)"MZ", 2, 0, "Windows DLL"},
+#define SIGNATURE(type, extension, magic, magic_len, offset, description, validate, length, footer, classify) \
+    {type, extension, (const uint8_t*)(magic), magic_len, offset, description, validate, length, footer, classify},
+#include "signatures.def"
+#undef SIGNATURE
+};
+
+// 内置类型信息（类型名和大小规则）
+#define FOOTER(s) (const uint8_t*)(s), sizeof(s) - 1
+#define NO_FOOTER NULL, 0
+static const file_type_info_t builtin_types[] = {
+    {FILE_TYPE_JPEG, "jpeg", FOOTER("\xFF\xD9"), 0, -1, 2, 50 * 1024 * 1024, 1024 * 1024},
+    {FILE_TYPE_PNG, "png", FOOTER("IEND"), 4, -1, 8, 20 * 1024 * 1024, 512 * 1024},
+    {FILE_TYPE_GIF, "gif", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_BMP, "bmp", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_PDF, "pdf", FOOTER("%%EOF"), 0, -1, 5, 100 * 1024 * 1024, 2 * 1024 * 1024},
+    {FILE_TYPE_ZIP, "zip", FOOTER("PK\x05\x06"), 18, 20, 4, 200 * 1024 * 1024, 5 * 1024 * 1024},
+    {FILE_TYPE_RAR, "rar", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_7Z, "7z", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_DOC, "doc", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_DOCX, "docx", FOOTER("PK\x05\x06"), 18, 20, 4, 200 * 1024 * 1024, 5 * 1024 * 1024},
+    {FILE_TYPE_XLS, "xls", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_XLSX, "xlsx", FOOTER("PK\x05\x06"), 18, 20, 4, 200 * 1024 * 1024, 5 * 1024 * 1024},
+    {FILE_TYPE_PPT, "ppt", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_PPTX, "pptx", FOOTER("PK\x05\x06"), 18, 20, 4, 200 * 1024 * 1024, 5 * 1024 * 1024},
+    {FILE_TYPE_MP3, "mp3", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_MP4, "mp4", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_AVI, "avi", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_MOV, "mov", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_TXT, "txt", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_HTML, "html", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_XML, "xml", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_EXE, "exe", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
+    {FILE_TYPE_DLL, "dll", NO_FOOTER, 0, -1, 0, 0, SIGNATURE_DEFAULT_FILE_SIZE},
 };
+#undef FOOTER
+#undef NO_FOOTER
+
+#define BUILTIN_SIGNATURE_COUNT (sizeof(signatures) / sizeof(signatures[0]))
+static const size_t builtin_type_count = sizeof(builtin_types) / sizeof(builtin_types[0]);
 
-static const size_t signature_count = sizeof(signatures) / sizeof(signatures[0]);
+// 当前使用的数据库（默认为内置数据库，signature_load() 后为加载的数据库）
+static file_signature_t* active_signatures = signatures;
+static size_t signature_count = BUILTIN_SIGNATURE_COUNT;
+static const file_type_info_t* active_types = builtin_types;
+static size_t type_count = sizeof(builtin_types) / sizeof(builtin_types[0]);
+static signature_db_t* database = NULL;
+
+// 按类型编号索引的扩展名和描述（内置数据库使用生成的数组，加载的数据库在加载时建立）
+static const char* const* type_extensions = builtin_extensions;
+static const char* const* type_descriptions = builtin_descriptions;
+static size_t type_slots = FILE_TYPE_MAX;
+static const char** loaded_names = NULL;
+
+// 由签名数据库编译的多模式匹配器（加载的数据库自带匹配器）
+static signature_matcher_t* builtin_matcher = NULL;
+static const signature_matcher_t* matcher = NULL;
 
 void signature_init(void) {
-    printf("Initialized signature database with %zu file signatures\n", signature_count);
+    signature_get_matcher();
+    printf("Initialized signature database with %zu file signatures (prefilter: %s)\n",
+           signature_count, signature_matcher_isa(matcher));
 }
 
-file_type_t signature_identify(const uint8_t* data, size_t size) {
-    if (!data || size == 0) {
-        return FILE_TYPE_UNKNOWN;
+const signature_matcher_t* signature_get_matcher(void) {
+    if (!matcher) {
+        if (!builtin_matcher) {
+            builtin_matcher = signature_matcher_create(signatures, BUILTIN_SIGNATURE_COUNT);
+        }
+        matcher = builtin_matcher;
     }
+    return matcher;
+}
 
-    // 遍历所有签名进行匹配
-    for (size_t i = 0; i < signature_count; i++) {
-        const file_signature_t* sig = &signatures[i];
-        
-        // 检查数据是否足够长
-        if (size < sig->offset + sig->magic_len) {
-            continue;
+// 建立加载的数据库的扩展名和描述数组（每种类型取第一个签名，前 *slots_out 项为扩展名）
+static const char** build_type_names(const file_signature_t* sigs, size_t count, size_t* slots_out) {
+    size_t slots = FILE_TYPE_MAX;
+    for (size_t i = 0; i < count; i++) {
+        if ((size_t)sigs[i].type >= slots) {
+            slots = (size_t)sigs[i].type + 1;
         }
+    }
+    const char** names = calloc(slots * 2, sizeof(const char*));
+    if (!names) {
+        return NULL;
+    }
+    for (size_t i = count; i > 0; i--) {
+        names[sigs[i - 1].type] = sigs[i - 1].extension;
+        names[slots + sigs[i - 1].type] = sigs[i - 1].description;
+    }
+    *slots_out = slots;
+    return names;
+}
 
-        // 比较魔数
-        if (memcmp(data + sig->offset, sig->magic, sig->magic_len) == 0) {
-            return sig->type;
+int signature_load(const char* path, const char* cache_path) {
+    uint64_t started = utils_monotonic_ns();
+    signature_db_t* db = signature_db_open(path, cache_path, builtin_types, builtin_type_count);
+    if (!db) {
+        return -1;
+    }
+
+    size_t count;
+    size_t slots;
+    file_signature_t* sigs = signature_db_signatures(db, &count);
+    const char** names = build_type_names(sigs, count, &slots);
+    if (!names) {
+        fprintf(stderr, "Error: Failed to allocate signature name table\n");
+        signature_db_destroy(db);
+        return -1;
+    }
+
+    signature_cleanup();
+    database = db;
+    active_signatures = sigs;
+    signature_count = count;
+    loaded_names = names;
+    type_slots = slots;
+    type_extensions = names;
+    type_descriptions = names + slots;
+
+    // 与内置类型同名的类型沿用内置签名的处理函数（优先取魔数相同的签名）
+    for (size_t i = 0; i < signature_count; i++) {
+        file_signature_t* sig = &active_signatures[i];
+        const file_signature_t* source = NULL;
+        for (size_t k = 0; k < BUILTIN_SIGNATURE_COUNT; k++) {
+            const file_signature_t* builtin = &signatures[k];
+            if (builtin->type != sig->type) {
+                continue;
+            }
+            if (!source) {
+                source = builtin;
+            }
+            if (builtin->magic_len == sig->magic_len && builtin->offset == sig->offset &&
+                memcmp(builtin->magic, sig->magic, sig->magic_len) == 0) {
+                source = builtin;
+                break;
+            }
+        }
+        if (source) {
+            sig->validate = source->validate;
+            sig->resolve_length = source->resolve_length;
+            sig->find_footer = source->find_footer;
+            sig->classify = source->classify;
         }
     }
 
-    // 尝试检测纯文本文件
-    int is_text = 1;
-    size_t check_len = size < 1024 ? size : 1024;
-    for (size_t i = 0; i < check_len; i++) {
+    active_types = signature_db_types(db, &type_count);
+    matcher = signature_db_matcher(db);
+
+    printf("Loaded signature database: %s (%zu signatures, %zu types, %s in %.1f ms)\n",
+           signature_db_from_cache(db) ? cache_path : path, signature_count, type_count,
+           signature_db_from_cache(db) ? "mapped from cache" : "compiled",
+           (double)(utils_monotonic_ns() - started) / 1e6);
+    return 0;
+}
+
+void signature_cleanup(void) {
+    if (database) {
+        signature_db_destroy(database);
+        database = NULL;
+    }
+    if (loaded_names) {
+        free(loaded_names);
+        loaded_names = NULL;
+    }
+    active_signatures = signatures;
+    signature_count = BUILTIN_SIGNATURE_COUNT;
+    type_extensions = builtin_extensions;
+    type_descriptions = builtin_descriptions;
+    type_slots = FILE_TYPE_MAX;
+    active_types = builtin_types;
+    type_count = builtin_type_count;
+    matcher = builtin_matcher;
+}
+
+size_t signature_text_length(const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
         uint8_t c = data[i];
         // 检查是否为可打印字符或常见空白字符
-        if (c != '\n' && c != '\r' && c != '\t' && 
+        if (c != '\n' && c != '\r' && c != '\t' &&
             (c < 0x20 || c > 0x7E) && c < 0x80) {
-            is_text = 0;
-            break;
+            return i;
         }
     }
+    return size;
+}
+
+// 只取起始位置为 0 的第一个匹配（同一位置按签名顺序报告，第一个即优先级最高）
+static int identify_first(const signature_match_t* match, void* user_data) {
+    if (match->position == 0) {
+        *(uint32_t*)user_data = match->signature;
+    }
+    return 1;
+}
 
-    if (is_text) {
+// 内置数据库：按首字节查分派表，桶内签名按定义顺序比较
+static const file_signature_t* dispatch_identify(const uint8_t* data, size_t size) {
+    for (uint16_t i = dispatch_start[data[0]]; i < dispatch_start[data[0] + 1]; i++) {
+        const file_signature_t* sig = &signatures[dispatch_entries[i]];
+        // 带偏移的签名在每个桶中：先排除魔数超出数据的签名，再比较魔数的首字节
+        if (sig->offset + sig->magic_len > size || data[sig->offset] != sig->magic[0]) {
+            continue;
+        }
+        if (memcmp(data + sig->offset, sig->magic, sig->magic_len) == 0) {
+            return sig;
+        }
+    }
+    return NULL;
+}
+
+file_type_t signature_identify(const uint8_t* data, size_t size) {
+    if (!data || size == 0) {
+        return FILE_TYPE_UNKNOWN;
+    }
+
+    const file_signature_t* sig = NULL;
+    if (!database) {
+        sig = dispatch_identify(data, size);
+    } else {
+        // 加载的数据库：只需扫描最大签名跨度内的数据
+        const signature_matcher_t* m = signature_get_matcher();
+        uint32_t index = UINT32_MAX;
+        size_t span = signature_matcher_max_span(m);
+        signature_matcher_scan(m, data, size < span ? size : span, identify_first, &index);
+        if (index < signature_count) {
+            sig = &active_signatures[index];
+        }
+    }
+    if (sig) {
+        // 魔数相同的类型只按已有的数据分类
+        signature_candidate_t candidate = { data, size, NULL, NULL };
+        return sig->classify ? sig->classify(&candidate, sig->type) : sig->type;
+    }
+
+    // 尝试检测纯文本文件
+    size_t check_len = size < SIGNATURE_TEXT_CHECK_LEN ? size : SIGNATURE_TEXT_CHECK_LEN;
+    if (signature_text_length(data, check_len) == check_len) {
         return FILE_TYPE_TXT;
     }
 
     return FILE_TYPE_UNKNOWN;
 }
 
-const char* signature_get_extension(file_type_t type) {
+size_t signature_footer_need(const file_type_info_t* info) {
+    if (!info || !info->footer) {
+        return 0;
+    }
+    size_t need = info->footer_len;
+    if (info->length_field >= 0 && (size_t)info->length_field + 2 > need) {
+        need = (size_t)info->length_field + 2;
+    }
+    return need;
+}
+
+// 默认搜索每次读取 SEARCH_CHUNK 字节，相邻两次读取重叠 need 字节
+#define SEARCH_CHUNK 4096
+
+int signature_footer_window(const file_type_info_t* info, uint64_t* from, uint64_t* to) {
+    if (!info || !info->footer || info->max_search <= info->search_start) {
+        return -1;
+    }
+    size_t need = signature_footer_need(info);
+    if (need >= SEARCH_CHUNK) {
+        return -1;
+    }
+    // 最后一次读取从小于 max_search 的位置开始，标记最远可以从该次读取的 SEARCH_CHUNK - need 处开始
+    uint64_t step = SEARCH_CHUNK - need;
+    uint64_t last = info->search_start + (info->max_search - 1 - info->search_start) / step * step;
+    *from = info->search_start;
+    *to = last + step;
+    return 0;
+}
+
+uint64_t signature_footer_end(const file_type_info_t* info, uint64_t position, const uint8_t* footer) {
+    uint64_t end = position + info->footer_len + info->footer_extra;
+    if (info->length_field >= 0) {
+        // 附加长度（如 ZIP 注释长度），小端
+        const uint8_t* field = &footer[info->length_field];
+        end += (uint64_t)field[0] | ((uint64_t)field[1] << 8);
+    }
+    return end;
+}
+
+int signature_find_footer_range(const signature_candidate_t* candidate, const file_type_info_t* info,
+                                uint64_t from, uint64_t to, uint64_t* length) {
+    if (!candidate || !info || !info->footer || !candidate->read) {
+        return -1;
+    }
+
+    // 标记和长度字段必须完整位于读取的数据中
+    size_t need = signature_footer_need(info);
+    if (need >= SEARCH_CHUNK) {
+        return -1;
+    }
+
+    uint8_t search_buf[SEARCH_CHUNK];
+    uint64_t step = sizeof(search_buf) - need;
+    for (uint64_t pos = from; pos <= to; pos += step) {
+        int64_t read_size = candidate->read(candidate->source, pos, search_buf, sizeof(search_buf));
+        if (read_size <= 0) break;
+
+        for (size_t i = 0; i + need <= (size_t)read_size && pos + i <= to; i++) {
+            if (search_buf[i] == info->footer[0] &&
+                memcmp(&search_buf[i], info->footer, info->footer_len) == 0) {
+                *length = signature_footer_end(info, pos + i, &search_buf[i]);
+                return 0;
+            }
+        }
+        // 这次读取已覆盖到 to
+        if (to - pos <= step) break;
+    }
+    return -1;
+}
+
+int signature_find_footer(const signature_candidate_t* candidate, const file_type_info_t* info,
+                          uint64_t* length) {
+    uint64_t from;
+    uint64_t to;
+    if (signature_footer_window(info, &from, &to) < 0) {
+        return -1;
+    }
+    return signature_find_footer_range(candidate, info, from, to, length);
+}
+
+int signature_classify(const file_signature_t* signature, const signature_candidate_t* candidate,
+                       file_type_t* type) {
+    if (!signature || !candidate || !type) {
+        return -1;
+    }
+    if (signature->validate && !signature->validate(candidate)) {
+        return -1;
+    }
+    *type = signature->classify ? signature->classify(candidate, signature->type) : signature->type;
+    return 0;
+}
+
+int signature_structure_size(const file_signature_t* signature, const signature_candidate_t* candidate,
+                             uint64_t* size) {
+    if (!signature || !candidate || !size || !signature->resolve_length) {
+        return -1;
+    }
+    return signature->resolve_length(candidate, size);
+}
+
+int signature_footer_size(const file_signature_t* signature, const signature_candidate_t* candidate,
+                          file_type_t type, uint64_t* size) {
+    if (!signature || !candidate || !size) {
+        return -1;
+    }
+
+    const file_type_info_t* info = signature_get_type_info(type);
+    if (!info) {
+        *size = SIGNATURE_DEFAULT_FILE_SIZE;
+        return 0;
+    }
+
+    signature_footer_fn find_footer = signature->find_footer ? signature->find_footer
+                                                             : signature_find_footer;
+    if (info->footer && find_footer(candidate, info, size) == 0) {
+        return 0;
+    }
+    *size = info->default_size;
+    return 0;
+}
+
+int signature_resolve_size(const file_signature_t* signature, const signature_candidate_t* candidate,
+                           file_type_t type, uint64_t* size) {
+    if (!signature || !candidate || !size) {
+        return -1;
+    }
+    if (signature_structure_size(signature, candidate, size) == 0) {
+        return 0;
+    }
+    return signature_footer_size(signature, candidate, type, size);
+}
+
+int signature_carve(const file_signature_t* signature, const signature_candidate_t* candidate,
+                    file_type_t* type, uint64_t* size) {
+    if (signature_classify(signature, candidate, type) < 0) {
+        return -1;
+    }
+    return signature_resolve_size(signature, candidate, *type, size);
+}
+
+size_t signature_set_handlers(file_type_t type, signature_validate_fn validate,
+                              signature_length_fn resolve_length, signature_footer_fn find_footer,
+                              signature_classify_fn classify) {
+    size_t updated = 0;
     for (size_t i = 0; i < signature_count; i++) {
-        if (signatures[i].type == type) {
-            return signatures[i].extension;
+        if (active_signatures[i].type == type) {
+            active_signatures[i].validate = validate;
+            active_signatures[i].resolve_length = resolve_length;
+            active_signatures[i].find_footer = find_footer;
+            active_signatures[i].classify = classify;
+            updated++;
+        }
+    }
+    return updated;
+}
+
+const file_type_info_t* signature_get_type_info(file_type_t type) {
+    for (size_t i = 0; i < type_count; i++) {
+        if (active_types[i].type == type) {
+            return &active_types[i];
         }
     }
+    return NULL;
+}
+
+file_type_t signature_find_type(const char* name) {
+    if (!name) {
+        return FILE_TYPE_UNKNOWN;
+    }
+    for (size_t i = 0; i < type_count; i++) {
+        if (strcmp(active_types[i].name, name) == 0) {
+            return active_types[i].type;
+        }
+    }
+    // 加载的数据库中没有的内置类型（如只由文本检测识别的 txt）
+    for (size_t i = 0; i < builtin_type_count; i++) {
+        if (strcmp(builtin_types[i].name, name) == 0) {
+            return builtin_types[i].type;
+        }
+    }
+    return FILE_TYPE_UNKNOWN;
+}
+
+const char* signature_get_extension(file_type_t type) {
+    if ((size_t)type < type_slots && type_extensions[type]) {
+        return type_extensions[type];
+    }
     
     if (type == FILE_TYPE_TXT) {
         return "txt";
@@ -105,10 +449,8 @@ const char* signature_get_extension(file_type_t type) {
 }
 
 const char* signature_get_description(file_type_t type) {
-    for (size_t i = 0; i < signature_count; i++) {
-        if (signatures[i].type == type) {
-            return signatures[i].description;
-        }
+    if ((size_t)type < type_slots && type_descriptions[type]) {
+        return type_descriptions[type];
     }
     
     if (type == FILE_TYPE_TXT) {
@@ -122,6 +464,6 @@ const file_signature_t* signature_get_all(size_t* count) {
     if (count) {
         *count = signature_count;
     }
-    return signatures;
+    return active_signatures;
 }
 
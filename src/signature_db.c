@@ -0,0 +1,845 @@
+#define _GNU_SOURCE
+#include "signature_db.h"
+#include "signature_matcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC "DASSIGDB"
+#define CACHE_BYTE_ORDER 0x01020304u
+#define CACHE_ALIGN 64
+#define ALIGN_UP(n) (((n) + CACHE_ALIGN - 1) & ~(uint64_t)(CACHE_ALIGN - 1))
+#define NO_STRING UINT32_MAX
+#define MAX_LINE 4096
+
+// 缓存头部，之后依次为类型记录、签名记录、字符串池和自动机映像，各自按 64 字节对齐
+typedef struct {
+    char magic[8];              // CACHE_MAGIC
+    uint32_t version;           // SIGNATURE_DB_CACHE_VERSION
+    uint32_t byte_order;        // CACHE_BYTE_ORDER，字节序不同的缓存不可用
+    uint64_t source_size;       // 定义文件大小
+    int64_t source_mtime_sec;   // 定义文件修改时间
+    int64_t source_mtime_nsec;
+    uint32_t type_count;        // 类型记录数量
+    uint32_t signature_count;   // 签名记录数量
+    uint64_t types_offset;
+    uint64_t signatures_offset;
+    uint64_t pool_offset;
+    uint64_t pool_size;
+    uint64_t matcher_offset;
+    uint64_t matcher_size;
+    uint64_t file_size;         // 缓存文件总大小
+} cache_header_t;
+
+// 类型记录（字符串和字节序列为字符串池中的偏移）
+typedef struct {
+    uint32_t type;
+    uint32_t name;
+    uint32_t footer;            // NO_STRING 表示没有
+    uint32_t footer_len;
+    uint32_t footer_extra;
+    int32_t length_field;
+    uint64_t search_start;
+    uint64_t max_search;
+    uint64_t default_size;
+} type_record_t;
+
+// 签名记录
+typedef struct {
+    uint32_t type;
+    uint32_t extension;
+    uint32_t magic;
+    uint32_t magic_len;
+    uint32_t offset;
+    uint32_t description;
+} signature_record_t;
+
+struct signature_db {
+    type_record_t* type_records;
+    size_t type_count;
+    size_t type_capacity;
+    signature_record_t* signature_records;
+    size_t signature_count;
+    size_t signature_capacity;
+    uint8_t* pool;              // 字符串池（解析时为堆内存，映射时指向缓存）
+    size_t pool_size;
+    size_t pool_capacity;
+    file_signature_t* signatures; // 解析后的签名（指针指向字符串池）
+    file_type_info_t* types;
+    signature_matcher_t* matcher;
+    void* map;                  // 映射的缓存（NULL 表示由定义文件编译）
+    size_t map_size;
+    struct stat source;         // 定义文件的状态（写缓存时记录）
+};
+
+// 解析过程中的状态
+typedef struct {
+    signature_db_t* db;
+    const char* path;
+    int line_no;
+    uint8_t* declared;          // 类型是否已由 type 行声明
+    size_t declared_capacity;
+    const file_type_info_t* builtin;
+    size_t builtin_count;
+} parser_t;
+
+static void* grow(void* data, size_t* capacity, size_t needed, size_t item) {
+    if (needed <= *capacity) {
+        return data;
+    }
+    size_t capacity_new = *capacity ? *capacity * 2 : 64;
+    while (capacity_new < needed) {
+        capacity_new *= 2;
+    }
+    void* grown = realloc(data, capacity_new * item);
+    if (grown) {
+        *capacity = capacity_new;
+    }
+    return grown;
+}
+
+// 向字符串池追加字节序列，返回偏移
+static uint32_t pool_add(signature_db_t* db, const void* data, size_t size) {
+    if (db->pool_size + size > UINT32_MAX - 1) {
+        return NO_STRING;
+    }
+    uint8_t* pool = (uint8_t*)grow(db->pool, &db->pool_capacity, db->pool_size + size, 1);
+    if (!pool) {
+        return NO_STRING;
+    }
+    db->pool = pool;
+    memcpy(&db->pool[db->pool_size], data, size);
+    uint32_t offset = (uint32_t)db->pool_size;
+    db->pool_size += size;
+    return offset;
+}
+
+static uint32_t pool_add_string(signature_db_t* db, const char* str) {
+    return pool_add(db, str, strlen(str) + 1);
+}
+
+static int parse_error(const parser_t* p, const char* message, const char* token) {
+    fprintf(stderr, "Error: %s:%d: %s%s%s\n", p->path, p->line_no, message,
+            token ? ": " : "", token ? token : "");
+    return -1;
+}
+
+// 取下一个以空白分隔的词（引号内的空白和 \" 不分隔），返回 NULL 表示行结束
+static char* next_token(char** cursor) {
+    char* s = *cursor;
+    while (*s && isspace((unsigned char)*s)) {
+        s++;
+    }
+    if (!*s || *s == '#') {
+        *cursor = s;
+        return NULL;
+    }
+
+    char* start = s;
+    int quoted = 0;
+    for (; *s; s++) {
+        if (quoted && *s == '\\' && s[1]) {
+            s++;
+        } else if (*s == '"') {
+            quoted = !quoted;
+        } else if (!quoted && isspace((unsigned char)*s)) {
+            break;
+        }
+    }
+    if (*s) {
+        *s++ = '\0';
+    }
+    *cursor = s;
+    return start;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 解析字节序列：十六进制（如 FFD8FF）或带引号的字符串
+static int parse_bytes(const char* text, uint8_t* out, size_t* len) {
+    size_t n = 0;
+    if (text[0] == '"') {
+        size_t end = strlen(text);
+        if (end < 2 || text[end - 1] != '"') {
+            return -1;
+        }
+        for (size_t i = 1; i < end - 1; i++) {
+            int c = (unsigned char)text[i];
+            if (c == '\\') {
+                i++;
+                if (i >= end - 1) {
+                    return -1;
+                }
+                switch (text[i]) {
+                    case 'x': {
+                        int hi = hex_value(text[i + 1]);
+                        int lo = hi < 0 ? -1 : hex_value(text[i + 2]);
+                        if (lo < 0 || i + 2 >= end - 1) {
+                            return -1;
+                        }
+                        c = hi * 16 + lo;
+                        i += 2;
+                        break;
+                    }
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case '0': c = 0; break;
+                    case '\\': c = '\\'; break;
+                    case '"': c = '"'; break;
+                    default: return -1;
+                }
+            }
+            if (n >= SIGNATURE_DB_MAX_PATTERN) {
+                return -1;
+            }
+            out[n++] = (uint8_t)c;
+        }
+    } else {
+        size_t digits = strlen(text);
+        if (digits == 0 || digits % 2 != 0 || digits / 2 > SIGNATURE_DB_MAX_PATTERN) {
+            return -1;
+        }
+        for (size_t i = 0; i < digits; i += 2) {
+            int hi = hex_value(text[i]);
+            int lo = hex_value(text[i + 1]);
+            if (hi < 0 || lo < 0) {
+                return -1;
+            }
+            out[n++] = (uint8_t)(hi * 16 + lo);
+        }
+    }
+    *len = n;
+    return n > 0 ? 0 : -1;
+}
+
+// 解析带引号的字符串（不允许 \0）
+static int parse_string(const char* text, char* out, size_t out_size) {
+    uint8_t bytes[SIGNATURE_DB_MAX_PATTERN];
+    size_t len;
+    if (text[0] != '"' || parse_bytes(text, bytes, &len) < 0 || len >= out_size ||
+        memchr(bytes, 0, len)) {
+        return -1;
+    }
+    memcpy(out, bytes, len);
+    out[len] = '\0';
+    return 0;
+}
+
+// 解析大小（十进制或 0x 十六进制，可带 K/M/G 后缀）
+static int parse_size(const char* text, uint64_t* value) {
+    char* end;
+    errno = 0;
+    unsigned long long v = strtoull(text, &end, 0);
+    if (end == text || errno != 0 || text[0] == '-') {
+        return -1;
+    }
+    uint64_t unit = 1;
+    switch (*end) {
+        case 'K': case 'k': unit = 1024ULL; end++; break;
+        case 'M': case 'm': unit = 1024ULL * 1024; end++; break;
+        case 'G': case 'g': unit = 1024ULL * 1024 * 1024; end++; break;
+        default: break;
+    }
+    if (*end != '\0' || (v && unit > UINT64_MAX / v)) {
+        return -1;
+    }
+    *value = (uint64_t)v * unit;
+    return 0;
+}
+
+// 名称只允许小写字母、数字、'_' 和 '-'
+static int valid_name(const char* name) {
+    if (!name[0] || strlen(name) > 32) {
+        return 0;
+    }
+    for (const char* c = name; *c; c++) {
+        if (!islower((unsigned char)*c) && !isdigit((unsigned char)*c) && *c != '_' && *c != '-') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 查找或新建类型记录，返回下标
+static long find_type(parser_t* p, const char* name) {
+    signature_db_t* db = p->db;
+    for (size_t i = 0; i < db->type_count; i++) {
+        if (strcmp((const char*)&db->pool[db->type_records[i].name], name) == 0) {
+            return (long)i;
+        }
+    }
+
+    // 内置类型名使用内置编号，其他类型依次编号
+    uint32_t type = FILE_TYPE_MAX;
+    for (size_t i = 0; i < db->type_count; i++) {
+        if (db->type_records[i].type >= type) {
+            type = db->type_records[i].type + 1;
+        }
+    }
+    for (size_t i = 0; i < p->builtin_count; i++) {
+        if (p->builtin[i].name && strcmp(p->builtin[i].name, name) == 0) {
+            type = (uint32_t)p->builtin[i].type;
+            break;
+        }
+    }
+
+    type_record_t* records = (type_record_t*)grow(db->type_records, &db->type_capacity,
+                                                  db->type_count + 1, sizeof(type_record_t));
+    if (!records) {
+        return -1;
+    }
+    db->type_records = records;
+    uint8_t* declared = (uint8_t*)grow(p->declared, &p->declared_capacity, db->type_count + 1, 1);
+    if (!declared) {
+        return -1;
+    }
+    p->declared = declared;
+
+    uint32_t name_offset = pool_add_string(db, name);
+    if (name_offset == NO_STRING) {
+        return -1;
+    }
+    type_record_t* r = &db->type_records[db->type_count];
+    memset(r, 0, sizeof(*r));
+    r->type = type;
+    r->name = name_offset;
+    r->footer = NO_STRING;
+    r->length_field = -1;
+    r->default_size = SIGNATURE_DEFAULT_FILE_SIZE;
+    p->declared[db->type_count] = 0;
+    return (long)db->type_count++;
+}
+
+// type <名称> [key=value ...]
+static int parse_type_line(parser_t* p, char* cursor) {
+    char* name = next_token(&cursor);
+    if (!name || !valid_name(name)) {
+        return parse_error(p, "Invalid type name", name);
+    }
+
+    long index = find_type(p, name);
+    if (index < 0) {
+        return parse_error(p, "Memory allocation failed", NULL);
+    }
+    if (p->declared[index]) {
+        return parse_error(p, "Duplicate type", name);
+    }
+    p->declared[index] = 1;
+
+    char* token;
+    while ((token = next_token(&cursor)) != NULL) {
+        char* value = strchr(token, '=');
+        if (!value) {
+            return parse_error(p, "Expected key=value", token);
+        }
+        *value++ = '\0';
+
+        type_record_t* r = &p->db->type_records[index];
+        uint64_t number = 0;
+        if (strcmp(token, "footer") == 0) {
+            uint8_t bytes[SIGNATURE_DB_MAX_PATTERN];
+            size_t len;
+            if (parse_bytes(value, bytes, &len) < 0) {
+                return parse_error(p, "Invalid footer", value);
+            }
+            uint32_t offset = pool_add(p->db, bytes, len);
+            if (offset == NO_STRING) {
+                return parse_error(p, "Memory allocation failed", NULL);
+            }
+            r = &p->db->type_records[index];
+            r->footer = offset;
+            r->footer_len = (uint32_t)len;
+        } else if (parse_size(value, &number) < 0) {
+            return parse_error(p, "Invalid number", value);
+        } else if (strcmp(token, "extra") == 0 && number <= SIGNATURE_DB_MAX_PATTERN) {
+            r->footer_extra = (uint32_t)number;
+        } else if (strcmp(token, "length16") == 0 && number <= SIGNATURE_DB_MAX_PATTERN) {
+            r->length_field = (int32_t)number;
+        } else if (strcmp(token, "start") == 0) {
+            r->search_start = number;
+        } else if (strcmp(token, "max") == 0) {
+            r->max_search = number;
+        } else if (strcmp(token, "default") == 0 && number > 0) {
+            r->default_size = number;
+        } else {
+            return parse_error(p, "Invalid type attribute", token);
+        }
+    }
+    return 0;
+}
+
+// sig <类型名> <扩展名> <魔数> [offset=<字节>] ["描述"]
+static int parse_sig_line(parser_t* p, char* cursor) {
+    char* name = next_token(&cursor);
+    char* extension = next_token(&cursor);
+    char* magic_text = next_token(&cursor);
+    if (!name || !valid_name(name)) {
+        return parse_error(p, "Invalid type name", name);
+    }
+    if (!extension || !valid_name(extension)) {
+        return parse_error(p, "Invalid extension", extension);
+    }
+    uint8_t magic[SIGNATURE_DB_MAX_PATTERN];
+    size_t magic_len;
+    if (!magic_text || parse_bytes(magic_text, magic, &magic_len) < 0) {
+        return parse_error(p, "Invalid magic", magic_text);
+    }
+
+    uint64_t offset = 0;
+    char description[256] = "";
+    char* token;
+    while ((token = next_token(&cursor)) != NULL) {
+        if (strncmp(token, "offset=", 7) == 0) {
+            if (parse_size(token + 7, &offset) < 0 || offset > SIGNATURE_DB_MAX_OFFSET) {
+                return parse_error(p, "Invalid offset", token + 7);
+            }
+        } else if (token[0] == '"' && !description[0]) {
+            if (parse_string(token, description, sizeof(description)) < 0) {
+                return parse_error(p, "Invalid description", token);
+            }
+        } else {
+            return parse_error(p, "Unexpected token", token);
+        }
+    }
+
+    long index = find_type(p, name);
+    if (index < 0) {
+        return parse_error(p, "Memory allocation failed", NULL);
+    }
+
+    signature_db_t* db = p->db;
+    signature_record_t* records = (signature_record_t*)grow(
+        db->signature_records, &db->signature_capacity, db->signature_count + 1,
+        sizeof(signature_record_t));
+    if (!records) {
+        return parse_error(p, "Memory allocation failed", NULL);
+    }
+    db->signature_records = records;
+
+    signature_record_t r;
+    r.type = db->type_records[index].type;
+    r.extension = pool_add_string(db, extension);
+    r.magic = pool_add(db, magic, magic_len);
+    r.magic_len = (uint32_t)magic_len;
+    r.offset = (uint32_t)offset;
+    // 没有描述时使用类型名
+    r.description = description[0] ? pool_add_string(db, description) : db->type_records[index].name;
+    if (r.extension == NO_STRING || r.magic == NO_STRING || r.description == NO_STRING) {
+        return parse_error(p, "Memory allocation failed", NULL);
+    }
+    db->signature_records[db->signature_count++] = r;
+    return 0;
+}
+
+// 由记录生成签名和类型信息数组（指针指向字符串池），并编译或映射匹配器
+static int resolve(signature_db_t* db, const void* image, size_t image_size) {
+    db->types = (file_type_info_t*)calloc(db->type_count ? db->type_count : 1,
+                                          sizeof(file_type_info_t));
+    db->signatures = (file_signature_t*)calloc(db->signature_count, sizeof(file_signature_t));
+    if (!db->types || !db->signatures) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < db->type_count; i++) {
+        const type_record_t* r = &db->type_records[i];
+        file_type_info_t* t = &db->types[i];
+        t->type = (file_type_t)r->type;
+        t->name = (const char*)&db->pool[r->name];
+        t->footer = r->footer == NO_STRING ? NULL : &db->pool[r->footer];
+        t->footer_len = t->footer ? r->footer_len : 0;
+        t->footer_extra = r->footer_extra;
+        t->length_field = r->length_field;
+        t->search_start = r->search_start;
+        t->max_search = r->max_search;
+        t->default_size = r->default_size;
+    }
+
+    for (size_t i = 0; i < db->signature_count; i++) {
+        const signature_record_t* r = &db->signature_records[i];
+        file_signature_t* s = &db->signatures[i];
+        s->type = (file_type_t)r->type;
+        s->extension = (const char*)&db->pool[r->extension];
+        s->magic = &db->pool[r->magic];
+        s->magic_len = r->magic_len;
+        s->offset = r->offset;
+        s->description = (const char*)&db->pool[r->description];
+    }
+
+    if (image) {
+        db->matcher = signature_matcher_from_image(image, image_size, db->signatures,
+                                                   db->signature_count);
+    } else {
+        db->matcher = signature_matcher_create(db->signatures, db->signature_count);
+    }
+    return db->matcher ? 0 : -1;
+}
+
+// 没有 type 行声明的内置类型沿用内置的大小规则
+static int inherit_builtin_rules(parser_t* p) {
+    signature_db_t* db = p->db;
+    for (size_t i = 0; i < db->type_count; i++) {
+        if (p->declared[i]) {
+            continue;
+        }
+        const file_type_info_t* info = NULL;
+        for (size_t k = 0; k < p->builtin_count; k++) {
+            if ((uint32_t)p->builtin[k].type == db->type_records[i].type) {
+                info = &p->builtin[k];
+                break;
+            }
+        }
+        if (!info) {
+            continue;
+        }
+
+        uint32_t footer = NO_STRING;
+        if (info->footer) {
+            footer = pool_add(db, info->footer, info->footer_len);
+            if (footer == NO_STRING) {
+                return -1;
+            }
+        }
+        type_record_t* r = &db->type_records[i];
+        r->footer = footer;
+        r->footer_len = (uint32_t)info->footer_len;
+        r->footer_extra = (uint32_t)info->footer_extra;
+        r->length_field = info->length_field;
+        r->search_start = info->search_start;
+        r->max_search = info->max_search;
+        r->default_size = info->default_size;
+    }
+    return 0;
+}
+
+static signature_db_t* parse_file(const char* path, const file_type_info_t* builtin,
+                                  size_t builtin_count) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open signature file '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    signature_db_t* db = (signature_db_t*)calloc(1, sizeof(signature_db_t));
+    if (!db) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fclose(fp);
+        return NULL;
+    }
+    if (fstat(fileno(fp), &db->source) < 0) {
+        memset(&db->source, 0, sizeof(db->source));
+    }
+
+    parser_t p = { db, path, 0, NULL, 0, builtin, builtin_count };
+    char line[MAX_LINE];
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), fp)) {
+        p.line_no++;
+        if (!strchr(line, '\n') && !feof(fp)) {
+            status = parse_error(&p, "Line too long", NULL);
+            break;
+        }
+
+        char* cursor = line;
+        char* keyword = next_token(&cursor);
+        if (!keyword) {
+            continue;
+        }
+        if (strcmp(keyword, "type") == 0) {
+            status = parse_type_line(&p, cursor);
+        } else if (strcmp(keyword, "sig") == 0) {
+            status = parse_sig_line(&p, cursor);
+        } else {
+            status = parse_error(&p, "Unknown record", keyword);
+        }
+    }
+    fclose(fp);
+    if (status == 0 && inherit_builtin_rules(&p) < 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        status = -1;
+    }
+    free(p.declared);
+
+    if (status == 0 && db->signature_count == 0) {
+        fprintf(stderr, "Error: %s: No signatures defined\n", path);
+        status = -1;
+    }
+    if (status < 0 || resolve(db, NULL, 0) < 0) {
+        signature_db_destroy(db);
+        return NULL;
+    }
+    return db;
+}
+
+// 检查字符串池中的偏移（字符串必须以 '\0' 结束在池内）
+static int valid_pool_range(const signature_db_t* db, uint32_t offset, uint64_t len) {
+    return offset != NO_STRING && (uint64_t)offset + len <= db->pool_size;
+}
+
+// 映射并检查编译缓存；缓存不存在、过期或无效时返回 NULL（verbose 时报告原因）
+static signature_db_t* map_cache(const char* cache_path, const struct stat* source, int verbose) {
+    int fd = open(cache_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (verbose || errno != ENOENT) {
+            fprintf(stderr, "Error: Cannot open signature cache '%s': %s\n", cache_path, strerror(errno));
+        }
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (uint64_t)st.st_size < sizeof(cache_header_t)) {
+        if (verbose) {
+            fprintf(stderr, "Error: Invalid signature cache '%s'\n", cache_path);
+        }
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map signature cache '%s': %s\n", cache_path, strerror(errno));
+        return NULL;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    const cache_header_t* h = (const cache_header_t*)map;
+    uint64_t size = (uint64_t)st.st_size;
+    const char* reason = NULL;
+
+    if (memcmp(h->magic, CACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->byte_order != CACHE_BYTE_ORDER || h->file_size != size) {
+        reason = "not a signature cache";
+    } else if (h->version != SIGNATURE_DB_CACHE_VERSION) {
+        reason = "cache version mismatch";
+    } else if (source && (h->source_size != (uint64_t)source->st_size ||
+                          h->source_mtime_sec != (int64_t)source->st_mtim.tv_sec ||
+                          h->source_mtime_nsec != (int64_t)source->st_mtim.tv_nsec)) {
+        reason = "signature file changed";
+    } else if (h->signature_count == 0 ||
+               h->types_offset + (uint64_t)h->type_count * sizeof(type_record_t) > size ||
+               h->signatures_offset + (uint64_t)h->signature_count * sizeof(signature_record_t) > size ||
+               h->pool_offset + h->pool_size > size || h->pool_size == 0 ||
+               h->matcher_offset + h->matcher_size > size ||
+               h->types_offset % CACHE_ALIGN || h->signatures_offset % CACHE_ALIGN ||
+               h->matcher_offset % CACHE_ALIGN || base[h->pool_offset + h->pool_size - 1] != 0) {
+        reason = "corrupt cache";
+    }
+
+    if (reason) {
+        if (verbose) {
+            fprintf(stderr, "Error: Invalid signature cache '%s': %s\n", cache_path, reason);
+        }
+        munmap(map, (size_t)size);
+        return NULL;
+    }
+
+    signature_db_t* db = (signature_db_t*)calloc(1, sizeof(signature_db_t));
+    if (!db) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        munmap(map, (size_t)size);
+        return NULL;
+    }
+    db->map = map;
+    db->map_size = (size_t)size;
+    db->pool = (uint8_t*)(base + h->pool_offset);
+    db->pool_size = h->pool_size;
+    db->type_count = h->type_count;
+    db->signature_count = h->signature_count;
+    db->source.st_size = (off_t)h->source_size;
+    db->source.st_mtim.tv_sec = (time_t)h->source_mtime_sec;
+    db->source.st_mtim.tv_nsec = (long)h->source_mtime_nsec;
+
+    // 记录复制出来，字符串池和自动机映像直接使用映射
+    db->type_records = (type_record_t*)malloc((db->type_count ? db->type_count : 1) * sizeof(type_record_t));
+    db->signature_records = (signature_record_t*)malloc(db->signature_count * sizeof(signature_record_t));
+    if (!db->type_records || !db->signature_records) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        signature_db_destroy(db);
+        return NULL;
+    }
+    memcpy(db->type_records, base + h->types_offset, db->type_count * sizeof(type_record_t));
+    memcpy(db->signature_records, base + h->signatures_offset,
+           db->signature_count * sizeof(signature_record_t));
+
+    int valid = 1;
+    for (size_t i = 0; valid && i < db->type_count; i++) {
+        const type_record_t* r = &db->type_records[i];
+        valid = valid_pool_range(db, r->name, 1) &&
+                (r->footer == NO_STRING || (r->footer_len <= SIGNATURE_DB_MAX_PATTERN &&
+                                            valid_pool_range(db, r->footer, r->footer_len))) &&
+                r->footer_extra <= SIGNATURE_DB_MAX_PATTERN &&
+                r->length_field <= SIGNATURE_DB_MAX_PATTERN;
+    }
+    for (size_t i = 0; valid && i < db->signature_count; i++) {
+        const signature_record_t* r = &db->signature_records[i];
+        valid = valid_pool_range(db, r->extension, 1) && valid_pool_range(db, r->description, 1) &&
+                r->magic_len > 0 && r->magic_len <= SIGNATURE_DB_MAX_PATTERN &&
+                r->offset <= SIGNATURE_DB_MAX_OFFSET && valid_pool_range(db, r->magic, r->magic_len);
+        int known = 0;
+        for (size_t k = 0; !known && k < db->type_count; k++) {
+            known = (db->type_records[k].type == r->type);
+        }
+        valid = valid && known;
+    }
+    if (!valid || resolve(db, base + h->matcher_offset, (size_t)h->matcher_size) < 0) {
+        if (verbose) {
+            fprintf(stderr, "Error: Invalid signature cache '%s': corrupt cache\n", cache_path);
+        }
+        signature_db_destroy(db);
+        return NULL;
+    }
+    return db;
+}
+
+signature_db_t* signature_db_open(const char* path, const char* cache_path,
+                                  const file_type_info_t* builtin, size_t builtin_count) {
+    if (!path && !cache_path) {
+        return NULL;
+    }
+
+    // 只有缓存：缓存必须有效
+    if (!path) {
+        return map_cache(cache_path, NULL, 1);
+    }
+
+    if (cache_path) {
+        struct stat source;
+        if (stat(path, &source) < 0) {
+            fprintf(stderr, "Error: Cannot open signature file '%s': %s\n", path, strerror(errno));
+            return NULL;
+        }
+        signature_db_t* db = map_cache(cache_path, &source, 0);
+        if (db) {
+            return db;
+        }
+    }
+
+    signature_db_t* db = parse_file(path, builtin, builtin_count);
+    if (db && cache_path && signature_db_write_cache(db, cache_path) < 0) {
+        fprintf(stderr, "Warning: Signature cache not written, continuing without it\n");
+    }
+    return db;
+}
+
+// 写出一段数据并补齐到 64 字节
+static int write_padded(FILE* fp, const void* data, size_t size) {
+    static const uint8_t zeros[CACHE_ALIGN];
+    if (size > 0 && fwrite(data, 1, size, fp) != size) {
+        return -1;
+    }
+    size_t pad = (size_t)(ALIGN_UP(size) - size);
+    if (pad > 0 && fwrite(zeros, 1, pad, fp) != pad) {
+        return -1;
+    }
+    return 0;
+}
+
+int signature_db_write_cache(const signature_db_t* db, const char* cache_path) {
+    if (!db || !cache_path || !db->matcher) {
+        return -1;
+    }
+
+    cache_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CACHE_MAGIC, sizeof(h.magic));
+    h.version = SIGNATURE_DB_CACHE_VERSION;
+    h.byte_order = CACHE_BYTE_ORDER;
+    h.source_size = (uint64_t)db->source.st_size;
+    h.source_mtime_sec = (int64_t)db->source.st_mtim.tv_sec;
+    h.source_mtime_nsec = (int64_t)db->source.st_mtim.tv_nsec;
+    h.type_count = (uint32_t)db->type_count;
+    h.signature_count = (uint32_t)db->signature_count;
+    h.types_offset = ALIGN_UP(sizeof(h));
+    h.signatures_offset = h.types_offset + ALIGN_UP(db->type_count * sizeof(type_record_t));
+    h.pool_offset = h.signatures_offset + ALIGN_UP(db->signature_count * sizeof(signature_record_t));
+    h.pool_size = db->pool_size;
+    h.matcher_offset = h.pool_offset + ALIGN_UP(db->pool_size);
+    h.matcher_size = signature_matcher_image_size(db->matcher);
+    h.file_size = h.matcher_offset + h.matcher_size;
+
+    size_t len = strlen(cache_path);
+    char* tmp_path = (char*)malloc(len + 5);
+    if (!tmp_path) {
+        return -1;
+    }
+    snprintf(tmp_path, len + 5, "%s.tmp", cache_path);
+
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot write signature cache '%s': %s\n", tmp_path, strerror(errno));
+        free(tmp_path);
+        return -1;
+    }
+
+    int ok = write_padded(fp, &h, sizeof(h)) == 0 &&
+             write_padded(fp, db->type_records, db->type_count * sizeof(type_record_t)) == 0 &&
+             write_padded(fp, db->signature_records,
+                          db->signature_count * sizeof(signature_record_t)) == 0 &&
+             write_padded(fp, db->pool, db->pool_size) == 0 &&
+             signature_matcher_write_image(db->matcher, fp) == 0;
+    ok = (fflush(fp) == 0) && ok;
+    ok = (fclose(fp) == 0) && ok;
+    if (ok && rename(tmp_path, cache_path) < 0) {
+        fprintf(stderr, "Error: Cannot replace signature cache '%s': %s\n", cache_path, strerror(errno));
+        ok = 0;
+    }
+    if (!ok) {
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    return ok ? 0 : -1;
+}
+
+void signature_db_destroy(signature_db_t* db) {
+    if (!db) {
+        return;
+    }
+
+    signature_matcher_destroy(db->matcher);
+    free(db->signatures);
+    free(db->types);
+    free(db->type_records);
+    free(db->signature_records);
+    if (db->map) {
+        munmap(db->map, db->map_size);
+    } else {
+        free(db->pool);
+    }
+    free(db);
+}
+
+file_signature_t* signature_db_signatures(signature_db_t* db, size_t* count) {
+    if (count) {
+        *count = db ? db->signature_count : 0;
+    }
+    return db ? db->signatures : NULL;
+}
+
+const file_type_info_t* signature_db_types(const signature_db_t* db, size_t* count) {
+    if (count) {
+        *count = db ? db->type_count : 0;
+    }
+    return db ? db->types : NULL;
+}
+
+const signature_matcher_t* signature_db_matcher(const signature_db_t* db) {
+    return db ? db->matcher : NULL;
+}
+
+int signature_db_from_cache(const signature_db_t* db) {
+    return db && db->map != NULL;
+}
@@ -0,0 +1,422 @@
+#include "signature_formats.h"
+#include <string.h>
+
+#define WINDOW_SIZE 4096
+
+// 候选文件的顺序读取窗口：文件头之内直接使用 header，之外按 4KB 读取
+typedef struct {
+    const signature_candidate_t* candidate;
+    uint8_t window[WINDOW_SIZE];
+    uint64_t base;            // 窗口起始偏移
+    size_t len;               // 窗口中有效的字节数
+    uint64_t budget;          // 剩余可读取的字节数
+    uint64_t end;             // 数据结束位置（读到不足一个窗口时确定，设备末尾）
+} reader_t;
+
+static void reader_init(reader_t* r, const signature_candidate_t* candidate) {
+    r->candidate = candidate;
+    r->base = 0;
+    r->len = 0;
+    r->budget = UINT64_MAX;
+    r->end = UINT64_MAX;
+}
+
+// 读取 [pos, pos + size)，数据不完整时返回 NULL（size 不超过窗口大小）
+// 文件中的长度字段可能指向数据末尾之外，已知末尾之后的范围不再读取
+static const uint8_t* reader_get(reader_t* r, uint64_t pos, size_t size) {
+    const signature_candidate_t* c = r->candidate;
+    if (pos < c->header_len && size <= c->header_len - pos) {
+        return &c->header[pos];
+    }
+    if (pos >= r->base && pos - r->base < r->len && size <= r->len - (pos - r->base)) {
+        return &r->window[pos - r->base];
+    }
+    if (!c->read || size > WINDOW_SIZE || r->budget < WINDOW_SIZE ||
+        pos > r->end || size > r->end - pos) {
+        return NULL;
+    }
+
+    r->budget -= WINDOW_SIZE;
+    int64_t n = c->read(c->source, pos, r->window, WINDOW_SIZE);
+    if (n < 0) {
+        r->len = 0;
+        return NULL;
+    }
+    r->base = pos;
+    r->len = (size_t)n;
+    if (r->len < WINDOW_SIZE) {
+        r->end = pos + r->len;
+    }
+    return size <= r->len ? r->window : NULL;
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint64_t be64(const uint8_t* p) {
+    return ((uint64_t)be32(p) << 32) | be32(p + 4);
+}
+
+int signature_bmp_length(const signature_candidate_t* candidate, uint64_t* length) {
+    // BITMAPFILEHEADER（14 字节）+ DIB 头大小字段
+    if (candidate->header_len < 18 || memcmp(candidate->header, "BM", 2) != 0) {
+        return -1;
+    }
+    const uint8_t* h = candidate->header;
+    uint32_t file_size = le32(h + 2);
+    uint32_t data_offset = le32(h + 10);
+    uint32_t dib_size = le32(h + 14);
+
+    // DIB 头只有这几种长度（BITMAPCOREHEADER 到 BITMAPV5HEADER）
+    if (dib_size != 12 && dib_size != 40 && dib_size != 52 && dib_size != 56 &&
+        dib_size != 64 && dib_size != 108 && dib_size != 124) {
+        return -1;
+    }
+    if (data_offset < 14 + dib_size || file_size < data_offset) {
+        return -1;
+    }
+    *length = file_size;
+    return 0;
+}
+
+int signature_riff_length(const signature_candidate_t* candidate, uint64_t* length) {
+    if (candidate->header_len < 12 || memcmp(candidate->header, "RIFF", 4) != 0) {
+        return -1;
+    }
+    uint32_t size = le32(candidate->header + 4);
+    // 块大小至少包含 4 字节的格式标识
+    if (size < 4) {
+        return -1;
+    }
+    *length = (uint64_t)size + 8 + (size & 1);
+    return 0;
+}
+
+// 已知的顶层盒子类型（ISO/IEC 14496-12 和 QuickTime）
+static int is_top_level_box(const uint8_t* type) {
+    static const char* const boxes[] = {
+        "ftyp", "moov", "mdat", "free", "skip", "wide", "uuid", "pdin", "moof", "mfra",
+        "meta", "styp", "sidx", "ssix", "prft", "emsg", "pnot", "junk", "PICT", "jP  ",
+    };
+    for (size_t i = 0; i < sizeof(boxes) / sizeof(boxes[0]); i++) {
+        if (memcmp(type, boxes[i], 4) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int signature_isobmff_length(const signature_candidate_t* candidate, uint64_t* length) {
+    reader_t r;
+    reader_init(&r, candidate);
+
+    // 每个盒子只需读取 16 字节的盒子头，按盒子大小跳到下一个
+    uint64_t pos = 0;
+    for (int step = 0; step < SIGNATURE_FORMATS_MAX_STEPS; step++) {
+        const uint8_t* box = reader_get(&r, pos, 16);
+        if (!box) {
+            // 最后一个盒子可能正好结束在设备末尾，盒子头不足 16 字节时再试 8 字节
+            box = reader_get(&r, pos, 8);
+            if (!box || be32(box) == 1) {
+                break;
+            }
+        }
+        if (!is_top_level_box(box + 4)) {
+            break;
+        }
+
+        uint64_t size = be32(box);
+        if (size == 1) {
+            size = be64(box + 8);   // 64 位大小
+            if (size < 16) {
+                break;
+            }
+        } else if (size == 0) {
+            break;                  // 延续到文件末尾，长度未知
+        } else if (size < 8) {
+            break;
+        }
+        if (pos + size < pos) {
+            break;
+        }
+        pos += size;
+    }
+
+    if (pos == 0) {
+        return -1;
+    }
+    *length = pos;
+    return 0;
+}
+
+int signature_png_length(const signature_candidate_t* candidate, uint64_t* length) {
+    reader_t r;
+    reader_init(&r, candidate);
+
+    // 数据块：长度（4）+ 类型（4）+ 数据 + CRC（4）
+    uint64_t pos = 8;
+    for (int step = 0; step < SIGNATURE_FORMATS_MAX_STEPS; step++) {
+        const uint8_t* chunk = reader_get(&r, pos, 8);
+        if (!chunk) {
+            return -1;
+        }
+        uint32_t size = be32(chunk);
+        if (size > 0x7FFFFFFFu) {
+            return -1;
+        }
+        for (int i = 4; i < 8; i++) {
+            uint8_t c = chunk[i];
+            if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
+                return -1;
+            }
+        }
+        // 第一个数据块必须是 IHDR
+        if (pos == 8 && memcmp(chunk + 4, "IHDR", 4) != 0) {
+            return -1;
+        }
+
+        pos += 12 + (uint64_t)size;
+        if (memcmp(chunk + 4, "IEND", 4) == 0) {
+            *length = pos;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// 跳过数据子块序列（长度字节 + 数据，长度为 0 结束），返回序列之后的位置，失败返回 0
+static uint64_t skip_sub_blocks(reader_t* r, uint64_t pos) {
+    for (int step = 0; step < SIGNATURE_FORMATS_MAX_STEPS * 16; step++) {
+        const uint8_t* size = reader_get(r, pos, 1);
+        if (!size) {
+            return 0;
+        }
+        pos += 1 + (uint64_t)size[0];
+        if (size[0] == 0) {
+            return pos;
+        }
+    }
+    return 0;
+}
+
+int signature_gif_length(const signature_candidate_t* candidate, uint64_t* length) {
+    if (candidate->header_len < 13) {
+        return -1;
+    }
+    reader_t r;
+    reader_init(&r, candidate);
+
+    // 文件头（6）+ 逻辑屏幕描述符（7），之后可能是全局颜色表
+    uint8_t flags = candidate->header[10];
+    uint64_t pos = 13;
+    if (flags & 0x80) {
+        pos += 3ULL << ((flags & 0x07) + 1);
+    }
+
+    for (int step = 0; step < SIGNATURE_FORMATS_MAX_STEPS; step++) {
+        const uint8_t* block = reader_get(&r, pos, 1);
+        if (!block) {
+            return -1;
+        }
+
+        switch (block[0]) {
+            case 0x3B:              // 结尾标记
+                *length = pos + 1;
+                return 0;
+
+            case 0x21:              // 扩展块：标签 + 数据子块
+                pos = skip_sub_blocks(&r, pos + 2);
+                break;
+
+            case 0x2C: {            // 图像描述符（10）+ 局部颜色表 + LZW 最小码长 + 数据子块
+                const uint8_t* image = reader_get(&r, pos, 10);
+                if (!image) {
+                    return -1;
+                }
+                uint8_t image_flags = image[9];
+                pos += 10;
+                if (image_flags & 0x80) {
+                    pos += 3ULL << ((image_flags & 0x07) + 1);
+                }
+                pos = skip_sub_blocks(&r, pos + 1);
+                break;
+            }
+
+            default:
+                return -1;
+        }
+        if (pos == 0) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+// OOXML 部件所在的目录决定文档类型
+static file_type_t ooxml_type(const uint8_t* name, size_t len) {
+    if (len > 5 && memcmp(name, "word/", 5) == 0) {
+        return FILE_TYPE_DOCX;
+    }
+    if (len > 3 && memcmp(name, "xl/", 3) == 0) {
+        return FILE_TYPE_XLSX;
+    }
+    if (len > 4 && memcmp(name, "ppt/", 4) == 0) {
+        return FILE_TYPE_PPTX;
+    }
+    return FILE_TYPE_UNKNOWN;
+}
+
+// 从 pos 开始查找下一个本地文件头，找不到返回 0
+static uint64_t next_local_header(reader_t* r, uint64_t pos) {
+    for (;;) {
+        const uint8_t* p = reader_get(r, pos, 4);
+        if (!p) {
+            return 0;
+        }
+        if (memcmp(p, "PK\x03\x04", 4) == 0) {
+            return pos;
+        }
+        pos++;
+    }
+}
+
+file_type_t signature_zip_classify(const signature_candidate_t* candidate, file_type_t type) {
+    (void)type;
+    reader_t r;
+    reader_init(&r, candidate);
+    r.budget = SIGNATURE_FORMATS_CLASSIFY_BUDGET;
+
+    // 本地文件头：签名（4）... 标志（6）... 压缩大小（18）... 文件名长度（26）、扩展字段长度（28）、文件名（30）
+    uint64_t pos = 0;
+    for (int entry = 0; entry < SIGNATURE_FORMATS_CLASSIFY_ENTRIES; entry++) {
+        const uint8_t* h = reader_get(&r, pos, 30);
+        if (!h || memcmp(h, "PK\x03\x04", 4) != 0) {
+            break;
+        }
+        uint16_t flags = le16(h + 6);
+        uint32_t compressed = le32(h + 18);
+        uint16_t name_len = le16(h + 26);
+        uint16_t extra_len = le16(h + 28);
+
+        const uint8_t* name = reader_get(&r, pos + 30, name_len);
+        if (!name) {
+            break;
+        }
+        file_type_t found = ooxml_type(name, name_len);
+        if (found != FILE_TYPE_UNKNOWN) {
+            return found;
+        }
+
+        uint64_t data = pos + 30 + name_len + extra_len;
+        if ((flags & 0x08) || compressed == 0xFFFFFFFFu) {
+            // 压缩大小在数据描述符或 ZIP64 扩展字段中，直接查找下一个本地文件头
+            pos = next_local_header(&r, data);
+            if (pos == 0) {
+                break;
+            }
+        } else {
+            pos = data + compressed;
+        }
+    }
+    return FILE_TYPE_ZIP;
+}
+
+// 复合文档扇区的偏移（文件头占第一个扇区的位置）
+static uint64_t cfb_sector(uint32_t sector, unsigned shift) {
+    return ((uint64_t)sector + 1) << shift;
+}
+
+// 目录项名称（UTF-16LE）与 ASCII 名称比较
+static int cfb_name_equals(const uint8_t* entry, const char* name) {
+    size_t len = strlen(name);
+    uint16_t name_bytes = le16(entry + 0x40);
+    if (name_bytes != (len + 1) * 2) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (entry[i * 2] != (uint8_t)name[i] || entry[i * 2 + 1] != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+file_type_t signature_ole_classify(const signature_candidate_t* candidate, file_type_t type) {
+    // 复合文档文件头：扇区大小指数（0x1E）、第一个目录扇区（0x30）、前 109 个 FAT 扇区（0x4C）
+    if (candidate->header_len < 512) {
+        return type;
+    }
+    const uint8_t* h = candidate->header;
+    unsigned shift = le16(h + 0x1E);
+    if (shift != 9 && shift != 12) {
+        return type;
+    }
+    uint32_t sector_size = 1u << shift;
+    uint32_t fat_entries = sector_size / 4;
+
+    reader_t r;
+    reader_init(&r, candidate);
+    r.budget = SIGNATURE_FORMATS_CLASSIFY_BUDGET;
+
+    // 沿 FAT 链读取目录扇区，每个目录项 128 字节
+    uint32_t sector = le32(h + 0x30);
+    for (int step = 0; step < SIGNATURE_FORMATS_CLASSIFY_ENTRIES && sector < 0xFFFFFFFAu; step++) {
+        for (uint32_t off = 0; off < sector_size; off += 128) {
+            const uint8_t* entry = reader_get(&r, cfb_sector(sector, shift) + off, 128);
+            if (!entry) {
+                return type;
+            }
+            if (entry[0x42] != 2) {
+                continue;           // 只看数据流
+            }
+            if (cfb_name_equals(entry, "WordDocument")) {
+                return FILE_TYPE_DOC;
+            }
+            if (cfb_name_equals(entry, "Workbook") || cfb_name_equals(entry, "Book")) {
+                return FILE_TYPE_XLS;
+            }
+            if (cfb_name_equals(entry, "PowerPoint Document")) {
+                return FILE_TYPE_PPT;
+            }
+        }
+
+        // 下一个目录扇区：FAT 扇区只取文件头中的 109 个
+        uint32_t fat_index = sector / fat_entries;
+        if (fat_index >= 109) {
+            break;
+        }
+        uint32_t fat_sector = le32(h + 0x4C + fat_index * 4);
+        const uint8_t* next = reader_get(&r, cfb_sector(fat_sector, shift) + (sector % fat_entries) * 4, 4);
+        if (!next) {
+            break;
+        }
+        sector = le32(next);
+    }
+    return type;
+}
+
+file_type_t signature_pe_classify(const signature_candidate_t* candidate, file_type_t type) {
+    // DOS 头的 e_lfanew（0x3C）指向 PE 签名，COFF 头中 Characteristics 位于签名之后 18 字节
+    if (candidate->header_len < 0x40) {
+        return type;
+    }
+    reader_t r;
+    reader_init(&r, candidate);
+    r.budget = SIGNATURE_FORMATS_CLASSIFY_BUDGET;
+
+    uint32_t pe = le32(candidate->header + 0x3C);
+    const uint8_t* coff = reader_get(&r, pe, 24);
+    if (!coff || memcmp(coff, "PE\0\0", 4) != 0) {
+        return type;
+    }
+    return (le16(coff + 22) & 0x2000) ? FILE_TYPE_DLL : FILE_TYPE_EXE;
+}
@@ -0,0 +1,471 @@
+#include "signature_matcher.h"
+#include "signature_prefilter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALPHABET 256
+#define IMAGE_MAGIC 0x4D434153u   // "SACM"
+#define IMAGE_ALIGN 64
+#define ALIGN_UP(n) (((n) + IMAGE_ALIGN - 1) & ~(size_t)(IMAGE_ALIGN - 1))
+#define PENDING_INITIAL 256
+
+// 编译映像头部，之后依次为 delta、out_start、out_count、outputs，各自按 64 字节对齐
+typedef struct {
+    uint32_t magic;           // IMAGE_MAGIC
+    uint32_t state_count;     // 状态数量
+    uint32_t output_count;    // 输出列表总长度
+    uint32_t pattern_count;   // 签名数量
+    uint64_t max_span;        // 最大跨度
+    uint8_t reserved[40];
+} image_header_t;
+
+struct signature_matcher {
+    uint32_t* delta;          // 状态转移表（state_count * 256，已展开失效链，扫描时无需回退）
+    uint32_t* out_start;      // 每个状态的输出在 outputs 中的起点
+    uint32_t* out_count;      // 每个状态的输出数量（0 表示非接受状态）
+    uint32_t* outputs;        // 签名下标（包含失效链上的输出，按下标升序）
+    uint32_t state_count;     // 状态数量
+    uint32_t output_count;    // 输出列表总长度
+    int mapped;               // 上面的表位于外部映像中，不由匹配器释放
+    size_t* back;             // 魔数最后一个字节到文件起始位置的距离
+    file_type_t* types;       // 签名对应的文件类型
+    size_t pattern_count;     // 签名数量
+    size_t max_span;          // 最大跨度（偏移 + 魔数长度）
+    signature_prefilter_t* prefilter; // 根状态下跳到下一个候选位置
+};
+
+// 按签名下标升序插入（输出列表很短，插入排序即可）
+static void sort_ids(uint32_t* ids, uint32_t count) {
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t id = ids[i];
+        uint32_t j = i;
+        while (j > 0 && ids[j - 1] > id) {
+            ids[j] = ids[j - 1];
+            j--;
+        }
+        ids[j] = id;
+    }
+}
+
+// 构建输出列表：每个状态的输出 = 自身的签名 + 失效状态的输出
+static int build_outputs(signature_matcher_t* m, const uint32_t* order, const uint32_t* fail,
+                         const uint32_t* own_head, const uint32_t* own_next) {
+    uint64_t total = 0;
+    for (uint32_t k = 0; k < m->state_count; k++) {
+        uint32_t s = order[k];
+        uint32_t count = 0;
+        for (uint32_t id = own_head[s]; id != UINT32_MAX; id = own_next[id]) {
+            count++;
+        }
+        if (s != 0) {
+            count += m->out_count[fail[s]];
+        }
+        m->out_count[s] = count;
+        total += count;
+    }
+
+    if (total > UINT32_MAX) {
+        return -1;
+    }
+    m->output_count = (uint32_t)total;
+    m->outputs = (uint32_t*)malloc((total ? total : 1) * sizeof(uint32_t));
+    if (!m->outputs) {
+        return -1;
+    }
+
+    // 按 BFS 顺序填充，保证失效状态（深度更小）的列表已经就绪
+    uint32_t next = 0;
+    for (uint32_t k = 0; k < m->state_count; k++) {
+        uint32_t s = order[k];
+        uint32_t* list = &m->outputs[next];
+        uint32_t n = 0;
+        for (uint32_t id = own_head[s]; id != UINT32_MAX; id = own_next[id]) {
+            list[n++] = id;
+        }
+        if (s != 0 && m->out_count[fail[s]] > 0) {
+            memcpy(&list[n], &m->outputs[m->out_start[fail[s]]],
+                   m->out_count[fail[s]] * sizeof(uint32_t));
+            n += m->out_count[fail[s]];
+        }
+        sort_ids(list, n);
+        m->out_start[s] = next;
+        next += n;
+    }
+    return 0;
+}
+
+signature_matcher_t* signature_matcher_create(const file_signature_t* signatures, size_t count) {
+    if (!signatures || count == 0 || count >= UINT32_MAX) {
+        return NULL;
+    }
+
+    size_t max_states = 1;
+    for (size_t i = 0; i < count; i++) {
+        max_states += signatures[i].magic_len;
+    }
+    if (max_states >= UINT32_MAX / ALPHABET) {
+        fprintf(stderr, "Error: Signature set too large\n");
+        return NULL;
+    }
+
+    signature_matcher_t* m = (signature_matcher_t*)calloc(1, sizeof(signature_matcher_t));
+    uint32_t* fail = (uint32_t*)calloc(max_states, sizeof(uint32_t));
+    uint32_t* order = (uint32_t*)malloc(max_states * sizeof(uint32_t));
+    uint32_t* own_head = (uint32_t*)malloc(max_states * sizeof(uint32_t));
+    uint32_t* own_next = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!m || !fail || !order || !own_head || !own_next) {
+        goto fail_alloc;
+    }
+
+    m->delta = (uint32_t*)calloc(max_states * ALPHABET, sizeof(uint32_t));
+    m->out_start = (uint32_t*)calloc(max_states, sizeof(uint32_t));
+    m->out_count = (uint32_t*)calloc(max_states, sizeof(uint32_t));
+    m->back = (size_t*)malloc(count * sizeof(size_t));
+    m->types = (file_type_t*)malloc(count * sizeof(file_type_t));
+    if (!m->delta || !m->out_start || !m->out_count || !m->back || !m->types) {
+        goto fail_alloc;
+    }
+
+    memset(own_head, 0xFF, max_states * sizeof(uint32_t));
+    m->pattern_count = count;
+    m->state_count = 1;
+
+    // 构建字典树（转移为 0 表示不存在，根节点不会成为子节点）
+    for (size_t i = 0; i < count; i++) {
+        const file_signature_t* sig = &signatures[i];
+        m->types[i] = sig->type;
+        own_next[i] = UINT32_MAX;
+        if (sig->magic_len == 0 || !sig->magic) {
+            m->back[i] = 0;
+            continue;
+        }
+
+        m->back[i] = sig->magic_len - 1 + sig->offset;
+        if (sig->offset + sig->magic_len > m->max_span) {
+            m->max_span = sig->offset + sig->magic_len;
+        }
+
+        uint32_t state = 0;
+        for (size_t j = 0; j < sig->magic_len; j++) {
+            uint32_t* slot = &m->delta[(size_t)state * ALPHABET + sig->magic[j]];
+            if (*slot == 0) {
+                *slot = m->state_count++;
+            }
+            state = *slot;
+        }
+
+        // 追加到该状态的签名链表末尾，保持下标顺序
+        uint32_t* link = &own_head[state];
+        while (*link != UINT32_MAX) {
+            link = &own_next[*link];
+        }
+        *link = (uint32_t)i;
+    }
+
+    // BFS 计算失效链接，并把缺失的转移展开为完整的 DFA
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    order[tail++] = 0;
+    while (head < tail) {
+        uint32_t s = order[head++];
+        uint32_t* row = &m->delta[(size_t)s * ALPHABET];
+        const uint32_t* fail_row = &m->delta[(size_t)fail[s] * ALPHABET];
+        for (int c = 0; c < ALPHABET; c++) {
+            if (row[c] != 0) {
+                fail[row[c]] = (s == 0) ? 0 : fail_row[c];
+                order[tail++] = row[c];
+            } else if (s != 0) {
+                row[c] = fail_row[c];
+            }
+        }
+    }
+
+    if (build_outputs(m, order, fail, own_head, own_next) < 0) {
+        goto fail_alloc;
+    }
+
+    // 预过滤器失败时逐字节匹配，结果相同
+    m->prefilter = signature_prefilter_create(signatures, count);
+
+    free(fail);
+    free(order);
+    free(own_head);
+    free(own_next);
+    return m;
+
+fail_alloc:
+    fprintf(stderr, "Error: Memory allocation failed\n");
+    free(fail);
+    free(order);
+    free(own_head);
+    free(own_next);
+    signature_matcher_destroy(m);
+    return NULL;
+}
+
+// 映像中各部分的偏移
+static void image_layout(uint32_t state_count, uint32_t output_count, size_t offsets[5]) {
+    offsets[0] = ALIGN_UP(sizeof(image_header_t));
+    offsets[1] = offsets[0] + ALIGN_UP((size_t)state_count * ALPHABET * sizeof(uint32_t));
+    offsets[2] = offsets[1] + ALIGN_UP((size_t)state_count * sizeof(uint32_t));
+    offsets[3] = offsets[2] + ALIGN_UP((size_t)state_count * sizeof(uint32_t));
+    offsets[4] = offsets[3] + ALIGN_UP((size_t)output_count * sizeof(uint32_t));
+}
+
+signature_matcher_t* signature_matcher_from_image(const void* image, size_t size,
+                                                  const file_signature_t* signatures, size_t count) {
+    if (!image || !signatures || count == 0 || size < sizeof(image_header_t) ||
+        ((uintptr_t)image % IMAGE_ALIGN) != 0) {
+        return NULL;
+    }
+
+    const image_header_t* header = (const image_header_t*)image;
+    if (header->magic != IMAGE_MAGIC || header->pattern_count != count ||
+        header->state_count == 0 || header->state_count >= UINT32_MAX / ALPHABET) {
+        return NULL;
+    }
+    size_t offsets[5];
+    image_layout(header->state_count, header->output_count, offsets);
+    if (offsets[4] > size) {
+        return NULL;
+    }
+
+    signature_matcher_t* m = (signature_matcher_t*)calloc(1, sizeof(signature_matcher_t));
+    if (!m) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    // 表只读使用，映像本身不会被修改
+    const uint8_t* base = (const uint8_t*)image;
+    m->mapped = 1;
+    m->delta = (uint32_t*)(base + offsets[0]);
+    m->out_start = (uint32_t*)(base + offsets[1]);
+    m->out_count = (uint32_t*)(base + offsets[2]);
+    m->outputs = (uint32_t*)(base + offsets[3]);
+    m->state_count = header->state_count;
+    m->output_count = header->output_count;
+    m->pattern_count = count;
+
+    // 输出列表决定回调中的签名下标，逐项检查；状态转移表很大，按需映射，不逐项检查
+    for (uint32_t s = 0; s < m->state_count; s++) {
+        if ((uint64_t)m->out_start[s] + m->out_count[s] > m->output_count) {
+            goto invalid;
+        }
+    }
+    for (uint32_t k = 0; k < m->output_count; k++) {
+        if (m->outputs[k] >= count) {
+            goto invalid;
+        }
+    }
+
+    m->back = (size_t*)malloc(count * sizeof(size_t));
+    m->types = (file_type_t*)malloc(count * sizeof(file_type_t));
+    if (!m->back || !m->types) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        signature_matcher_destroy(m);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const file_signature_t* sig = &signatures[i];
+        m->types[i] = sig->type;
+        m->back[i] = (sig->magic && sig->magic_len > 0) ? sig->magic_len - 1 + sig->offset : 0;
+        if (sig->magic && sig->magic_len > 0 && sig->offset + sig->magic_len > m->max_span) {
+            m->max_span = sig->offset + sig->magic_len;
+        }
+    }
+    if (m->max_span != header->max_span) {
+        goto invalid;
+    }
+
+    m->prefilter = signature_prefilter_create(signatures, count);
+    return m;
+
+invalid:
+    signature_matcher_destroy(m);
+    return NULL;
+}
+
+size_t signature_matcher_image_size(const signature_matcher_t* matcher) {
+    if (!matcher) {
+        return 0;
+    }
+    size_t offsets[5];
+    image_layout(matcher->state_count, matcher->output_count, offsets);
+    return offsets[4];
+}
+
+// 写出数组并补齐到 64 字节
+static int write_section(FILE* fp, const void* data, size_t size) {
+    static const uint8_t zeros[IMAGE_ALIGN];
+    if (size > 0 && fwrite(data, 1, size, fp) != size) {
+        return -1;
+    }
+    size_t pad = ALIGN_UP(size) - size;
+    if (pad > 0 && fwrite(zeros, 1, pad, fp) != pad) {
+        return -1;
+    }
+    return 0;
+}
+
+int signature_matcher_write_image(const signature_matcher_t* matcher, FILE* fp) {
+    if (!matcher || !fp) {
+        return -1;
+    }
+
+    image_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = IMAGE_MAGIC;
+    header.state_count = matcher->state_count;
+    header.output_count = matcher->output_count;
+    header.pattern_count = (uint32_t)matcher->pattern_count;
+    header.max_span = matcher->max_span;
+
+    size_t states = matcher->state_count;
+    if (write_section(fp, &header, sizeof(header)) < 0 ||
+        write_section(fp, matcher->delta, states * ALPHABET * sizeof(uint32_t)) < 0 ||
+        write_section(fp, matcher->out_start, states * sizeof(uint32_t)) < 0 ||
+        write_section(fp, matcher->out_count, states * sizeof(uint32_t)) < 0 ||
+        write_section(fp, matcher->outputs, matcher->output_count * sizeof(uint32_t)) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void signature_matcher_destroy(signature_matcher_t* matcher) {
+    if (!matcher) {
+        return;
+    }
+
+    if (!matcher->mapped) {
+        free(matcher->delta);
+        free(matcher->out_start);
+        free(matcher->out_count);
+        free(matcher->outputs);
+    }
+    free(matcher->back);
+    free(matcher->types);
+    signature_prefilter_destroy(matcher->prefilter);
+    free(matcher);
+}
+
+// 按 (位置, 签名下标) 插入待报告队列
+static void pending_insert(signature_match_t* pending, size_t head, size_t* tail,
+                           const signature_match_t* match) {
+    size_t j = *tail;
+    while (j > head && (pending[j - 1].position > match->position ||
+                        (pending[j - 1].position == match->position &&
+                         pending[j - 1].signature > match->signature))) {
+        pending[j] = pending[j - 1];
+        j--;
+    }
+    pending[j] = *match;
+    (*tail)++;
+}
+
+int64_t signature_matcher_scan(const signature_matcher_t* matcher, const uint8_t* data, size_t size,
+                               signature_match_fn callback, void* user_data) {
+    if (!matcher || !data || !callback) {
+        return -1;
+    }
+    if (matcher->max_span == 0 || size == 0) {
+        return 0;
+    }
+
+    // 匹配按魔数结束位置产生，起始位置最多落后 max_span，
+    // 暂存在队列中排序，确定不会再有更靠前的匹配后再报告
+    // （同时待报告的匹配通常很少，队列按需增长，不按签名数量 * 跨度预先分配）
+    size_t capacity = PENDING_INITIAL;
+    signature_match_t* pending = (signature_match_t*)malloc(capacity * sizeof(signature_match_t));
+    if (!pending) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    size_t head = 0;
+    size_t tail = 0;
+    int64_t reported = 0;
+    int stopped = 0;
+    uint32_t state = 0;
+
+    for (size_t pos = 0; pos < size; pos++) {
+        // 处于根状态时，不能开始魔数的字节不会改变状态，直接跳到下一个候选位置
+        if (state == 0 && matcher->prefilter) {
+            pos = signature_prefilter_find(matcher->prefilter, data, size, pos);
+            if (pos >= size) {
+                break;
+            }
+        }
+
+        // 从 pos 结束的匹配起始位置不小于 pos + 1 - max_span，更靠前的匹配可以报告
+        while (head < tail && pending[head].position + matcher->max_span <= pos) {
+            reported++;
+            if (callback(&pending[head++], user_data) != 0) {
+                stopped = 1;
+                break;
+            }
+        }
+        if (stopped) {
+            break;
+        }
+        if (head == tail) {
+            head = tail = 0;
+        }
+
+        state = matcher->delta[(size_t)state * ALPHABET + data[pos]];
+
+        uint32_t n = matcher->out_count[state];
+        if (n > 0) {
+            if (tail + n > capacity) {
+                memmove(pending, &pending[head], (tail - head) * sizeof(signature_match_t));
+                tail -= head;
+                head = 0;
+            }
+            if (tail + n > capacity) {
+                size_t grown = capacity * 2 > tail + n ? capacity * 2 : tail + n;
+                signature_match_t* resized = (signature_match_t*)realloc(
+                    pending, grown * sizeof(signature_match_t));
+                if (!resized) {
+                    fprintf(stderr, "Error: Memory allocation failed\n");
+                    free(pending);
+                    return -1;
+                }
+                pending = resized;
+                capacity = grown;
+            }
+
+            const uint32_t* ids = &matcher->outputs[matcher->out_start[state]];
+            for (uint32_t k = 0; k < n; k++) {
+                size_t back = matcher->back[ids[k]];
+                if (pos < back) {
+                    continue;
+                }
+                signature_match_t match = {
+                    .position = pos - back,
+                    .signature = ids[k],
+                    .type = matcher->types[ids[k]]
+                };
+                pending_insert(pending, head, &tail, &match);
+            }
+        }
+    }
+
+    while (!stopped && head < tail) {
+        reported++;
+        if (callback(&pending[head++], user_data) != 0) {
+            stopped = 1;
+        }
+    }
+
+    free(pending);
+    return reported;
+}
+
+size_t signature_matcher_max_span(const signature_matcher_t* matcher) {
+    return matcher ? matcher->max_span : 0;
+}
+
+const char* signature_matcher_isa(const signature_matcher_t* matcher) {
+    return matcher ? signature_prefilter_isa(matcher->prefilter) : "none";
+}
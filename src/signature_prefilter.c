@@ -0,0 +1,227 @@
+#define _GNU_SOURCE
+#include "signature_prefilter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PREFILTER_X86 1
+#endif
+
+// 指定的实现（signature_prefilter_select）
+typedef enum {
+    PREFILTER_AUTO,
+    PREFILTER_OFF,
+    PREFILTER_SCALAR,
+    PREFILTER_SSE2,
+    PREFILTER_AVX2
+} prefilter_choice_t;
+
+static prefilter_choice_t selected = PREFILTER_AUTO;
+
+typedef size_t (*prefilter_find_fn)(const signature_prefilter_t* filter, const uint8_t* data,
+                                    size_t size, size_t start);
+
+struct signature_prefilter {
+    uint8_t broadcast[SIGNATURE_PREFILTER_MAX_BYTES][32]; // 每个首字节重复 32 次，供 SSE2 比较直接加载
+    uint8_t low_table[32];        // AVX2 查表：低半字节 -> 桶位掩码（两个 128 位通道各一份）
+    uint8_t high_table[32];       // AVX2 查表：高半字节 -> 桶位掩码
+    uint8_t pairs[65536 / 8];     // 魔数前两个字节的位图
+    uint8_t first[256];           // 魔数首字节集合
+    uint32_t first_count;         // 不同首字节的数量
+    prefilter_find_fn find;       // 按 CPU 选择的实现
+    const char* isa;              // 实现使用的指令集
+};
+
+// 检查 pos 处是否可能开始一个魔数（最后一个字节只检查首字节）
+static inline int is_candidate(const signature_prefilter_t* filter, const uint8_t* data,
+                               size_t size, size_t pos) {
+    if (pos + 1 >= size) {
+        return filter->first[data[pos]];
+    }
+    uint32_t pair = ((uint32_t)data[pos] << 8) | data[pos + 1];
+    return (filter->pairs[pair >> 3] >> (pair & 7)) & 1;
+}
+
+static size_t find_scalar(const signature_prefilter_t* filter, const uint8_t* data,
+                          size_t size, size_t start) {
+    for (size_t pos = start; pos < size; pos++) {
+        if (filter->first[data[pos]] && is_candidate(filter, data, size, pos)) {
+            return pos;
+        }
+    }
+    return size;
+}
+
+#ifdef PREFILTER_X86
+// 逐个检查掩码中命中首字节的位置
+static inline int check_mask(const signature_prefilter_t* filter, const uint8_t* data,
+                             size_t size, size_t base, uint32_t mask, size_t* found) {
+    while (mask) {
+        size_t pos = base + (size_t)__builtin_ctz(mask);
+        if (is_candidate(filter, data, size, pos)) {
+            *found = pos;
+            return 1;
+        }
+        mask &= mask - 1;
+    }
+    return 0;
+}
+
+__attribute__((target("sse2")))
+static size_t find_sse2(const signature_prefilter_t* filter, const uint8_t* data,
+                        size_t size, size_t start) {
+    size_t pos = start;
+    size_t found;
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + pos));
+        __m128i hit = _mm_cmpeq_epi8(v, _mm_load_si128((const __m128i*)filter->broadcast[0]));
+        for (uint32_t k = 1; k < filter->first_count; k++) {
+            __m128i b = _mm_load_si128((const __m128i*)filter->broadcast[k]);
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, b));
+        }
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask && check_mask(filter, data, size, pos, mask, &found)) {
+            return found;
+        }
+    }
+    return find_scalar(filter, data, size, pos);
+}
+
+// 按半字节查表分类：字节 c 命中当且仅当 high_table[c >> 4] & low_table[c & 15] 非 0，
+// 每 32 字节固定几条指令，与首字节数量无关
+__attribute__((target("avx2")))
+static size_t find_avx2(const signature_prefilter_t* filter, const uint8_t* data,
+                        size_t size, size_t start) {
+    const __m256i low_table = _mm256_load_si256((const __m256i*)filter->low_table);
+    const __m256i high_table = _mm256_load_si256((const __m256i*)filter->high_table);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t pos = start;
+    size_t found;
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + pos));
+        __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(v, nibble));
+        __m256i high = _mm256_shuffle_epi8(high_table,
+                                           _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero);
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(miss);
+        if (mask && check_mask(filter, data, size, pos, mask, &found)) {
+            return found;
+        }
+    }
+    return find_scalar(filter, data, size, pos);
+}
+#endif
+
+int signature_prefilter_select(const char* isa) {
+    if (!isa || strcmp(isa, "auto") == 0) {
+        selected = PREFILTER_AUTO;
+    } else if (strcmp(isa, "off") == 0) {
+        selected = PREFILTER_OFF;
+    } else if (strcmp(isa, "scalar") == 0) {
+        selected = PREFILTER_SCALAR;
+#ifdef PREFILTER_X86
+    } else if (strcmp(isa, "sse2") == 0 && (__builtin_cpu_init(), __builtin_cpu_supports("sse2"))) {
+        selected = PREFILTER_SSE2;
+    } else if (strcmp(isa, "avx2") == 0 && (__builtin_cpu_init(), __builtin_cpu_supports("avx2"))) {
+        selected = PREFILTER_AVX2;
+#endif
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+signature_prefilter_t* signature_prefilter_create(const file_signature_t* signatures, size_t count) {
+    if (!signatures || count == 0 || selected == PREFILTER_OFF) {
+        return NULL;
+    }
+
+    signature_prefilter_t* filter = NULL;
+    if (posix_memalign((void**)&filter, 32, sizeof(signature_prefilter_t)) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+    memset(filter, 0, sizeof(signature_prefilter_t));
+
+    for (size_t i = 0; i < count; i++) {
+        const file_signature_t* sig = &signatures[i];
+        if (!sig->magic || sig->magic_len == 0) {
+            continue;
+        }
+
+        uint8_t c = sig->magic[0];
+        if (!filter->first[c]) {
+            filter->first[c] = 1;
+            if (filter->first_count < SIGNATURE_PREFILTER_MAX_BYTES) {
+                memset(filter->broadcast[filter->first_count], c, 32);
+            }
+            filter->first_count++;
+        }
+
+        // 单字节魔数：任意后续字节都是候选
+        if (sig->magic_len == 1) {
+            memset(&filter->pairs[((uint32_t)c << 8) >> 3], 0xFF, 256 / 8);
+        } else {
+            uint32_t pair = ((uint32_t)c << 8) | sig->magic[1];
+            filter->pairs[pair >> 3] |= (uint8_t)(1u << (pair & 7));
+        }
+    }
+
+    // 半字节查表：每个不同的高半字节分配一个桶位（超过 8 个时共用，只会多出候选，
+    // 多出的候选由前两字节位图排除）
+    uint8_t bucket_of[16];
+    uint32_t buckets = 0;
+    memset(bucket_of, 0xFF, sizeof(bucket_of));
+    for (int c = 0; c < 256; c++) {
+        if (!filter->first[c]) {
+            continue;
+        }
+        int high = c >> 4;
+        if (bucket_of[high] == 0xFF) {
+            bucket_of[high] = (uint8_t)(buckets++ % 8);
+        }
+        uint8_t bit = (uint8_t)(1u << bucket_of[high]);
+        filter->high_table[high] |= bit;
+        filter->high_table[high + 16] |= bit;
+        filter->low_table[c & 15] |= bit;
+        filter->low_table[(c & 15) + 16] |= bit;
+    }
+
+    filter->find = find_scalar;
+    filter->isa = "scalar";
+#ifdef PREFILTER_X86
+    if (filter->first_count > 0 && selected != PREFILTER_SCALAR) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && selected != PREFILTER_SSE2) {
+            filter->find = find_avx2;
+            filter->isa = "avx2";
+        } else if (__builtin_cpu_supports("sse2") && selected != PREFILTER_AVX2 &&
+                   filter->first_count <= SIGNATURE_PREFILTER_MAX_BYTES) {
+            // 首字节过多时逐个比较不再划算，使用标量查表
+            filter->find = find_sse2;
+            filter->isa = "sse2";
+        }
+    }
+#endif
+    return filter;
+}
+
+void signature_prefilter_destroy(signature_prefilter_t* filter) {
+    free(filter);
+}
+
+size_t signature_prefilter_find(const signature_prefilter_t* filter, const uint8_t* data,
+                                size_t size, size_t start) {
+    if (!filter || !data || start >= size) {
+        return size;
+    }
+    return filter->find(filter, data, size, start);
+}
+
+const char* signature_prefilter_isa(const signature_prefilter_t* filter) {
+    return filter ? filter->isa : "none";
+}
@@ -0,0 +1,404 @@
+#define _GNU_SOURCE
+#include "text_detector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXT_X86 1
+#endif
+
+#define CHUNK 32                  // 向量分类的块大小
+
+// 字节类别
+enum {
+    CLASS_NONE = 0,               // 非文本字节
+    CLASS_ASCII,                  // 可打印 ASCII 或常见空白字符
+    CLASS_LEAD2,                  // 双字节 UTF-8 首字节
+    CLASS_LEAD3,                  // 三字节 UTF-8 首字节
+    CLASS_LEAD4                   // 四字节 UTF-8 首字节
+};
+
+// 对 CHUNK 个字节分类：ascii 为文本 ASCII 字节的位掩码，
+// breaker 为一定会结束文本区间的字节（控制字符和不可能出现在 UTF-8 中的字节）的位掩码
+typedef void (*classify_fn)(const uint8_t* data, uint32_t* ascii, uint32_t* breaker);
+
+struct text_detector {
+    size_t min_length;            // 最短文本长度
+    double min_entropy;           // 最低熵
+    uint64_t next_offset;         // 下一次输入应有的偏移（用于判断是否连续）
+    int in_run;                   // 是否处于文本区间中
+    uint64_t run_start;           // 当前区间起始偏移
+    uint64_t run_length;          // 当前区间已确认的长度（不含未完成的多字节字符）
+    uint32_t need;                // 未完成的 UTF-8 字符还需要的后续字节数
+    uint8_t low;                  // 下一个后续字节的下限
+    uint8_t high;                 // 下一个后续字节的上限
+    uint8_t pending[4];           // 未完成的多字节字符
+    uint32_t pending_len;
+    uint64_t counts[256];         // 当前区间的字节直方图
+    uint8_t touched[256];         // 直方图中非 0 的字节，用于快速清零
+    uint32_t touched_count;
+    uint8_t classes[256];         // 字节类别表
+    uint8_t breakers[256];        // 一定会结束文本区间的字节
+    classify_fn classify;         // 按 CPU 选择的分类实现
+    const char* isa;
+    text_detector_stats_t stats;
+};
+
+// 标量实现只在没有 SSE2 的平台上使用，逐字节查表（表内容固定，创建检测器时填充）
+static uint8_t scalar_classes[256];
+static uint8_t scalar_breakers[256];
+
+static void classify_scalar(const uint8_t* data, uint32_t* ascii, uint32_t* breaker) {
+    uint32_t a = 0;
+    uint32_t b = 0;
+    for (uint32_t i = 0; i < CHUNK; i++) {
+        a |= (uint32_t)(scalar_classes[data[i]] == CLASS_ASCII) << i;
+        b |= (uint32_t)scalar_breakers[data[i]] << i;
+    }
+    *ascii = a;
+    *breaker = b;
+}
+
+#ifdef TEXT_X86
+// 有符号比较：0x20-0x7E 为正数且在范围内，0x80 以上为负数
+__attribute__((target("sse2")))
+static void classify16_sse2(__m128i v, uint32_t* ascii, uint32_t* breaker) {
+    __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1F)),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+    __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+                                              _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    // 0xC0/0xC1 和 0xF5-0xFF 不会出现在合法的 UTF-8 中
+    __m128i c0 = _mm_cmpeq_epi8(_mm_and_si128(v, _mm_set1_epi8((char)0xFE)), _mm_set1_epi8((char)0xC0));
+    __m128i f5 = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char)0xF4)),
+                               _mm_cmplt_epi8(v, _mm_setzero_si128()));
+    uint32_t a = (uint32_t)_mm_movemask_epi8(_mm_or_si128(printable, space));
+    uint32_t high = (uint32_t)_mm_movemask_epi8(v);
+    *ascii = a;
+    *breaker = (~(a | high) & 0xFFFF) | (uint32_t)_mm_movemask_epi8(_mm_or_si128(c0, f5));
+}
+
+__attribute__((target("sse2")))
+static void classify_sse2(const uint8_t* data, uint32_t* ascii, uint32_t* breaker) {
+    uint32_t a_lo, a_hi, b_lo, b_hi;
+    classify16_sse2(_mm_loadu_si128((const __m128i*)data), &a_lo, &b_lo);
+    classify16_sse2(_mm_loadu_si128((const __m128i*)(data + 16)), &a_hi, &b_hi);
+    *ascii = a_lo | (a_hi << 16);
+    *breaker = b_lo | (b_hi << 16);
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const uint8_t* data, uint32_t* ascii, uint32_t* breaker) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)data);
+    __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x1F)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), v));
+    __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+                                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+    __m256i c0 = _mm256_cmpeq_epi8(_mm256_and_si256(v, _mm256_set1_epi8((char)0xFE)),
+                                   _mm256_set1_epi8((char)0xC0));
+    __m256i f5 = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8((char)0xF4)),
+                                  _mm256_cmpgt_epi8(_mm256_setzero_si256(), v));
+    uint32_t a = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(printable, space));
+    uint32_t high = (uint32_t)_mm256_movemask_epi8(v);
+    *ascii = a;
+    *breaker = ~(a | high) | (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(c0, f5));
+}
+#endif
+
+text_detector_t* text_detector_create(size_t min_length, double min_entropy) {
+    text_detector_t* d = (text_detector_t*)calloc(1, sizeof(text_detector_t));
+    if (!d) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    d->min_length = min_length ? min_length : TEXT_DETECTOR_DEFAULT_MIN_LENGTH;
+    d->min_entropy = min_entropy >= 0 ? min_entropy : TEXT_DETECTOR_DEFAULT_MIN_ENTROPY;
+
+    for (int c = 0; c < 256; c++) {
+        if ((c >= 0x20 && c <= 0x7E) || c == '\t' || c == '\n' || c == '\r') {
+            d->classes[c] = CLASS_ASCII;
+        } else if (c >= 0xC2 && c <= 0xDF) {
+            d->classes[c] = CLASS_LEAD2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            d->classes[c] = CLASS_LEAD3;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            d->classes[c] = CLASS_LEAD4;
+        }
+        d->breakers[c] = (c < 0x80 && d->classes[c] != CLASS_ASCII) ||
+                         c == 0xC0 || c == 0xC1 || c >= 0xF5;
+    }
+    memcpy(scalar_classes, d->classes, sizeof(scalar_classes));
+    memcpy(scalar_breakers, d->breakers, sizeof(scalar_breakers));
+
+    d->classify = classify_scalar;
+    d->isa = "scalar";
+#ifdef TEXT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        d->classify = classify_avx2;
+        d->isa = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        d->classify = classify_sse2;
+        d->isa = "sse2";
+    }
+#endif
+    return d;
+}
+
+void text_detector_destroy(text_detector_t* detector) {
+    free(detector);
+}
+
+static inline void count_byte(text_detector_t* d, uint8_t c) {
+    if (d->counts[c]++ == 0) {
+        d->touched[d->touched_count++] = c;
+    }
+}
+
+static double run_entropy(const text_detector_t* d) {
+    double n = (double)d->run_length;
+    double sum = 0.0;
+    for (uint32_t i = 0; i < d->touched_count; i++) {
+        double count = (double)d->counts[d->touched[i]];
+        sum += count * log2(count);
+    }
+    return log2(n) - sum / n;
+}
+
+// 结束当前区间，满足阈值时报告
+static int end_run(text_detector_t* d, text_run_fn callback, void* user_data) {
+    int ret = 0;
+    if (d->in_run && d->run_length >= d->min_length) {
+        text_run_t run = {
+            .offset = d->run_start,
+            .length = d->run_length,
+            .entropy = run_entropy(d)
+        };
+        if (run.entropy >= d->min_entropy) {
+            d->stats.runs++;
+            d->stats.text_bytes += run.length;
+            ret = callback(&run, user_data) ? 1 : 0;
+        } else {
+            d->stats.low_entropy_runs++;
+        }
+    }
+
+    for (uint32_t i = 0; i < d->touched_count; i++) {
+        d->counts[d->touched[i]] = 0;
+    }
+    d->touched_count = 0;
+    d->in_run = 0;
+    d->run_length = 0;
+    d->need = 0;
+    d->pending_len = 0;
+    return ret;
+}
+
+static inline void start_run(text_detector_t* d, uint64_t offset) {
+    if (!d->in_run) {
+        d->in_run = 1;
+        d->run_start = offset;
+        d->run_length = 0;
+    }
+}
+
+// 逐字节处理（UTF-8 状态机）
+static int step(text_detector_t* d, uint8_t c, uint64_t offset,
+                text_run_fn callback, void* user_data) {
+    if (d->need > 0) {
+        if (c >= d->low && c <= d->high) {
+            d->pending[d->pending_len++] = c;
+            d->low = 0x80;
+            d->high = 0xBF;
+            if (--d->need == 0) {
+                for (uint32_t i = 0; i < d->pending_len; i++) {
+                    count_byte(d, d->pending[i]);
+                }
+                d->run_length += d->pending_len;
+                d->pending_len = 0;
+            }
+            return 0;
+        }
+
+        // 非法序列：区间在最后一个完整字符处结束，当前字节重新判断
+        if (end_run(d, callback, user_data)) {
+            return 1;
+        }
+    }
+
+    switch (d->classes[c]) {
+        case CLASS_ASCII:
+            start_run(d, offset);
+            count_byte(d, c);
+            d->run_length++;
+            return 0;
+
+        case CLASS_LEAD2:
+        case CLASS_LEAD3:
+        case CLASS_LEAD4:
+            start_run(d, offset);
+            d->need = (uint32_t)(d->classes[c] - CLASS_ASCII);
+            // 排除过长编码、代理区和超出 U+10FFFF 的序列
+            d->low = (c == 0xE0) ? 0xA0 : (c == 0xF0) ? 0x90 : 0x80;
+            d->high = (c == 0xED) ? 0x9F : (c == 0xF4) ? 0x8F : 0xBF;
+            d->pending[0] = c;
+            d->pending_len = 1;
+            return 0;
+
+        default:
+            return d->in_run ? end_run(d, callback, user_data) : 0;
+    }
+}
+
+// 精确处理 [from, to)：整块 ASCII 时批量并入当前区间，其余字节走 UTF-8 状态机
+static int process(text_detector_t* d, const uint8_t* data, size_t from, size_t to,
+                   uint64_t offset, text_run_fn callback, void* user_data) {
+    size_t i = from;
+    while (i < to) {
+        if (d->need == 0 && i + CHUNK <= to) {
+            uint32_t ascii;
+            uint32_t breaker;
+            d->classify(&data[i], &ascii, &breaker);
+
+            if (ascii == UINT32_MAX) {
+                start_run(d, offset + i);
+                for (uint32_t k = 0; k < CHUNK; k++) {
+                    count_byte(d, data[i + k]);
+                }
+                d->run_length += CHUNK;
+                i += CHUNK;
+                continue;
+            }
+
+            // 逐字节处理到第一个非 ASCII 字节（含）后重新分类
+            size_t stop = i + (size_t)__builtin_ctz(~ascii) + 1;
+            for (; i < stop; i++) {
+                if (step(d, data[i], offset + i, callback, user_data)) {
+                    return 1;
+                }
+            }
+            continue;
+        }
+
+        if (step(d, data[i], offset + i, callback, user_data)) {
+            return 1;
+        }
+        i++;
+    }
+    return 0;
+}
+
+// 查找从 from 开始的第一个一定会结束文本区间的字节
+static size_t next_breaker(const text_detector_t* d, const uint8_t* data, size_t from, size_t size) {
+    size_t i = from;
+    for (; i + CHUNK <= size; i += CHUNK) {
+        uint32_t ascii;
+        uint32_t breaker;
+        d->classify(&data[i], &ascii, &breaker);
+        if (breaker) {
+            return i + (size_t)__builtin_ctz(breaker);
+        }
+    }
+    for (; i < size; i++) {
+        if (d->breakers[data[i]]) {
+            return i;
+        }
+    }
+    return size;
+}
+
+int text_detector_feed(text_detector_t* detector, const uint8_t* data, size_t size,
+                       uint64_t offset, text_run_fn callback, void* user_data) {
+    if (!detector || !data || !callback) {
+        return 0;
+    }
+
+    text_detector_t* d = detector;
+    if (d->in_run && offset != d->next_offset) {
+        if (end_run(d, callback, user_data)) {
+            return 1;
+        }
+    }
+    d->next_offset = offset + size;
+    d->stats.bytes += size;
+
+    // 先精确处理上次输入延续下来的区间，直到第一个一定会结束区间的字节
+    size_t i = 0;
+    if (d->in_run) {
+        size_t b = next_breaker(d, data, 0, size);
+        i = b < size ? b + 1 : size;
+        if (process(d, data, 0, i, offset, callback, user_data)) {
+            return 1;
+        }
+    }
+
+    // 文本区间不会跨越控制字符等字节，两个这样的字节之间的片段短于最短长度时不可能
+    // 包含满足阈值的区间。最短长度不小于 CHUNK 时，块内的片段都可以跳过，
+    // 只需跟踪跨块的片段，每 CHUNK 字节分类一次
+    if (d->min_length >= CHUNK) {
+        size_t segment = i;
+        for (; i + CHUNK <= size; i += CHUNK) {
+            uint32_t ascii;
+            uint32_t breaker;
+            d->classify(&data[i], &ascii, &breaker);
+            if (!breaker) {
+                continue;
+            }
+            size_t first = i + (size_t)__builtin_ctz(breaker);
+            if (first - segment >= d->min_length) {
+                if (process(d, data, segment, first + 1, offset, callback, user_data)) {
+                    return 1;
+                }
+            }
+            segment = i + CHUNK - (size_t)__builtin_clz(breaker);
+        }
+        i = segment;
+    }
+
+    // 剩余部分（可能延续到下一次输入）精确处理
+    return process(d, data, i, size, offset, callback, user_data);
+}
+
+int text_detector_pending(const text_detector_t* detector, text_run_t* run) {
+    if (run) {
+        memset(run, 0, sizeof(text_run_t));
+    }
+    if (!detector || !detector->in_run) {
+        return 0;
+    }
+
+    double entropy = detector->run_length ? run_entropy(detector) : 0.0;
+    if (run) {
+        run->offset = detector->run_start;
+        run->length = detector->run_length;
+        run->entropy = entropy;
+    }
+    return detector->run_length >= detector->min_length && entropy >= detector->min_entropy;
+}
+
+int text_detector_finish(text_detector_t* detector, text_run_fn callback, void* user_data) {
+    if (!detector || !callback) {
+        return 0;
+    }
+    return end_run(detector, callback, user_data);
+}
+
+void text_detector_get_stats(const text_detector_t* detector, text_detector_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(text_detector_stats_t));
+    if (detector) {
+        *stats = detector->stats;
+    }
+}
+
+const char* text_detector_isa(const text_detector_t* detector) {
+    return detector ? detector->isa : "none";
+}
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,8 +9,6 @@
 #include <time.h>
 #include <errno.h>
 
-#define _POSIX_C_SOURCE 200809L
-
 char* utils_format_size(uint64_t bytes, char* buffer, size_t size) {
     const char* units[] = {"B", "KB", "MB", "GB", "TB", "PB"};
     int unit_index = 0;
@@ -145,6 +144,12 @@ void utils_show_progress(int progress, const char* message) {
     fflush(stdout);
 }
 
+uint64_t utils_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
 void utils_hex_dump(const uint8_t* data, size_t size, uint64_t offset) {
     if (!data || size == 0) {
         return;
@@ -0,0 +1,192 @@
+#define _GNU_SOURCE
+#include "work_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define DEQUE_INITIAL_CAPACITY 256
+
+// 单个工作线程的双端队列（环形缓冲区，head 为窃取端，tail 为所有者端）
+// 按缓存行对齐，不同线程的队列锁不会落在同一缓存行上
+typedef struct {
+    pthread_mutex_t lock;
+    work_item_t* items;
+    size_t capacity;          // 2 的幂
+    size_t head;              // 最早的任务
+    size_t tail;              // 最新任务之后的位置
+} __attribute__((aligned(64))) work_deque_t;
+
+struct work_queue {
+    work_deque_t* deques;
+    uint32_t workers;
+
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond; // 有新任务或条件变化
+    uint64_t epoch;           // 唤醒计数
+    uint32_t waiting;         // 等待中的线程数
+
+    uint64_t pushed;
+    uint64_t stolen;
+};
+
+work_queue_t* work_queue_create(uint32_t workers) {
+    if (workers == 0) {
+        return NULL;
+    }
+
+    work_queue_t* queue = (work_queue_t*)calloc(1, sizeof(work_queue_t));
+    void* deques = NULL;
+    if (!queue || posix_memalign(&deques, 64, workers * sizeof(work_deque_t)) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(queue);
+        return NULL;
+    }
+    queue->deques = (work_deque_t*)deques;
+    queue->workers = workers;
+    memset(queue->deques, 0, workers * sizeof(work_deque_t));
+    for (uint32_t i = 0; i < workers; i++) {
+        pthread_mutex_init(&queue->deques[i].lock, NULL);
+    }
+    pthread_mutex_init(&queue->idle_lock, NULL);
+    pthread_cond_init(&queue->idle_cond, NULL);
+    return queue;
+}
+
+void work_queue_destroy(work_queue_t* queue) {
+    if (!queue) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < queue->workers; i++) {
+        pthread_mutex_destroy(&queue->deques[i].lock);
+        free(queue->deques[i].items);
+    }
+    pthread_cond_destroy(&queue->idle_cond);
+    pthread_mutex_destroy(&queue->idle_lock);
+    free(queue->deques);
+    free(queue);
+}
+
+// 队列已满时容量加倍（按从旧到新的顺序复制）
+static int grow_deque(work_deque_t* deque) {
+    size_t capacity = deque->capacity ? deque->capacity * 2 : DEQUE_INITIAL_CAPACITY;
+    work_item_t* items = (work_item_t*)malloc(capacity * sizeof(work_item_t));
+    if (!items) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    size_t count = deque->tail - deque->head;
+    for (size_t i = 0; i < count; i++) {
+        items[i] = deque->items[(deque->head + i) & (deque->capacity - 1)];
+    }
+    free(deque->items);
+    deque->items = items;
+    deque->capacity = capacity;
+    deque->head = 0;
+    deque->tail = count;
+    return 0;
+}
+
+int work_queue_push(work_queue_t* queue, uint32_t worker, work_fn fn, void* arg, size_t index) {
+    if (!queue || worker >= queue->workers || !fn) {
+        return -1;
+    }
+
+    work_deque_t* deque = &queue->deques[worker];
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail - deque->head == deque->capacity && grow_deque(deque) < 0) {
+        pthread_mutex_unlock(&deque->lock);
+        return -1;
+    }
+    work_item_t* item = &deque->items[deque->tail & (deque->capacity - 1)];
+    item->fn = fn;
+    item->arg = arg;
+    item->index = index;
+    deque->tail++;
+    pthread_mutex_unlock(&deque->lock);
+
+    __atomic_fetch_add(&queue->pushed, 1, __ATOMIC_RELAXED);
+    work_queue_notify(queue);
+    return 0;
+}
+
+int work_queue_pop(work_queue_t* queue, uint32_t worker, work_item_t* item) {
+    if (!queue || worker >= queue->workers || !item) {
+        return 0;
+    }
+
+    // 自己的队列：取最新的任务（数据大多还在缓存中）
+    work_deque_t* own = &queue->deques[worker];
+    pthread_mutex_lock(&own->lock);
+    if (own->tail > own->head) {
+        own->tail--;
+        *item = own->items[own->tail & (own->capacity - 1)];
+        pthread_mutex_unlock(&own->lock);
+        return 1;
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    // 从下一个线程开始轮流窃取最早的任务
+    for (uint32_t i = 1; i < queue->workers; i++) {
+        work_deque_t* victim = &queue->deques[(worker + i) % queue->workers];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->tail > victim->head) {
+            *item = victim->items[victim->head & (victim->capacity - 1)];
+            victim->head++;
+            pthread_mutex_unlock(&victim->lock);
+            __atomic_fetch_add(&queue->stolen, 1, __ATOMIC_RELAXED);
+            return 1;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return 0;
+}
+
+uint64_t work_queue_epoch(work_queue_t* queue) {
+    if (!queue) {
+        return 0;
+    }
+    pthread_mutex_lock(&queue->idle_lock);
+    uint64_t epoch = queue->epoch;
+    pthread_mutex_unlock(&queue->idle_lock);
+    return epoch;
+}
+
+void work_queue_wait(work_queue_t* queue, uint64_t epoch) {
+    if (!queue) {
+        return;
+    }
+    pthread_mutex_lock(&queue->idle_lock);
+    queue->waiting++;
+    while (queue->epoch == epoch) {
+        pthread_cond_wait(&queue->idle_cond, &queue->idle_lock);
+    }
+    queue->waiting--;
+    pthread_mutex_unlock(&queue->idle_lock);
+}
+
+void work_queue_notify(work_queue_t* queue) {
+    if (!queue) {
+        return;
+    }
+    pthread_mutex_lock(&queue->idle_lock);
+    queue->epoch++;
+    if (queue->waiting > 0) {
+        pthread_cond_broadcast(&queue->idle_cond);
+    }
+    pthread_mutex_unlock(&queue->idle_lock);
+}
+
+void work_queue_get_stats(work_queue_t* queue, work_queue_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(work_queue_stats_t));
+    if (!queue) {
+        return;
+    }
+    stats->pushed = __atomic_load_n(&queue->pushed, __ATOMIC_RELAXED);
+    stats->stolen = __atomic_load_n(&queue->stolen, __ATOMIC_RELAXED);
+}
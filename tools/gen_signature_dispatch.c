@@ -0,0 +1,137 @@
+// 编译时根据 src/signatures.def 生成内置签名的首字节分派表和按类型索引的扩展名、描述数组
+// 用法: gen_signature_dispatch <输出文件>
+#include "signature.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    file_type_t type;
+    const char* extension;
+    const char* magic;
+    size_t magic_len;
+    size_t literal_len;   // 魔数字符串字面量的实际长度
+    size_t offset;
+    const char* description;
+} builtin_signature_t;
+
+static const builtin_signature_t builtins[] = {
+#define SIGNATURE(type, extension, magic, magic_len, offset, description, ...) \
+    {type, extension, magic, magic_len, sizeof(magic) - 1, offset, description},
+#include "../src/signatures.def"
+#undef SIGNATURE
+};
+
+#define BUILTIN_COUNT (sizeof(builtins) / sizeof(builtins[0]))
+
+// 输出 C 字符串字面量（非打印字符用八进制转义）
+static void write_string(FILE* out, const char* s) {
+    if (!s) {
+        fputs("NULL", out);
+        return;
+    }
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20 || c > 0x7E) {
+            fprintf(out, "\\%03o", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// 签名是否属于首字节 b 的桶（有偏移的签名与首字节无关，属于所有桶）
+static int in_bucket(const builtin_signature_t* sig, int b) {
+    return sig->offset > 0 || (unsigned char)sig->magic[0] == b;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <output>\n", argv[0]);
+        return 1;
+    }
+    if (BUILTIN_COUNT > 255) {
+        fprintf(stderr, "Error: Too many built-in signatures (%zu)\n", (size_t)BUILTIN_COUNT);
+        return 1;
+    }
+    for (size_t i = 0; i < BUILTIN_COUNT; i++) {
+        const builtin_signature_t* sig = &builtins[i];
+        if (sig->magic_len == 0 || sig->magic_len != sig->literal_len) {
+            fprintf(stderr, "Error: Signature %zu (%s): magic length %zu does not match literal (%zu)\n",
+                    i, sig->description, sig->magic_len, sig->literal_len);
+            return 1;
+        }
+        if (sig->type <= FILE_TYPE_UNKNOWN || sig->type >= FILE_TYPE_MAX) {
+            fprintf(stderr, "Error: Signature %zu (%s): invalid type %d\n", i, sig->description, (int)sig->type);
+            return 1;
+        }
+    }
+
+    FILE* out = fopen(argv[1], "w");
+    if (!out) {
+        fprintf(stderr, "Error: Cannot create %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "// 由 tools/gen_signature_dispatch.c 根据 src/signatures.def 生成，请勿手工修改\n");
+    fprintf(out, "#ifndef SIGNATURE_DISPATCH_H\n#define SIGNATURE_DISPATCH_H\n\n");
+
+    // 每个桶内保持定义顺序（同一位置匹配多个签名时靠前的签名优先，与自动机的报告顺序一致）
+    size_t start[257];
+    size_t total = 0;
+    fprintf(out, "// 首字节为 b 的候选签名: dispatch_entries[dispatch_start[b] .. dispatch_start[b + 1])，"
+                 "按定义顺序排列\n");
+    fprintf(out, "static const uint8_t dispatch_entries[] = {");
+    for (int b = 0; b < 256; b++) {
+        start[b] = total;
+        for (size_t i = 0; i < BUILTIN_COUNT; i++) {
+            if (in_bucket(&builtins[i], b)) {
+                fprintf(out, "%s%zu,", total % 16 == 0 ? "\n    " : " ", i);
+                total++;
+            }
+        }
+    }
+    start[256] = total;
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const uint16_t dispatch_start[257] = {");
+    for (int b = 0; b <= 256; b++) {
+        fprintf(out, "%s%zu,", b % 16 == 0 ? "\n    " : " ", start[b]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    // 每种类型取第一个签名的扩展名和描述
+    const char* extensions[FILE_TYPE_MAX] = { NULL };
+    const char* descriptions[FILE_TYPE_MAX] = { NULL };
+    for (size_t i = BUILTIN_COUNT; i > 0; i--) {
+        extensions[builtins[i - 1].type] = builtins[i - 1].extension;
+        descriptions[builtins[i - 1].type] = builtins[i - 1].description;
+    }
+
+    fprintf(out, "// 按类型编号索引的扩展名和描述（没有签名的类型为 NULL）\n");
+    fprintf(out, "static const char* const builtin_extensions[%d] = {\n", (int)FILE_TYPE_MAX);
+    for (int t = 0; t < FILE_TYPE_MAX; t++) {
+        fputs("    ", out);
+        write_string(out, extensions[t]);
+        fputs(",\n", out);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const char* const builtin_descriptions[%d] = {\n", (int)FILE_TYPE_MAX);
+    for (int t = 0; t < FILE_TYPE_MAX; t++) {
+        fputs("    ", out);
+        write_string(out, descriptions[t]);
+        fputs(",\n", out);
+    }
+    fprintf(out, "};\n\n#endif // SIGNATURE_DISPATCH_H\n");
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Error: Cannot write %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}